@@ -0,0 +1,220 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ast.h"
+#include "ast_reader.h"
+#include "symbol_table.h"
+#include "optimizer.h"
+
+// Driver isolado do otimizador.
+//
+// Lê o AST impresso pelo compilador (ast_print), roda uma lista de passes e
+// escreve o AST resultante no mesmo formato, sem passar pelo lexer, parser ou
+// análise semântica. Com -time=N cada passe roda N vezes sobre cópias da sua
+// entrada e o tempo médio é reportado; a saída continua sendo a de uma única
+// execução do pipeline.
+
+#define MAX_PASSES 64
+
+static char* read_input(const char *filename) {
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open file %s\n", filename);
+        return NULL;
+    }
+
+    size_t size = 0, capacity = 4096;
+    char *content = (char*)malloc(capacity);
+    size_t n;
+    while ((n = fread(content + size, 1, capacity - size - 1, file)) > 0) {
+        size += n;
+        if (capacity - size - 1 == 0) {
+            capacity *= 2;
+            content = (char*)realloc(content, capacity);
+        }
+    }
+    content[size] = '\0';
+
+    if (file != stdin) fclose(file);
+    return content;
+}
+
+// Primeiro número livre para opt_new_temp, depois dos temporários ("nome.N")
+// que já estão no AST lido
+static int next_temp_number(SymbolTable *table) {
+    int next = 0;
+    for (Symbol *symbol = table->symbols; symbol; symbol = symbol->next) {
+        const char *dot = strrchr(symbol->name, '.');
+        if (dot && dot[1]) {
+            int number = atoi(dot + 1);
+            if (number >= next) next = number + 1;
+        }
+    }
+    return next;
+}
+
+// Separa "-passes=a,b,c"; retorna o número de passes ou -1 se algum não existe
+static int parse_pass_list(const char *list, const OptPass **selected) {
+    char *copy = strdup(list);
+    int count = 0;
+    for (char *name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+        const OptPass *pass = optimizer_find_pass(name);
+        if (!pass) {
+            fprintf(stderr, "Error: Unknown pass '%s'\n", name);
+            free(copy);
+            return -1;
+        }
+        if (count == MAX_PASSES) {
+            fprintf(stderr, "Error: Too many passes (max %d)\n", MAX_PASSES);
+            free(copy);
+            return -1;
+        }
+        selected[count++] = pass;
+    }
+    free(copy);
+    return count;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Roda o passe 'runs' vezes, cada uma sobre uma cópia do programa com sua
+// própria tabela de símbolos; retorna o tempo médio em ms
+static double time_pass(const OptPass *pass, ASTNode *program, const OptimizerOptions *options, int runs) {
+    double total = 0;
+    for (int r = 0; r < runs; r++) {
+        ASTNode *copy = ast_clone(program);
+        SymbolTable *table = ast_rebuild_symbols(copy);
+
+        OptContext ctx;
+        ctx.symbol_table = table;
+        ctx.options = options;
+        ctx.temp_counter = next_temp_number(table);
+        ctx.changes = 0;
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pass->run(copy, &ctx);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed_ms(&start, &end);
+
+        symbol_table_free(table);
+        ast_free(copy);
+    }
+    return total / runs;
+}
+
+static void usage(const char *program) {
+    int count;
+    const OptPass *passes = optimizer_passes(&count);
+
+    printf("Usage: %s <ast_dump|-> [-o output_file] [-passes=<p1,p2,...>] [-O0|-O1|-O2]\n"
+           "       [-funroll=<n>] [-fpartial-eval[=<steps>]] [-time=<runs>]\n", program);
+    printf("\nReads the AST printed by ada_compiler (the first \"Program\" tree in the input),\n");
+    printf("runs the passes and prints the resulting AST in the same format.\n");
+    printf("Without -passes, runs the default pipeline for the -O level.\n");
+    printf("\nPasses:");
+    for (int i = 0; i < count; i++) {
+        printf(" %s", passes[i].name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *input_file = argv[1];
+    const char *output_file = NULL;
+    const char *pass_list = NULL;
+    int runs = 0;
+    OptimizerOptions opt_options;
+    optimizer_options_init(&opt_options);
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_file = argv[i + 1];
+            i++;
+        } else if (strncmp(argv[i], "-passes=", 8) == 0) {
+            pass_list = argv[i] + 8;
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            opt_options.level = atoi(argv[i] + 2);
+        } else if (strncmp(argv[i], "-funroll=", 9) == 0) {
+            opt_options.unroll_factor = atoi(argv[i] + 9);
+        } else if (strcmp(argv[i], "-fpartial-eval") == 0) {
+            opt_options.peval_budget = PEVAL_DEFAULT_BUDGET;
+        } else if (strncmp(argv[i], "-fpartial-eval=", 15) == 0) {
+            opt_options.peval_budget = atoll(argv[i] + 15);
+        } else if (strncmp(argv[i], "-time=", 6) == 0) {
+            runs = atoi(argv[i] + 6);
+            if (runs < 1) {
+                fprintf(stderr, "Error: -time needs a positive number of runs\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Passes escolhidos, ou o pipeline padrão do nível
+    const OptPass *selected[MAX_PASSES];
+    int selected_count = 0;
+    if (pass_list) {
+        selected_count = parse_pass_list(pass_list, selected);
+        if (selected_count < 0) return 1;
+    } else {
+        int count;
+        const OptPass *passes = optimizer_passes(&count);
+        for (int i = 0; i < count; i++) {
+            if (opt_options.level >= passes[i].min_level) selected[selected_count++] = &passes[i];
+        }
+    }
+
+    char *text = read_input(input_file);
+    if (!text) return 1;
+
+    ASTNode *program = ast_read_dump(text);
+    free(text);
+    if (!program) return 1;
+
+    SymbolTable *table = ast_rebuild_symbols(program);
+    OptContext ctx;
+    ctx.symbol_table = table;
+    ctx.options = &opt_options;
+    ctx.temp_counter = next_temp_number(table);
+
+    // O relatório vai para stderr; stdout fica só com o AST
+    for (int i = 0; i < selected_count; i++) {
+        double ms = runs > 0 ? time_pass(selected[i], program, &opt_options, runs) : 0;
+
+        ctx.changes = 0;
+        selected[i]->run(program, &ctx);
+
+        if (runs > 0) {
+            fprintf(stderr, "  %-10s %d change(s)  %10.4f ms/run (%d runs)\n",
+                    selected[i]->name, ctx.changes, ms, runs);
+        } else {
+            fprintf(stderr, "  %-10s %d change(s)\n", selected[i]->name, ctx.changes);
+        }
+    }
+
+    FILE *output = output_file ? fopen(output_file, "w") : stdout;
+    if (!output) {
+        fprintf(stderr, "Error: Could not open output file %s\n", output_file);
+        symbol_table_free(table);
+        ast_free(program);
+        return 1;
+    }
+    ast_fprint(output, program, 0);
+    if (output != stdout) fclose(output);
+
+    symbol_table_free(table);
+    ast_free(program);
+    optimizer_options_free(&opt_options);
+    return 0;
+}
@@ -22,6 +22,8 @@ ASTNode* ast_create_block(ASTNode **statements, int count) {
     node->type = AST_BLOCK;
     node->data.block.statements = statements;
     node->data.block.count = count;
+    node->data.block.profile_id = -1;
+    node->data.block.profile_count = -1;
     return node;
 }
 
@@ -70,6 +72,9 @@ ASTNode* ast_create_binary_op(const char *operator, ASTNode *left, ASTNode *righ
     node->data.binary_op.operator = strdup(operator);
     node->data.binary_op.left = left;
     node->data.binary_op.right = right;
+    node->data.binary_op.unchecked = 0;
+    node->data.binary_op.parenthesized = 0;
+    node->data.binary_op.range.known = 0;
     return node;
 }
 
@@ -92,6 +97,7 @@ ASTNode* ast_create_string(const char *value) {
     ASTNode *node = (ASTNode*)malloc(sizeof(ASTNode));
     node->type = AST_STRING;
     node->data.string.value = strdup(value);
+    node->data.string.label_id = -1;
     return node;
 }
 
@@ -99,6 +105,14 @@ ASTNode* ast_create_identifier(const char *name) {
     ASTNode *node = (ASTNode*)malloc(sizeof(ASTNode));
     node->type = AST_IDENTIFIER;
     node->data.identifier.name = strdup(name);
+    node->data.identifier.range.known = 0;
+    return node;
+}
+
+ASTNode* ast_create_profile_counter(int id) {
+    ASTNode *node = (ASTNode*)malloc(sizeof(ASTNode));
+    node->type = AST_PROFILE_COUNTER;
+    node->data.profile_counter.id = id;
     return node;
 }
 
@@ -160,87 +174,237 @@ void ast_free(ASTNode *node) {
     free(node);
 }
 
-static void print_indent(int indent) {
+static void print_indent(FILE *out, int indent) {
     for (int i = 0; i < indent; i++) {
-        printf("  ");
+        fprintf(out, "  ");
     }
 }
 
-void ast_print(ASTNode *node, int indent) {
+// Intervalo anotado pelo vrp, no fim da linha do nó
+static void print_range(FILE *out, const ValueRange *range) {
+    if (range->known) {
+        fprintf(out, " [%d..%d]", range->lo, range->hi);
+    }
+    fprintf(out, "\n");
+}
+
+void ast_fprint(FILE *out, ASTNode *node, int indent) {
     if (!node) {
-        print_indent(indent);
-        printf("(null)\n");
+        print_indent(out, indent);
+        fprintf(out, "(null)\n");
         return;
     }
 
-    print_indent(indent);
+    print_indent(out, indent);
 
     switch (node->type) {
         case AST_PROGRAM:
-            printf("Program\n");
-            ast_print(node->data.program.procedure, indent + 1);
+            fprintf(out, "Program\n");
+            ast_fprint(out, node->data.program.procedure, indent + 1);
             break;
         case AST_PROCEDURE:
-            printf("Procedure: %s\n", node->data.procedure.name);
-            ast_print(node->data.procedure.block, indent + 1);
+            fprintf(out, "Procedure: %s\n", node->data.procedure.name);
+            ast_fprint(out, node->data.procedure.block, indent + 1);
             break;
         case AST_BLOCK:
-            printf("Block (%d statements)\n", node->data.block.count);
+            fprintf(out, "Block (%d statements)", node->data.block.count);
+            if (node->data.block.profile_count >= 0) {
+                fprintf(out, " [profile #%d: %lld]", node->data.block.profile_id,
+                        node->data.block.profile_count);
+            }
+            fprintf(out, "\n");
             for (int i = 0; i < node->data.block.count; i++) {
-                ast_print(node->data.block.statements[i], indent + 1);
+                ast_fprint(out, node->data.block.statements[i], indent + 1);
             }
             break;
         case AST_ASSIGNMENT:
-            printf("Assignment: %s :=\n", node->data.assignment.identifier);
-            ast_print(node->data.assignment.expression, indent + 1);
+            fprintf(out, "Assignment: %s :=\n", node->data.assignment.identifier);
+            ast_fprint(out, node->data.assignment.expression, indent + 1);
             break;
         case AST_IF_STATEMENT:
-            printf("If\n");
-            print_indent(indent + 1);
-            printf("Condition:\n");
-            ast_print(node->data.if_stmt.condition, indent + 2);
-            print_indent(indent + 1);
-            printf("Then:\n");
-            ast_print(node->data.if_stmt.then_block, indent + 2);
+            fprintf(out, "If\n");
+            print_indent(out, indent + 1);
+            fprintf(out, "Condition:\n");
+            ast_fprint(out, node->data.if_stmt.condition, indent + 2);
+            print_indent(out, indent + 1);
+            fprintf(out, "Then:\n");
+            ast_fprint(out, node->data.if_stmt.then_block, indent + 2);
             if (node->data.if_stmt.else_block) {
-                print_indent(indent + 1);
-                printf("Else:\n");
-                ast_print(node->data.if_stmt.else_block, indent + 2);
+                print_indent(out, indent + 1);
+                fprintf(out, "Else:\n");
+                ast_fprint(out, node->data.if_stmt.else_block, indent + 2);
             }
             break;
         case AST_WHILE_STATEMENT:
-            printf("While\n");
-            print_indent(indent + 1);
-            printf("Condition:\n");
-            ast_print(node->data.while_stmt.condition, indent + 2);
-            print_indent(indent + 1);
-            printf("Body:\n");
-            ast_print(node->data.while_stmt.body, indent + 2);
+            fprintf(out, "While\n");
+            print_indent(out, indent + 1);
+            fprintf(out, "Condition:\n");
+            ast_fprint(out, node->data.while_stmt.condition, indent + 2);
+            print_indent(out, indent + 1);
+            fprintf(out, "Body:\n");
+            ast_fprint(out, node->data.while_stmt.body, indent + 2);
             break;
         case AST_PUT_LINE:
-            printf("Put_Line\n");
-            ast_print(node->data.put_line.expression, indent + 1);
+            fprintf(out, "Put_Line\n");
+            ast_fprint(out, node->data.put_line.expression, indent + 1);
             break;
         case AST_GET_LINE:
-            printf("Get_Line: %s\n", node->data.get_line.identifier);
+            fprintf(out, "Get_Line: %s\n", node->data.get_line.identifier);
             break;
         case AST_BINARY_OP:
-            printf("BinaryOp: %s\n", node->data.binary_op.operator);
-            ast_print(node->data.binary_op.left, indent + 1);
-            ast_print(node->data.binary_op.right, indent + 1);
+            fprintf(out, "BinaryOp: %s%s%s", node->data.binary_op.operator,
+                    node->data.binary_op.unchecked ? " (unchecked)" : "",
+                    node->data.binary_op.parenthesized ? " (parenthesized)" : "");
+            print_range(out, &node->data.binary_op.range);
+            ast_fprint(out, node->data.binary_op.left, indent + 1);
+            ast_fprint(out, node->data.binary_op.right, indent + 1);
             break;
         case AST_UNARY_OP:
-            printf("UnaryOp: %s\n", node->data.unary_op.operator);
-            ast_print(node->data.unary_op.operand, indent + 1);
+            fprintf(out, "UnaryOp: %s\n", node->data.unary_op.operator);
+            ast_fprint(out, node->data.unary_op.operand, indent + 1);
             break;
         case AST_INTEGER:
-            printf("Integer: %d\n", node->data.integer.value);
+            fprintf(out, "Integer: %d\n", node->data.integer.value);
             break;
         case AST_STRING:
-            printf("String: \"%s\"\n", node->data.string.value);
+            fprintf(out, "String: \"%s\"\n", node->data.string.value);
             break;
         case AST_IDENTIFIER:
-            printf("Identifier: %s\n", node->data.identifier.name);
+            fprintf(out, "Identifier: %s", node->data.identifier.name);
+            print_range(out, &node->data.identifier.range);
+            break;
+        case AST_PROFILE_COUNTER:
+            fprintf(out, "ProfileCounter: %d\n", node->data.profile_counter.id);
             break;
     }
-}
\ No newline at end of file
+}
+
+void ast_print(ASTNode *node, int indent) {
+    ast_fprint(stdout, node, indent);
+}
+
+ASTNode* ast_clone(ASTNode *node) {
+    if (!node) return NULL;
+
+    switch (node->type) {
+        case AST_PROGRAM:
+            return ast_create_program(ast_clone(node->data.program.procedure));
+        case AST_PROCEDURE:
+            return ast_create_procedure(node->data.procedure.name,
+                                        ast_clone(node->data.procedure.block));
+        case AST_BLOCK: {
+            int count = node->data.block.count;
+            ASTNode **statements = (ASTNode**)malloc((count > 0 ? count : 1) * sizeof(ASTNode*));
+            for (int i = 0; i < count; i++) {
+                statements[i] = ast_clone(node->data.block.statements[i]);
+            }
+            ASTNode *copy = ast_create_block(statements, count);
+            copy->data.block.profile_id = node->data.block.profile_id;
+            copy->data.block.profile_count = node->data.block.profile_count;
+            return copy;
+        }
+        case AST_ASSIGNMENT:
+            return ast_create_assignment(node->data.assignment.identifier,
+                                         ast_clone(node->data.assignment.expression));
+        case AST_IF_STATEMENT:
+            return ast_create_if(ast_clone(node->data.if_stmt.condition),
+                                 ast_clone(node->data.if_stmt.then_block),
+                                 ast_clone(node->data.if_stmt.else_block));
+        case AST_WHILE_STATEMENT:
+            return ast_create_while(ast_clone(node->data.while_stmt.condition),
+                                    ast_clone(node->data.while_stmt.body));
+        case AST_PUT_LINE:
+            return ast_create_put_line(ast_clone(node->data.put_line.expression));
+        case AST_GET_LINE:
+            return ast_create_get_line(node->data.get_line.identifier);
+        case AST_BINARY_OP: {
+            ASTNode *copy = ast_create_binary_op(node->data.binary_op.operator,
+                                                 ast_clone(node->data.binary_op.left),
+                                                 ast_clone(node->data.binary_op.right));
+            copy->data.binary_op.unchecked = node->data.binary_op.unchecked;
+            copy->data.binary_op.parenthesized = node->data.binary_op.parenthesized;
+            copy->data.binary_op.range = node->data.binary_op.range;
+            return copy;
+        }
+        case AST_UNARY_OP:
+            return ast_create_unary_op(node->data.unary_op.operator,
+                                       ast_clone(node->data.unary_op.operand));
+        case AST_INTEGER:
+            return ast_create_integer(node->data.integer.value);
+        case AST_STRING:
+            return ast_create_string(node->data.string.value);
+        case AST_IDENTIFIER: {
+            ASTNode *copy = ast_create_identifier(node->data.identifier.name);
+            copy->data.identifier.range = node->data.identifier.range;
+            return copy;
+        }
+        case AST_PROFILE_COUNTER:
+            return ast_create_profile_counter(node->data.profile_counter.id);
+    }
+
+    return NULL;
+}
+
+// Igualdade estrutural (usada para reconhecer expressões repetidas)
+int ast_equal(ASTNode *a, ASTNode *b) {
+    if (!a || !b) return a == b;
+    if (a->type != b->type) return 0;
+
+    switch (a->type) {
+        case AST_BINARY_OP:
+            return strcmp(a->data.binary_op.operator, b->data.binary_op.operator) == 0 &&
+                   a->data.binary_op.unchecked == b->data.binary_op.unchecked &&
+                   ast_equal(a->data.binary_op.left, b->data.binary_op.left) &&
+                   ast_equal(a->data.binary_op.right, b->data.binary_op.right);
+        case AST_UNARY_OP:
+            return strcmp(a->data.unary_op.operator, b->data.unary_op.operator) == 0 &&
+                   ast_equal(a->data.unary_op.operand, b->data.unary_op.operand);
+        case AST_INTEGER:
+            return a->data.integer.value == b->data.integer.value;
+        case AST_STRING:
+            return strcmp(a->data.string.value, b->data.string.value) == 0;
+        case AST_IDENTIFIER:
+            return strcmp(a->data.identifier.name, b->data.identifier.name) == 0;
+        default:
+            // Statements não são comparados
+            return 0;
+    }
+}
+
+void ast_block_insert(ASTNode *block, int index, ASTNode *stmt) {
+    int count = block->data.block.count;
+    block->data.block.statements = (ASTNode**)realloc(block->data.block.statements,
+                                                      (count + 1) * sizeof(ASTNode*));
+    memmove(&block->data.block.statements[index + 1],
+            &block->data.block.statements[index],
+            (count - index) * sizeof(ASTNode*));
+    block->data.block.statements[index] = stmt;
+    block->data.block.count = count + 1;
+}
+
+// Retira o statement do bloco sem liberá-lo
+ASTNode* ast_block_remove(ASTNode *block, int index) {
+    ASTNode *stmt = block->data.block.statements[index];
+    memmove(&block->data.block.statements[index],
+            &block->data.block.statements[index + 1],
+            (block->data.block.count - index - 1) * sizeof(ASTNode*));
+    block->data.block.count--;
+    return stmt;
+}
+
+int ast_block_index_of(ASTNode *block, ASTNode *stmt) {
+    for (int i = 0; i < block->data.block.count; i++) {
+        if (block->data.block.statements[i] == stmt) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Intervalo anotável do nó (NULL para nós sem intervalo)
+ValueRange* ast_range(ASTNode *node) {
+    if (!node) return NULL;
+    if (node->type == AST_BINARY_OP) return &node->data.binary_op.range;
+    if (node->type == AST_IDENTIFIER) return &node->data.identifier.range;
+    return NULL;
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 
 // AST, tipos de nós
 typedef enum {
@@ -18,9 +19,17 @@ typedef enum {
     AST_UNARY_OP,
     AST_INTEGER,
     AST_STRING,
-    AST_IDENTIFIER
+    AST_IDENTIFIER,
+    AST_PROFILE_COUNTER     // Contador de execução (-fprofile-generate)
 } ASTNodeType;
 
+// Intervalo de valores de uma expressão inteira (preenchido pelo passe vrp)
+typedef struct {
+    int known;
+    int lo;
+    int hi;
+} ValueRange;
+
 typedef struct ASTNode {
     ASTNodeType type;
     union {
@@ -39,6 +48,8 @@ typedef struct ASTNode {
         struct {
             struct ASTNode **statements;
             int count;
+            int profile_id;             // Bloco no perfil (-1 se criado pelo otimizador)
+            long long profile_count;    // Execuções medidas (-1 se desconhecido)
         } block;
 
         // Atribuição: identificador recebe expressão
@@ -75,6 +86,9 @@ typedef struct ASTNode {
             char *operator;
             struct ASTNode *left;
             struct ASTNode *right;
+            int unchecked;  // + e - sem verificação de overflow (gerados pelo otimizador)
+            int parenthesized;  // Escrita entre parênteses no fonte (limita a reassociação)
+            ValueRange range;
         } binary_op;
 
         // Operação unária
@@ -91,12 +105,19 @@ typedef struct ASTNode {
         // String literal
         struct {
             char *value;
+            int label_id;               // Entrada no pool de strings (-1 até a geração de código)
         } string;
 
         // Identificador
         struct {
             char *name;
+            ValueRange range;
         } identifier;
+
+        // Contador de perfil: incrementa a posição id do vetor de contadores
+        struct {
+            int id;
+        } profile_counter;
     } data;
 } ASTNode;
 
@@ -114,9 +135,19 @@ ASTNode* ast_create_unary_op(const char *operator, ASTNode *operand);
 ASTNode* ast_create_integer(int value);
 ASTNode* ast_create_string(const char *value);
 ASTNode* ast_create_identifier(const char *name);
+ASTNode* ast_create_profile_counter(int id);
 
 // Auxiliares
 void ast_free(ASTNode *node);
 void ast_print(ASTNode *node, int indent);
+void ast_fprint(FILE *out, ASTNode *node, int indent);
+
+// Manipulação usada pelos passes de otimização
+ASTNode* ast_clone(ASTNode *node);
+int ast_equal(ASTNode *a, ASTNode *b);
+void ast_block_insert(ASTNode *block, int index, ASTNode *stmt);
+ASTNode* ast_block_remove(ASTNode *block, int index);
+int ast_block_index_of(ASTNode *block, ASTNode *stmt);
+ValueRange* ast_range(ASTNode *node);
 
 #endif
\ No newline at end of file
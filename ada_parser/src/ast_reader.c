@@ -0,0 +1,331 @@
+#define _GNU_SOURCE
+#include "ast_reader.h"
+#include "optimizer.h"
+#include <stdio.h>
+#include <ctype.h>
+
+// Leitura do AST a partir do texto de ast_print.
+//
+// Cada nó ocupa uma linha, indentada com dois espaços por nível, e os filhos
+// vêm nas linhas seguintes com um nível a mais:
+//
+//     Program
+//       Procedure: Main
+//         Block (1 statements) [profile #0: 1]
+//           Assignment: x :=
+//             BinaryOp: + (unchecked) [0..10]
+//               Identifier: y [0..9]
+//               Integer: 1
+//
+// As anotações dos passes (unchecked, parenthesized, intervalos do vrp e
+// contagens de perfil) são lidas de volta, então o texto de saída de um passe
+// serve de entrada para o próximo. Linhas antes de "Program" são ignoradas,
+// o que permite usar a saída inteira do compilador.
+
+typedef struct {
+    char **lines;
+    int count;
+    int pos;
+    int error;
+} Reader;
+
+static void reader_error(Reader *rd, const char *message) {
+    if (!rd->error) {
+        fprintf(stderr, "Error: line %d: %s\n", rd->pos + 1, message);
+    }
+    rd->error = 1;
+}
+
+static int line_indent(const char *line) {
+    int spaces = 0;
+    while (line[spaces] == ' ') spaces++;
+    return spaces / 2;
+}
+
+// Conteúdo da linha atual se ela estiver no nível esperado
+static const char* expect_line(Reader *rd, int indent) {
+    if (rd->error) return NULL;
+    if (rd->pos >= rd->count) {
+        reader_error(rd, "unexpected end of input");
+        return NULL;
+    }
+    const char *line = rd->lines[rd->pos];
+    if (line_indent(line) != indent) {
+        reader_error(rd, "unexpected indentation");
+        return NULL;
+    }
+    return line + 2 * indent;
+}
+
+static int starts_with(const char *text, const char *prefix) {
+    return strncmp(text, prefix, strlen(prefix)) == 0;
+}
+
+// Lê " [lo..hi]" no fim da linha, se houver
+static void read_range(const char *text, ValueRange *range) {
+    const char *open = strrchr(text, '[');
+    int lo, hi;
+    if (open && sscanf(open, "[%d..%d]", &lo, &hi) == 2) {
+        range->known = 1;
+        range->lo = lo;
+        range->hi = hi;
+    }
+}
+
+// Primeira palavra depois do prefixo (nome de variável ou operador)
+static char* read_word(const char *text) {
+    while (*text == ' ') text++;
+    size_t length = 0;
+    while (text[length] && text[length] != ' ') length++;
+    return strndup(text, length);
+}
+
+static ASTNode* read_node(Reader *rd, int indent);
+
+// Lê um rótulo fixo ("Condition:", "Then:", ...) seguido do filho
+static ASTNode* read_labeled(Reader *rd, int indent, const char *label) {
+    const char *text = expect_line(rd, indent);
+    if (!text) return NULL;
+    if (strcmp(text, label) != 0) {
+        reader_error(rd, "unexpected node");
+        return NULL;
+    }
+    rd->pos++;
+    return read_node(rd, indent + 1);
+}
+
+static ASTNode* read_block(Reader *rd, int indent, const char *text) {
+    int expected;
+    if (sscanf(text, "Block (%d statements)", &expected) != 1) {
+        reader_error(rd, "malformed block");
+        return NULL;
+    }
+
+    int profile_id = -1;
+    long long profile_count = -1;
+    const char *profile = strstr(text, "[profile #");
+    if (profile && sscanf(profile, "[profile #%d: %lld]", &profile_id, &profile_count) != 2) {
+        reader_error(rd, "malformed profile annotation");
+        return NULL;
+    }
+    rd->pos++;
+
+    ASTNode *block = ast_create_block(NULL, 0);
+    block->data.block.profile_id = profile_id;
+    block->data.block.profile_count = profile_count;
+
+    while (!rd->error && rd->pos < rd->count && line_indent(rd->lines[rd->pos]) == indent + 1) {
+        ASTNode *stmt = read_node(rd, indent + 1);
+        if (stmt) ast_block_insert(block, block->data.block.count, stmt);
+    }
+    if (!rd->error && block->data.block.count != expected) {
+        reader_error(rd, "block statement count does not match");
+    }
+    return block;
+}
+
+static ASTNode* read_node(Reader *rd, int indent) {
+    const char *text = expect_line(rd, indent);
+    if (!text) return NULL;
+
+    if (strcmp(text, "(null)") == 0) {
+        rd->pos++;
+        return NULL;
+    }
+    if (starts_with(text, "Block (")) {
+        return read_block(rd, indent, text);
+    }
+
+    rd->pos++;
+
+    if (strcmp(text, "Program") == 0) {
+        return ast_create_program(read_node(rd, indent + 1));
+    }
+    if (starts_with(text, "Procedure: ")) {
+        char *name = read_word(text + 11);
+        ASTNode *node = ast_create_procedure(name, read_node(rd, indent + 1));
+        free(name);
+        return node;
+    }
+    if (starts_with(text, "Assignment: ")) {
+        char *name = read_word(text + 12);
+        ASTNode *node = ast_create_assignment(name, read_node(rd, indent + 1));
+        free(name);
+        return node;
+    }
+    if (strcmp(text, "If") == 0) {
+        ASTNode *condition = read_labeled(rd, indent + 1, "Condition:");
+        ASTNode *then_block = read_labeled(rd, indent + 1, "Then:");
+        ASTNode *else_block = NULL;
+        if (!rd->error && rd->pos < rd->count && line_indent(rd->lines[rd->pos]) == indent + 1 &&
+            strcmp(rd->lines[rd->pos] + 2 * (indent + 1), "Else:") == 0) {
+            else_block = read_labeled(rd, indent + 1, "Else:");
+        }
+        return ast_create_if(condition, then_block, else_block);
+    }
+    if (strcmp(text, "While") == 0) {
+        ASTNode *condition = read_labeled(rd, indent + 1, "Condition:");
+        ASTNode *body = read_labeled(rd, indent + 1, "Body:");
+        return ast_create_while(condition, body);
+    }
+    if (strcmp(text, "Put_Line") == 0) {
+        return ast_create_put_line(read_node(rd, indent + 1));
+    }
+    if (starts_with(text, "Get_Line: ")) {
+        char *name = read_word(text + 10);
+        ASTNode *node = ast_create_get_line(name);
+        free(name);
+        return node;
+    }
+    if (starts_with(text, "BinaryOp: ")) {
+        char *op = read_word(text + 10);
+        const char *flags = text + 10 + strlen(op);
+        ASTNode *left = read_node(rd, indent + 1);
+        ASTNode *right = read_node(rd, indent + 1);
+        ASTNode *node = ast_create_binary_op(op, left, right);
+        node->data.binary_op.unchecked = strstr(flags, "(unchecked)") != NULL;
+        node->data.binary_op.parenthesized = strstr(flags, "(parenthesized)") != NULL;
+        read_range(flags, &node->data.binary_op.range);
+        free(op);
+        return node;
+    }
+    if (starts_with(text, "UnaryOp: ")) {
+        char *op = read_word(text + 9);
+        ASTNode *node = ast_create_unary_op(op, read_node(rd, indent + 1));
+        free(op);
+        return node;
+    }
+    if (starts_with(text, "Integer: ")) {
+        return ast_create_integer(atoi(text + 9));
+    }
+    if (starts_with(text, "String: \"")) {
+        const char *start = text + 9;
+        const char *end = strrchr(start, '"');
+        if (!end) {
+            rd->pos--;
+            reader_error(rd, "unterminated string");
+            return NULL;
+        }
+        char *value = strndup(start, end - start);
+        ASTNode *node = ast_create_string(value);
+        free(value);
+        return node;
+    }
+    if (starts_with(text, "Identifier: ")) {
+        char *name = read_word(text + 12);
+        ASTNode *node = ast_create_identifier(name);
+        read_range(text + 12 + strlen(name), &node->data.identifier.range);
+        free(name);
+        return node;
+    }
+    if (starts_with(text, "ProfileCounter: ")) {
+        return ast_create_profile_counter(atoi(text + 16));
+    }
+
+    rd->pos--;
+    reader_error(rd, "unknown node");
+    return NULL;
+}
+
+ASTNode* ast_read_dump(const char *text) {
+    Reader rd;
+    rd.lines = NULL;
+    rd.count = 0;
+    rd.pos = 0;
+    rd.error = 0;
+
+    // Quebra em linhas, sem o '\n' (e '\r') final
+    char *copy = strdup(text);
+    int capacity = 0;
+    for (char *line = strtok(copy, "\n"); line; line = strtok(NULL, "\n")) {
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\r') line[length - 1] = '\0';
+        if (rd.count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            rd.lines = (char**)realloc(rd.lines, capacity * sizeof(char*));
+        }
+        rd.lines[rd.count++] = line;
+    }
+
+    while (rd.pos < rd.count && strcmp(rd.lines[rd.pos], "Program") != 0) {
+        rd.pos++;
+    }
+
+    ASTNode *program = NULL;
+    if (rd.pos >= rd.count) {
+        fprintf(stderr, "Error: no Program tree in input\n");
+    } else {
+        program = read_node(&rd, 0);
+        if (rd.error || !opt_procedure_block(program)) {
+            if (!rd.error) fprintf(stderr, "Error: Program has no procedure block\n");
+            ast_free(program);
+            program = NULL;
+        }
+    }
+
+    free(rd.lines);
+    free(copy);
+    return program;
+}
+
+// Tipo de uma expressão, como semantic_check_expression o infere
+static SymbolType expression_type(ASTNode *expr) {
+    if (!expr) return SYMBOL_UNKNOWN;
+    switch (expr->type) {
+        case AST_INTEGER:
+            return SYMBOL_INTEGER;
+        case AST_STRING:
+            return SYMBOL_STRING;
+        case AST_UNARY_OP:
+            return opt_op_is(expr->data.unary_op.operator, "not") ? SYMBOL_BOOLEAN : SYMBOL_INTEGER;
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            const char *logical[] = { "=", "/=", "<", "<=", ">", ">=", "and", "or" };
+            for (size_t i = 0; i < sizeof(logical) / sizeof(logical[0]); i++) {
+                if (opt_op_is(op, logical[i])) return SYMBOL_BOOLEAN;
+            }
+            return SYMBOL_INTEGER;
+        }
+        default:
+            return SYMBOL_UNKNOWN;
+    }
+}
+
+static void collect_symbols(ASTNode *node, SymbolTable *table) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < node->data.block.count; i++) {
+                collect_symbols(node->data.block.statements[i], table);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            if (!symbol_table_lookup(table, node->data.assignment.identifier)) {
+                SymbolType type = expression_type(node->data.assignment.expression);
+                symbol_table_insert(table, node->data.assignment.identifier,
+                                    type != SYMBOL_UNKNOWN ? type : SYMBOL_INTEGER);
+            }
+            break;
+        case AST_GET_LINE:
+            if (!symbol_table_lookup(table, node->data.get_line.identifier)) {
+                symbol_table_insert(table, node->data.get_line.identifier, SYMBOL_INTEGER);
+            }
+            break;
+        case AST_IF_STATEMENT:
+            collect_symbols(node->data.if_stmt.then_block, table);
+            collect_symbols(node->data.if_stmt.else_block, table);
+            break;
+        case AST_WHILE_STATEMENT:
+            collect_symbols(node->data.while_stmt.body, table);
+            break;
+        default:
+            break;
+    }
+}
+
+SymbolTable* ast_rebuild_symbols(ASTNode *program) {
+    SymbolTable *table = symbol_table_create(NULL);
+    collect_symbols(opt_procedure_block(program), table);
+    return table;
+}
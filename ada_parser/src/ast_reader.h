@@ -0,0 +1,15 @@
+#ifndef AST_READER_H
+#define AST_READER_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Lê o AST no formato impresso por ast_print (a primeira árvore "Program" do
+// texto). Retorna NULL e reporta a linha em stderr se o texto for inválido.
+ASTNode* ast_read_dump(const char *text);
+
+// Reconstrói o escopo do procedimento a partir das atribuições e Get_Line,
+// como a análise semântica faria
+SymbolTable* ast_rebuild_symbols(ASTNode *program);
+
+#endif
@@ -6,6 +6,7 @@
 #include "semantic.h"
 #include "symbol_table.h"
 #include "mips_codegen.h"
+#include "optimizer.h"
 
 char* read_file(const char *filename) {
     FILE *file = fopen(filename, "r");
@@ -28,7 +29,9 @@ char* read_file(const char *filename) {
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        printf("Usage: %s <ada_file> [-o output_file]\n", argv[0]);
+        printf("Usage: %s <ada_file> [-o output_file] [-O0|-O1|-O2] [-funroll=<n>] [-fpartial-eval[=<steps>]]\n"
+               "       [-fprofile-generate|-fprofile-use=<file>] [-fsuperopt[=<cache>]]\n"
+               "       [-fdelayed-branch]\n", argv[0]);
         printf("\nExample Ada program:\n");
         printf("procedure Main is\n");
         printf("begin\n");
@@ -46,11 +49,33 @@ int main(int argc, char *argv[]) {
     // Parse command line arguments
     const char *input_file = argv[1];
     const char *output_file = "output.asm";
+    OptimizerOptions opt_options;
+    optimizer_options_init(&opt_options);
     
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             output_file = argv[i + 1];
             i++;
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            opt_options.level = atoi(argv[i] + 2);
+        } else if (strncmp(argv[i], "-funroll=", 9) == 0) {
+            opt_options.unroll_factor = atoi(argv[i] + 9);
+        } else if (strcmp(argv[i], "-fpartial-eval") == 0) {
+            opt_options.peval_budget = PEVAL_DEFAULT_BUDGET;
+        } else if (strncmp(argv[i], "-fpartial-eval=", 15) == 0) {
+            opt_options.peval_budget = atoll(argv[i] + 15);
+        } else if (strcmp(argv[i], "-fprofile-generate") == 0) {
+            opt_options.profile_generate = 1;
+        } else if (strncmp(argv[i], "-fprofile-use=", 14) == 0) {
+            if (!optimizer_load_profile(&opt_options, argv[i] + 14)) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-fsuperopt") == 0) {
+            opt_options.superopt_cache = SUPEROPT_DEFAULT_CACHE;
+        } else if (strncmp(argv[i], "-fsuperopt=", 11) == 0) {
+            opt_options.superopt_cache = argv[i] + 11;
+        } else if (strcmp(argv[i], "-fdelayed-branch") == 0) {
+            opt_options.delayed_branch = 1;
         }
     }
 
@@ -102,7 +127,20 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // 4. MIPS Code Generation
+    // 4. Optimization
+    if (opt_options.profile_generate || opt_options.profile_counts) {
+        optimizer_prepare_profile(ast, &opt_options);
+    }
+
+    if (opt_options.level > 0) {
+        printf("\n=== Optimization (-O%d) ===\n", opt_options.level);
+        optimizer_run(ast, semantic_ctx->current_scope, &opt_options);
+
+        printf("\n=== Optimized AST ===\n");
+        ast_print(ast, 0);
+    }
+
+    // 5. MIPS Code Generation
     printf("\n=== MIPS Code Generation ===\n");
     FILE *output = fopen(output_file, "w");
     if (!output) {
@@ -115,9 +153,21 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    MIPSCodeGen *codegen = mips_codegen_create(output, semantic_ctx->current_scope);
-    mips_codegen_generate(codegen, ast);
+    MIPSCodeGen *codegen = mips_codegen_create(output, semantic_ctx->current_scope, &opt_options);
+    int generated = mips_codegen_generate(codegen, ast);
     fclose(output);
+    if (!generated) {
+        fprintf(stderr, "\nCompilation failed during code generation\n");
+        remove(output_file);
+        mips_codegen_free(codegen);
+        semantic_context_free(semantic_ctx);
+        ast_free(ast);
+        parser_free(parser);
+        lexer_free(lexer);
+        free(source);
+        optimizer_options_free(&opt_options);
+        return 1;
+    }
     
     printf("Compilation successful! Output written to: %s\n", output_file);
     printf("\nTo run the generated code:\n");
@@ -132,6 +182,7 @@ int main(int argc, char *argv[]) {
     parser_free(parser);
     lexer_free(lexer);
     free(source);
+    optimizer_options_free(&opt_options);
 
     return 0;
 }
\ No newline at end of file
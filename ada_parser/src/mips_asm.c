@@ -0,0 +1,323 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Desvios condicionais emitidos pelo gerador e seus opostos
+static const char *branch_pairs[][2] = {
+    { "beqz", "bnez" },
+    { "bnez", "beqz" },
+    { "beq",  "bne"  },
+    { "bne",  "beq"  },
+    { "bltz", "bgez" },
+    { "bgez", "bltz" },
+    { "blez", "bgtz" },
+    { "bgtz", "blez" },
+};
+
+#define BRANCH_PAIR_COUNT (int)(sizeof(branch_pairs) / sizeof(branch_pairs[0]))
+
+static void copy_field(char *dst, const char *src, size_t len, size_t size) {
+    if (len >= size) len = size - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static void parse_line(AsmLine *line) {
+    const char *p = line->text;
+
+    line->label[0] = '\0';
+    line->op[0] = '\0';
+    line->arg_count = 0;
+
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '\0' || *p == '#' || *p == '.') return;
+
+    // Rótulo: "nome:" sozinho na linha
+    const char *colon = strchr(p, ':');
+    if (colon && !strchr(p, ' ') && colon[1] == '\0') {
+        copy_field(line->label, p, colon - p, sizeof(line->label));
+        return;
+    }
+
+    const char *start = p;
+    while (*p && !isspace((unsigned char)*p)) p++;
+    copy_field(line->op, start, p - start, sizeof(line->op));
+
+    // Operandos separados por vírgula, até um comentário
+    while (*p && *p != '#' && line->arg_count < ASM_MAX_ARGS) {
+        while (isspace((unsigned char)*p) || *p == ',') p++;
+        if (!*p || *p == '#') break;
+        start = p;
+        while (*p && *p != ',' && *p != '#') p++;
+        const char *end = p;
+        while (end > start && isspace((unsigned char)end[-1])) end--;
+        copy_field(line->args[line->arg_count++], start, end - start, ASM_ARG_SIZE);
+    }
+}
+
+static void push_line(AsmBuffer *buf, const char *text, size_t len) {
+    if (buf->count >= buf->capacity) {
+        buf->capacity = buf->capacity ? buf->capacity * 2 : 256;
+        buf->lines = (AsmLine*)realloc(buf->lines, buf->capacity * sizeof(AsmLine));
+    }
+    AsmLine *line = &buf->lines[buf->count++];
+    line->text = strndup(text, len);
+    parse_line(line);
+}
+
+AsmBuffer* asm_buffer_parse(const char *text, size_t size) {
+    AsmBuffer *buf = (AsmBuffer*)malloc(sizeof(AsmBuffer));
+    buf->lines = NULL;
+    buf->count = 0;
+    buf->capacity = 0;
+
+    size_t start = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] == '\n') {
+            push_line(buf, text + start, i - start);
+            start = i + 1;
+        }
+    }
+    if (start < size) {
+        push_line(buf, text + start, size - start);
+    }
+    return buf;
+}
+
+void asm_buffer_write(AsmBuffer *buf, FILE *output) {
+    for (int i = 0; i < buf->count; i++) {
+        fprintf(output, "%s\n", buf->lines[i].text);
+    }
+}
+
+void asm_buffer_free(AsmBuffer *buf) {
+    if (!buf) return;
+    for (int i = 0; i < buf->count; i++) {
+        free(buf->lines[i].text);
+    }
+    free(buf->lines);
+    free(buf);
+}
+
+void asm_buffer_insert(AsmBuffer *buf, int index, const char *text) {
+    push_line(buf, text, strlen(text));
+    AsmLine line = buf->lines[buf->count - 1];
+    memmove(&buf->lines[index + 1], &buf->lines[index],
+            (buf->count - 1 - index) * sizeof(AsmLine));
+    buf->lines[index] = line;
+}
+
+void asm_buffer_remove(AsmBuffer *buf, int index) {
+    free(buf->lines[index].text);
+    memmove(&buf->lines[index], &buf->lines[index + 1],
+            (buf->count - index - 1) * sizeof(AsmLine));
+    buf->count--;
+}
+
+int asm_is_instruction(const AsmLine *line) {
+    return line->op[0] != '\0';
+}
+
+int asm_is_jump(const AsmLine *line) {
+    return strcmp(line->op, "j") == 0 && line->arg_count == 1;
+}
+
+int asm_is_branch(const AsmLine *line) {
+    if (asm_is_jump(line)) return 1;
+    return asm_inverted_branch(line->op) != NULL && line->arg_count > 0;
+}
+
+const char* asm_branch_target(const AsmLine *line) {
+    return line->args[line->arg_count - 1];
+}
+
+const char* asm_inverted_branch(const char *op) {
+    for (int i = 0; i < BRANCH_PAIR_COUNT; i++) {
+        if (strcmp(branch_pairs[i][0], op) == 0) return branch_pairs[i][1];
+    }
+    return NULL;
+}
+
+int asm_operand_role(const AsmLine *line, int index) {
+    const char *arg = line->args[index];
+    if (strchr(arg, '(')) return ASM_USE;
+    if (arg[0] != '$' && arg[0] != '%') return 0;
+
+    // Só leem: desvios, sw, mult e div de dois operandos
+    if (asm_is_branch(line) || strcmp(line->op, "sw") == 0 ||
+        strcmp(line->op, "mult") == 0 || strcmp(line->op, "multu") == 0 ||
+        strcmp(line->op, "teq") == 0 || strcmp(line->op, "mthi") == 0 || strcmp(line->op, "mtlo") == 0 ||
+        (strcmp(line->op, "div") == 0 && line->arg_count == 2)) {
+        return ASM_USE;
+    }
+    if (index > 0) return ASM_USE;
+
+    // movn/movz só escrevem quando a condição vale: o valor antigo é lido
+    if (strcmp(line->op, "movn") == 0 || strcmp(line->op, "movz") == 0) {
+        return ASM_USE | ASM_DEF;
+    }
+    return ASM_DEF;
+}
+
+void asm_set_instruction(AsmLine *line, const char *op, int arg_count, const char *args[]) {
+    char text[16 + ASM_MAX_ARGS * (ASM_ARG_SIZE + 2)];
+    int len = snprintf(text, sizeof(text), "    %s", op);
+
+    for (int i = 0; i < arg_count; i++) {
+        len += snprintf(text + len, sizeof(text) - len, "%s%s", i ? ", " : " ", args[i]);
+    }
+
+    free(line->text);
+    line->text = strdup(text);
+    parse_line(line);
+}
+
+void asm_set_branch_target(AsmLine *line, const char *label) {
+    const char *args[ASM_MAX_ARGS];
+    char op[sizeof(line->op)];
+    char copy[ASM_MAX_ARGS][ASM_ARG_SIZE];
+    int count = line->arg_count;
+
+    strcpy(op, line->op);
+    for (int i = 0; i < count; i++) {
+        strcpy(copy[i], i == count - 1 ? label : line->args[i]);
+        args[i] = copy[i];
+    }
+    asm_set_instruction(line, op, count, args);
+}
+
+// Registradores lidos pelos syscalls usados: $v0 (serviço) e $a0 (argumento)
+const char *const asm_syscall_uses[] = { "$v0", "$a0", NULL };
+
+int asm_operand_reads(const AsmLine *line, int index, const char *reg) {
+    const char *arg = line->args[index];
+    const char *paren = strchr(arg, '(');
+    if (paren) {
+        size_t len = strlen(reg);
+        return strncmp(paren + 1, reg, len) == 0 && paren[1 + len] == ')';
+    }
+    return strcmp(arg, reg) == 0 && (asm_operand_role(line, index) & ASM_USE);
+}
+
+int asm_reads_reg(const AsmLine *line, const char *reg) {
+    if (strcmp(line->op, "syscall") == 0) {
+        for (int i = 0; asm_syscall_uses[i]; i++) {
+            if (strcmp(asm_syscall_uses[i], reg) == 0) return 1;
+        }
+        return 0;
+    }
+    for (int k = 0; k < line->arg_count; k++) {
+        if (asm_operand_reads(line, k, reg)) return 1;
+    }
+    return 0;
+}
+
+int asm_writes_reg(const AsmLine *line, const char *reg) {
+    return line->arg_count > 0 && strcmp(line->args[0], reg) == 0 &&
+           asm_operand_role(line, 0) == ASM_DEF;
+}
+
+AsmLine* asm_next_instruction(AsmBuffer *buf, int from, int *index) {
+    for (int i = from; i < buf->count; i++) {
+        if (asm_is_instruction(&buf->lines[i])) {
+            if (index) *index = i;
+            return &buf->lines[i];
+        }
+    }
+    return NULL;
+}
+
+int asm_find_label(AsmBuffer *buf, const char *label) {
+    for (int i = 0; i < buf->count; i++) {
+        if (strcmp(buf->lines[i].label, label) == 0) return i;
+    }
+    return -1;
+}
+
+int asm_max_label_number(AsmBuffer *buf) {
+    int max = -1;
+    for (int i = 0; i < buf->count; i++) {
+        const char *name = buf->lines[i].label;
+        if (name[0] != 'L' || !isdigit((unsigned char)name[1])) continue;
+        char *end;
+        long value = strtol(name + 1, &end, 10);
+        if (*end == '\0' && value > max) max = (int)value;
+    }
+    return max;
+}
+
+// Segue o fluxo a partir das linhas starts[] até uma leitura (vivo) ou uma
+// escrita do registrador em todos os caminhos (morto). Com 'delayed', a
+// instrução depois de um desvio é o seu delay slot e executa nos dois caminhos
+static int live_from(AsmBuffer *buf, const int *starts, int start_count, const char *reg, int delayed) {
+    if (strcmp(reg, "$zero") == 0) return 0;
+
+    int *stack = (int*)malloc((ASM_LIVE_BUDGET + 2) * 2 * sizeof(int));
+    char *seen = (char*)calloc(buf->count + 1, 1);
+    int top = 0, visited = 0, live = 0;
+    for (int s = 0; s < start_count; s++) {
+        if (starts[s] < 0) live = 1;
+        else stack[top++] = starts[s];
+    }
+
+    while (top > 0 && !live) {
+        int i = stack[--top];
+        if (i >= buf->count || seen[i]) continue;
+        if (++visited > ASM_LIVE_BUDGET) {
+            live = 1;
+            break;
+        }
+        seen[i] = 1;
+
+        AsmLine *line = &buf->lines[i];
+        if (!asm_is_instruction(line)) {
+            stack[top++] = i + 1;
+            continue;
+        }
+        if (asm_reads_reg(line, reg)) {
+            live = 1;
+        } else if (asm_writes_reg(line, reg)) {
+            continue;
+        } else if (!asm_is_branch(line)) {
+            stack[top++] = i + 1;
+        } else {
+            int next = i + 1;
+            if (delayed) {
+                int slot;
+                AsmLine *slot_line = asm_next_instruction(buf, i + 1, &slot);
+                if (!slot_line || asm_reads_reg(slot_line, reg)) {
+                    live = 1;
+                    break;
+                }
+                if (asm_writes_reg(slot_line, reg)) continue;
+                next = slot + 1;
+            }
+            int target = asm_find_label(buf, asm_branch_target(line));
+            if (target < 0) {
+                live = 1;
+                break;
+            }
+            if (!asm_is_jump(line)) stack[top++] = next;
+            stack[top++] = target;
+        }
+    }
+
+    free(seen);
+    free(stack);
+    return live;
+}
+
+int asm_live_at(AsmBuffer *buf, int from, const char *reg, int delayed) {
+    return live_from(buf, &from, 1, reg, delayed);
+}
+
+int asm_live_after(AsmBuffer *buf, int from, const char *reg) {
+    const AsmLine *line = &buf->lines[from];
+    int starts[2];
+    int count = 0;
+    if (!asm_is_jump(line)) starts[count++] = from + 1;
+    if (asm_is_branch(line)) starts[count++] = asm_find_label(buf, asm_branch_target(line));
+    return live_from(buf, starts, count, reg, 0);
+}
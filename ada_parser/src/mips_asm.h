@@ -0,0 +1,100 @@
+#ifndef MIPS_ASM_H
+#define MIPS_ASM_H
+
+#include <stdio.h>
+
+// Representação do segmento de texto já gerado, linha a linha, para os
+// passes que trabalham sobre as instruções (depois da geração de código)
+
+#define ASM_MAX_ARGS 3
+#define ASM_ARG_SIZE 48
+
+typedef struct {
+    char *text;                             // Linha emitida (sem '\n')
+    char label[ASM_ARG_SIZE];               // Rótulo definido na linha ("" se não há)
+    char op[16];                            // Mnemônico ("" em rótulos, comentários e linhas vazias)
+    char args[ASM_MAX_ARGS][ASM_ARG_SIZE];
+    int arg_count;
+} AsmLine;
+
+typedef struct {
+    AsmLine *lines;
+    int count;
+    int capacity;
+} AsmBuffer;
+
+// Protótipos das funções
+AsmBuffer* asm_buffer_parse(const char *text, size_t size);
+void asm_buffer_write(AsmBuffer *buf, FILE *output);
+void asm_buffer_free(AsmBuffer *buf);
+void asm_buffer_insert(AsmBuffer *buf, int index, const char *text);
+void asm_buffer_remove(AsmBuffer *buf, int index);
+
+// Consultas e edição de uma linha
+int asm_is_instruction(const AsmLine *line);
+int asm_is_branch(const AsmLine *line);         // Desvio condicional ou j
+int asm_is_jump(const AsmLine *line);           // j (incondicional)
+const char* asm_branch_target(const AsmLine *line);
+void asm_set_branch_target(AsmLine *line, const char *label);
+void asm_set_instruction(AsmLine *line, const char *op, int arg_count, const char *args[]);
+const char* asm_inverted_branch(const char *op);
+
+// Papel de um operando na instrução (combinação de ASM_USE e ASM_DEF; 0 para
+// rótulos e imediatos). Em "off($r)" o registrador base é sempre lido
+#define ASM_USE 1
+#define ASM_DEF 2
+int asm_operand_role(const AsmLine *line, int index);
+
+// Leituras e escritas de registradores. Os syscalls leem asm_syscall_uses;
+// asm_writes_reg só conta escritas incondicionais (movn/movz não contam)
+extern const char *const asm_syscall_uses[];
+int asm_operand_reads(const AsmLine *line, int index, const char *reg);
+int asm_reads_reg(const AsmLine *line, const char *reg);
+int asm_writes_reg(const AsmLine *line, const char *reg);
+
+// Rótulos e fluxo
+AsmLine* asm_next_instruction(AsmBuffer *buf, int from, int *index);
+int asm_find_label(AsmBuffer *buf, const char *label);      // -1 se não existe
+int asm_max_label_number(AsmBuffer *buf);                   // Maior n de um rótulo Ln (-1 se nenhum)
+
+// O registrador pode ser lido a partir da linha 'from' (asm_live_at) ou
+// depois dela (asm_live_after, sem delay slots)? Com 'delayed', a instrução
+// depois de um desvio executa nos dois caminhos. Depois de ASM_LIVE_BUDGET
+// linhas visitadas a resposta é "vivo"
+#define ASM_LIVE_BUDGET 256
+int asm_live_at(AsmBuffer *buf, int from, const char *reg, int delayed);
+int asm_live_after(AsmBuffer *buf, int from, const char *reg);
+
+// Resultado de mips_superoptimize
+typedef struct {
+    int rewrites;       // Trechos substituídos
+    int hits;           // Trechos resolvidos pelo cache
+    int searches;       // Trechos procurados (e gravados no cache)
+    int skipped;        // Trechos não procurados: o orçamento da compilação acabou
+} SuperoptStats;
+
+// Resultado de mips_peephole (instruções removidas por regra)
+#define PEEPHOLE_MAX_RULES 16
+typedef struct {
+    const char *names[PEEPHOLE_MAX_RULES];
+    int removed[PEEPHOLE_MAX_RULES];
+    int count;
+} PeepholeStats;
+
+// Resultado de mips_schedule
+typedef struct {
+    int branches;       // Desvios com delay slot
+    int filled;         // Delay slots com uma instrução útil
+    int load_stalls;    // nops que ficaram entre um lw e o uso
+    int cycles_before;  // Custo estático no modelo do pipeline (modo reorder)
+    int cycles_after;   // O mesmo com o código escalonado
+} ScheduleStats;
+
+// Passes
+int mips_thread_jumps(AsmBuffer *buf);
+int mips_merge_tails(AsmBuffer *buf);
+int mips_superoptimize(AsmBuffer *buf, const char *cache_path, SuperoptStats *stats);
+int mips_peephole(AsmBuffer *buf, PeepholeStats *stats);
+int mips_schedule(AsmBuffer *buf, ScheduleStats *stats);
+
+#endif
@@ -1,15 +1,35 @@
 #define _GNU_SOURCE
 #include "mips_codegen.h"
+#include "mips_asm.h"
 #include <stdarg.h>
 #include <string.h>
 
-MIPSCodeGen* mips_codegen_create(FILE *output, SymbolTable *table) {
+MIPSCodeGen* mips_codegen_create(FILE *output, SymbolTable *table, const OptimizerOptions *options) {
     MIPSCodeGen *gen = (MIPSCodeGen*)malloc(sizeof(MIPSCodeGen));
     gen->output = output;
     gen->symbol_table = table;
     gen->reg_alloc = reg_alloc_create();
+    if (options->level > 0) {
+        // Registradores virtuais, mapeados para $t0-$t9 por reg_alloc_assign
+        reg_alloc_set_virtual(gen->reg_alloc);
+    }
+    gen->options = options;
     gen->label_counter = 0;
-    gen->string_counter = 0;
+    gen->strings = string_pool_create();
+    gen->cold = NULL;
+    gen->cold_buffer = NULL;
+    gen->cold_size = 0;
+    gen->block_count = -1;
+    gen->frame_image = NULL;
+    gen->frame_words = 0;
+    gen->static_inits = NULL;
+    gen->static_init_count = 0;
+    gen->var_regs = NULL;
+    gen->zero_init_count = 0;
+    gen->target = NULL;
+    if (options->profile_counts) {
+        gen->cold = open_memstream(&gen->cold_buffer, &gen->cold_size);
+    }
     return gen;
 }
 
@@ -18,6 +38,14 @@ void mips_codegen_free(MIPSCodeGen *gen) {
     if (gen->reg_alloc) {
         reg_alloc_free(gen->reg_alloc);
     }
+    if (gen->cold) {
+        fclose(gen->cold);
+    }
+    free(gen->cold_buffer);
+    free(gen->frame_image);
+    free(gen->static_inits);
+    free(gen->var_regs);
+    string_pool_free(gen->strings);
     free(gen);
 }
 
@@ -40,27 +68,14 @@ const char* mips_new_label(MIPSCodeGen *gen) {
     return labels[current];
 }
 
-const char* mips_new_string_label(MIPSCodeGen *gen) {
-    static char labels[100][32];
-    static int buffer_index = 0;
-    
-    int current = buffer_index;
-    buffer_index = (buffer_index + 1) % 100;
-    
-    snprintf(labels[current], sizeof(labels[current]), "str%d", gen->string_counter++);
-    return labels[current];
-}
-
-// Coleta todas as strings literais do AST
+// Coloca todas as strings literais do AST no pool e guarda o id de cada uma
 void collect_strings(ASTNode *node, MIPSCodeGen *gen) {
     if (!node) return;
     
     switch (node->type) {
-        case AST_STRING: {
-            const char *label = mips_new_string_label(gen);
-            mips_emit(gen, "%s: .asciiz \"%s\"\n", label, node->data.string.value);
+        case AST_STRING:
+            node->data.string.label_id = string_pool_add(gen->strings, node->data.string.value);
             break;
-        }
         case AST_PROGRAM:
             collect_strings(node->data.program.procedure, gen);
             break;
@@ -85,7 +100,10 @@ void collect_strings(ASTNode *node, MIPSCodeGen *gen) {
             collect_strings(node->data.while_stmt.body, gen);
             break;
         case AST_PUT_LINE:
-            collect_strings(node->data.put_line.expression, gen);
+            // Com otimização, o texto dos Put_Line vai para os rótulos outN
+            if (gen->options->level == 0) {
+                collect_strings(node->data.put_line.expression, gen);
+            }
             break;
         case AST_BINARY_OP:
             collect_strings(node->data.binary_op.left, gen);
@@ -99,15 +117,469 @@ void collect_strings(ASTNode *node, MIPSCodeGen *gen) {
     }
 }
 
-void mips_emit_data_section(MIPSCodeGen *gen, ASTNode *ast) {
-    mips_emit(gen, ".data\n");
-    
-    // Coletar e emitir strings literais
-    gen->string_counter = 0;  // Reset counter
+// Promoção de variáveis para registradores (-O1 e acima).
+//
+// O programa é um único procedimento sem chamadas, então $s0-$s7 e os
+// registradores que as syscalls usadas não tocam ($v1, $a1-$a3) ficam livres
+// do começo ao fim. As variáveis Integer/Boolean mais usadas moram neles
+// durante todo o programa; cada leitura ou escrita pesa 8^p, com p a
+// profundidade de laços em que aparece, então as variáveis dos laços
+// internos ganham os registradores. Leituras usam o próprio registrador e
+// escritas vão direto para ele, sem lw/sw; o resto continua no frame.
+
+static const char *promotion_registers[MIPS_PROMOTED_MAX] = {
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7", "$v1", "$a1", "$a2", "$a3"
+};
+
+#define PROMOTION_LOOP_WEIGHT 8
+#define PROMOTION_MAX_DEPTH 6
+
+// Slot do frame da variável se ela pode ser promovida, -1 caso contrário
+static int promotable_slot(MIPSCodeGen *gen, const char *name) {
+    Symbol *symbol = symbol_table_lookup(gen->symbol_table, name);
+    if (!symbol || (symbol->type != SYMBOL_INTEGER && symbol->type != SYMBOL_BOOLEAN)) return -1;
+    return symbol->offset / 4;
+}
+
+static void count_uses(MIPSCodeGen *gen, ASTNode *node, int depth, long long *uses) {
+    if (!node) return;
+
+    long long weight = 1;
+    for (int i = 0; i < depth && i < PROMOTION_MAX_DEPTH; i++) weight *= PROMOTION_LOOP_WEIGHT;
+
+    int slot;
+    switch (node->type) {
+        case AST_PROGRAM:
+            count_uses(gen, node->data.program.procedure, depth, uses);
+            break;
+        case AST_PROCEDURE:
+            count_uses(gen, node->data.procedure.block, depth, uses);
+            break;
+        case AST_BLOCK:
+            for (int i = 0; i < node->data.block.count; i++) {
+                count_uses(gen, node->data.block.statements[i], depth, uses);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            slot = promotable_slot(gen, node->data.assignment.identifier);
+            if (slot >= 0) uses[slot] += weight;
+            count_uses(gen, node->data.assignment.expression, depth, uses);
+            break;
+        case AST_GET_LINE:
+            slot = promotable_slot(gen, node->data.get_line.identifier);
+            if (slot >= 0) uses[slot] += weight;
+            break;
+        case AST_IDENTIFIER:
+            slot = promotable_slot(gen, node->data.identifier.name);
+            if (slot >= 0) uses[slot] += weight;
+            break;
+        case AST_IF_STATEMENT:
+            count_uses(gen, node->data.if_stmt.condition, depth, uses);
+            count_uses(gen, node->data.if_stmt.then_block, depth, uses);
+            count_uses(gen, node->data.if_stmt.else_block, depth, uses);
+            break;
+        case AST_WHILE_STATEMENT:
+            // A condição roda uma vez a mais que o corpo
+            count_uses(gen, node->data.while_stmt.condition, depth + 1, uses);
+            count_uses(gen, node->data.while_stmt.body, depth + 1, uses);
+            break;
+        case AST_PUT_LINE:
+            count_uses(gen, node->data.put_line.expression, depth, uses);
+            break;
+        case AST_BINARY_OP:
+            count_uses(gen, node->data.binary_op.left, depth, uses);
+            count_uses(gen, node->data.binary_op.right, depth, uses);
+            break;
+        case AST_UNARY_OP:
+            count_uses(gen, node->data.unary_op.operand, depth, uses);
+            break;
+        default:
+            break;
+    }
+}
+
+// A variável é escrita no nível do bloco principal antes de qualquer
+// leitura? Se não, o registrador começa com o 0 que o frame teria
+static int written_before_read(ASTNode *block, const char *name) {
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+        if (stmt->type == AST_ASSIGNMENT && strcmp(stmt->data.assignment.identifier, name) == 0) {
+            return !opt_expr_uses(stmt->data.assignment.expression, name);
+        }
+        if (stmt->type == AST_GET_LINE && strcmp(stmt->data.get_line.identifier, name) == 0) {
+            return 1;
+        }
+
+        NameSet assigned;
+        name_set_init(&assigned);
+        opt_collect_assigned(stmt, &assigned);
+        int touched = name_set_contains(&assigned, name) || opt_stmt_reads(stmt, name);
+        name_set_free(&assigned);
+        if (touched) return 0;
+    }
+    return 1;
+}
+
+static void promote_variables(MIPSCodeGen *gen, ASTNode *ast) {
+    ASTNode *block = opt_procedure_block(ast);
+    int slots = gen->symbol_table->next_offset / 4;
+    if (!block || slots <= 0) return;
+
+    long long *uses = (long long*)calloc(slots, sizeof(long long));
+    count_uses(gen, ast, 0, uses);
+
+    gen->var_regs = (const char**)calloc(slots, sizeof(const char*));
+    for (int r = 0; r < MIPS_PROMOTED_MAX; r++) {
+        // Mais usada entre as que sobraram (empate: a declarada primeiro)
+        int best = -1;
+        for (int i = 0; i < slots; i++) {
+            if (uses[i] > 0 && !gen->var_regs[i] && (best < 0 || uses[i] > uses[best])) best = i;
+        }
+        if (best < 0) break;
+        gen->var_regs[best] = promotion_registers[r];
+    }
+    free(uses);
+
+    for (Symbol *symbol = gen->symbol_table->symbols; symbol; symbol = symbol->next) {
+        const char *reg = gen->var_regs[symbol->offset / 4];
+        if (reg && !written_before_read(block, symbol->name)) {
+            gen->zero_init_regs[gen->zero_init_count++] = reg;
+        }
+    }
+}
+
+// Registrador da variável promovida, ou NULL se ela fica no frame
+static const char* var_register(MIPSCodeGen *gen, Symbol *symbol) {
+    return gen->var_regs ? gen->var_regs[symbol->offset / 4] : NULL;
+}
+
+// Registradores de variáveis são só lidos pelas expressões; os temporários
+// (físicos em -O0, virtuais acima) podem receber o resultado
+static int is_temp_register(const char *reg) {
+    return (reg[0] == '$' && reg[1] == 't') || reg[0] == '%';
+}
+
+static void gen_load_var(MIPSCodeGen *gen, const char *reg, Symbol *symbol) {
+    const char *home = var_register(gen, symbol);
+    if (home) {
+        mips_emit(gen, "    move %s, %s\n", reg, home);
+    } else {
+        mips_emit(gen, "    lw %s, %d($fp)\n", reg, symbol->offset);
+    }
+}
+
+static void gen_store_var(MIPSCodeGen *gen, const char *reg, Symbol *symbol) {
+    const char *home = var_register(gen, symbol);
+    if (!home) {
+        mips_emit(gen, "    sw %s, %d($fp)\n", reg, symbol->offset);
+    } else if (strcmp(home, reg) != 0) {
+        mips_emit(gen, "    move %s, %s\n", home, reg);
+    }
+}
+
+// Valor da expressão sem cópia: o registrador de uma variável promovida
+// (que não pode ser escrito) ou o temporário de mips_gen_expression
+static const char* gen_operand(MIPSCodeGen *gen, ASTNode *expr) {
+    if (expr->type == AST_IDENTIFIER) {
+        Symbol *symbol = symbol_table_lookup(gen->symbol_table, expr->data.identifier.name);
+        if (symbol && var_register(gen, symbol)) return var_register(gen, symbol);
+    }
+    return mips_gen_expression(gen, expr);
+}
+
+// Registrador para o resultado de uma operação sobre 'src': o próprio src se
+// for temporário, senão um temporário novo
+static const char* result_register(MIPSCodeGen *gen, const char *src) {
+    if (is_temp_register(src)) return src;
+    const char *reg = reg_alloc_acquire(gen->reg_alloc);
+    if (!reg) fprintf(stderr, "Error: No available registers\n");
+    return reg;
+}
+
+// Ordem de avaliação (Sethi-Ullman).
+//
+// expr_need é o número de Ershov da expressão: quantos registradores ficam
+// ocupados ao mesmo tempo para calcular seu valor. Variáveis promovidas não
+// ocupam nenhum (gen_operand devolve o registrador delas) e, com otimização,
+// constantes viram imediatos ou sequências de redução de força e contam
+// como grátis. Avaliar primeiro o operando mais pesado deixa só o resultado
+// dele preso enquanto o outro é calculado.
+static int holds_temp(MIPSCodeGen *gen, ASTNode *expr) {
+    if (expr->type == AST_IDENTIFIER) {
+        Symbol *symbol = symbol_table_lookup(gen->symbol_table, expr->data.identifier.name);
+        if (symbol && var_register(gen, symbol)) return 0;
+    }
+    return 1;
+}
+
+static int max_int(int a, int b) {
+    return a > b ? a : b;
+}
+
+static int expr_need(MIPSCodeGen *gen, ASTNode *expr) {
+    switch (expr->type) {
+        case AST_IDENTIFIER:
+            return holds_temp(gen, expr);
+        case AST_UNARY_OP:
+            return max_int(expr_need(gen, expr->data.unary_op.operand), 1);
+        case AST_BINARY_OP: {
+            ASTNode *left = expr->data.binary_op.left;
+            ASTNode *right = expr->data.binary_op.right;
+            if (gen->options->level > 0 && right->type == AST_INTEGER) {
+                return max_int(expr_need(gen, left), 1);
+            }
+            if (gen->options->level > 0 && left->type == AST_INTEGER) {
+                return max_int(expr_need(gen, right), 1);
+            }
+            int l = expr_need(gen, left), r = expr_need(gen, right);
+            int left_first = max_int(l, holds_temp(gen, left) + r);
+            int right_first = max_int(r, holds_temp(gen, right) + l);
+            return max_int(left_first < right_first ? left_first : right_first, 1);
+        }
+        default:
+            return 1;
+    }
+}
+
+// Avaliar o direito antes quando isso ocupa menos registradores. As
+// expressões não têm efeitos além de Constraint_Error (estouro ou divisão
+// por zero), e a ordem dos operandos é arbitrária em Ada (RM 4.5), assim
+// como qual verificação falha primeiro (RM 11.6)
+static int right_first(MIPSCodeGen *gen, ASTNode *left, ASTNode *right) {
+    int l = expr_need(gen, left), r = expr_need(gen, right);
+    return max_int(r, holds_temp(gen, right) + l) < max_int(l, holds_temp(gen, left) + r);
+}
+
+// Registradores dos dois operandos, avaliados na ordem de right_first
+static void gen_operand_pair(MIPSCodeGen *gen, ASTNode *left, ASTNode *right,
+                             const char **left_reg, const char **right_reg) {
+    if (right_first(gen, left, right)) {
+        *right_reg = gen_operand(gen, right);
+        *left_reg = gen_operand(gen, left);
+    } else {
+        *left_reg = gen_operand(gen, left);
+        *right_reg = gen_operand(gen, right);
+    }
+}
+
+// Saída coalescida (-O1 e acima).
+//
+// Cada Put_Line custa dois syscalls: o valor e o "newline". Numa sequência de
+// Put_Line seguidos, todo texto conhecido em tempo de compilação (strings,
+// inteiros literais e os '\n' de cada linha) é concatenado numa só .asciiz,
+// impressa por um único syscall; só os inteiros calculados em execução
+// continuam usando print_int:
+//
+//     Put_Line("Total:"); Put_Line(x); Put_Line(0); Put_Line("Fim");
+//       =>  print_string "Total:\n"; print_int x; print_string "\n0\nFim\n"
+//
+// Os textos vão para o pool de strings, então textos iguais compartilham o
+// rótulo e o "\n" de um print_int vira o rótulo newline.
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} OutputText;
+
+static void output_text_append(OutputText *text, const char *piece) {
+    size_t n = strlen(piece);
+    if (text->length + n + 1 > text->capacity) {
+        text->capacity = (text->length + n + 1) * 2;
+        text->data = (char*)realloc(text->data, text->capacity);
+    }
+    memcpy(text->data + text->length, piece, n + 1);
+    text->length += n;
+}
+
+// O texto pendente vira um rótulo (e um print_string, se generate)
+static void flush_output_text(MIPSCodeGen *gen, OutputText *text, int generate) {
+    if (text->length == 0) return;
+    int id = string_pool_add(gen->strings, text->data);
+    if (generate) {
+        mips_emit(gen, "    la $a0, %s\n", string_pool_label(gen->strings, id));
+        mips_emit(gen, "    li $v0, 4\n");  // syscall print_string
+        mips_emit(gen, "    syscall\n");
+    }
+    text->length = 0;
+    text->data[0] = '\0';
+}
+
+// Fim da sequência de Put_Line que começa em 'start'
+static int put_line_run_end(ASTNode *block, int start) {
+    int end = start;
+    while (end < block->data.block.count && block->data.block.statements[end]->type == AST_PUT_LINE) {
+        end++;
+    }
+    return end;
+}
+
+// Percorre os Put_Line [start, end) do bloco. Com generate = 0 só registra
+// os textos constantes (antes da seção .data); com generate = 1 emite o código
+static void put_line_run(MIPSCodeGen *gen, ASTNode *block, int start, int end, int generate) {
+    OutputText text = { NULL, 0, 0 };
+    output_text_append(&text, "");
+
+    for (int i = start; i < end; i++) {
+        ASTNode *expr = block->data.block.statements[i]->data.put_line.expression;
+
+        if (expr->type == AST_STRING) {
+            output_text_append(&text, expr->data.string.value);
+            output_text_append(&text, "\n");
+        } else if (expr->type == AST_INTEGER) {
+            char number[16];
+            snprintf(number, sizeof(number), "%d\n", expr->data.integer.value);
+            output_text_append(&text, number);
+        } else if (expr->type == AST_IDENTIFIER || expr->type == AST_BINARY_OP) {
+            flush_output_text(gen, &text, generate);
+            if (generate) {
+                const char *reg = gen_operand(gen, expr);
+                if (reg) {
+                    mips_emit(gen, "    move $a0, %s\n", reg);
+                    mips_emit(gen, "    li $v0, 1\n");  // syscall print_int
+                    mips_emit(gen, "    syscall\n");
+                    reg_alloc_release(gen->reg_alloc, reg);
+                }
+            }
+            output_text_append(&text, "\n");
+        }
+    }
+
+    flush_output_text(gen, &text, generate);
+    free(text.data);
+}
+
+// Registra os textos de todas as sequências de Put_Line do programa
+static void collect_output_texts(MIPSCodeGen *gen, ASTNode *node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_PROGRAM:
+            collect_output_texts(gen, node->data.program.procedure);
+            break;
+        case AST_PROCEDURE:
+            collect_output_texts(gen, node->data.procedure.block);
+            break;
+        case AST_BLOCK:
+            for (int i = 0; i < node->data.block.count; i++) {
+                if (node->data.block.statements[i]->type == AST_PUT_LINE) {
+                    int end = put_line_run_end(node, i);
+                    put_line_run(gen, node, i, end, 0);
+                    i = end - 1;
+                } else {
+                    collect_output_texts(gen, node->data.block.statements[i]);
+                }
+            }
+            break;
+        case AST_IF_STATEMENT:
+            collect_output_texts(gen, node->data.if_stmt.then_block);
+            collect_output_texts(gen, node->data.if_stmt.else_block);
+            break;
+        case AST_WHILE_STATEMENT:
+            collect_output_texts(gen, node->data.while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+// Inicialização estática (-O1 e acima).
+//
+// O procedimento principal roda uma única vez e não é recursivo, então seu
+// frame pode viver em .data em vez da pilha. Uma atribuição "x := <literal>"
+// no nível do bloco principal, antes de qualquer outro comando ler ou
+// escrever x, domina todos os usos de x: o valor vai direto para a imagem do
+// frame e o li + sw de inicialização desaparece.
+static void find_static_inits(MIPSCodeGen *gen, ASTNode *ast) {
+    ASTNode *block = opt_procedure_block(ast);
+    int frame_size = gen->symbol_table->next_offset;
+    if (!block || frame_size <= 0) return;
+
+    // Se todas as variáveis foram promovidas, não há frame
+    int in_memory = 0;
+    for (Symbol *symbol = gen->symbol_table->symbols; symbol; symbol = symbol->next) {
+        if (!var_register(gen, symbol)) in_memory = 1;
+    }
+    if (!in_memory) return;
+
+    gen->frame_words = frame_size / 4;
+    gen->frame_image = (int*)calloc(gen->frame_words, sizeof(int));
+    gen->static_inits = (ASTNode**)malloc(block->data.block.count * sizeof(ASTNode*));
+
+    NameSet written;
+    name_set_init(&written);
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+
+        if (stmt->type == AST_ASSIGNMENT &&
+            stmt->data.assignment.expression->type == AST_INTEGER &&
+            !name_set_contains(&written, stmt->data.assignment.identifier)) {
+            const char *name = stmt->data.assignment.identifier;
+            Symbol *symbol = symbol_table_lookup(gen->symbol_table, name);
+
+            int read_before = 0;
+            for (int j = 0; j < i && !read_before; j++) {
+                read_before = opt_stmt_reads(block->data.block.statements[j], name);
+            }
+
+            if (symbol && !read_before && !var_register(gen, symbol)) {
+                gen->frame_image[symbol->offset / 4] = stmt->data.assignment.expression->data.integer.value;
+                gen->static_inits[gen->static_init_count++] = stmt;
+            }
+        }
+
+        opt_collect_assigned(stmt, &written);
+    }
+
+    name_set_free(&written);
+}
+
+static int is_static_init(MIPSCodeGen *gen, ASTNode *stmt) {
+    for (int i = 0; i < gen->static_init_count; i++) {
+        if (gen->static_inits[i] == stmt) return 1;
+    }
+    return 0;
+}
+
+// Strings literais, textos dos Put_Line coalescidos e os textos fixos
+// usados pelo código gerado, todos no mesmo pool
+void mips_collect_strings(MIPSCodeGen *gen, ASTNode *ast) {
     collect_strings(ast, gen);
-    
-    // Adicionar newline para Put_Line
-    mips_emit(gen, "newline: .asciiz \"\\n\"\n");
+    if (gen->options->level > 0) {
+        collect_output_texts(gen, ast);
+    }
+    string_pool_set_name(gen->strings, string_pool_add(gen->strings, "\n"), "newline");
+    if (gen->options->profile_generate) {
+        string_pool_set_name(gen->strings, string_pool_add(gen->strings, "@prof-blocks "), "prof_blocks_tag");
+        string_pool_set_name(gen->strings, string_pool_add(gen->strings, "@prof "), "prof_tag");
+        string_pool_set_name(gen->strings, string_pool_add(gen->strings, " "), "prof_sep");
+    }
+}
+
+void mips_emit_data_section(MIPSCodeGen *gen) {
+    mips_emit(gen, ".data\n");
+    string_pool_emit(gen->strings, gen->output);
+
+    // Contadores de -fprofile-generate
+    if (gen->options->profile_generate) {
+        mips_emit(gen, "    .align 2\n");
+        mips_emit(gen, "prof_counts: .space %d\n", 4 * gen->options->profile_blocks);
+    }
+
+    // Frame estático com os valores iniciais
+    if (gen->frame_image) {
+        mips_emit(gen, "    .align 2\n");
+        mips_emit(gen, "frame:");
+        for (int i = 0; i < gen->frame_words; i++) {
+            if (i % 8 == 0) {
+                mips_emit(gen, i == 0 ? " .word %d" : "\n    .word %d", gen->frame_image[i]);
+            } else {
+                mips_emit(gen, ", %d", gen->frame_image[i]);
+            }
+        }
+        mips_emit(gen, "\n");
+    }
     
     mips_emit(gen, "\n");
 }
@@ -142,8 +614,9 @@ const char* mips_gen_expression(MIPSCodeGen *gen, ASTNode *expr) {
                 return NULL;
             }
             
-            // Carregar do offset relativo ao $fp
-            mips_emit(gen, "    lw %s, %d($fp)\n", reg, symbol->offset);
+            // Carregar do offset relativo ao $fp (ou copiar do registrador
+            // da variável promovida)
+            gen_load_var(gen, reg, symbol);
             return reg;
         }
             
@@ -158,27 +631,27 @@ const char* mips_gen_expression(MIPSCodeGen *gen, ASTNode *expr) {
                 return NULL;
             }
             
-            // Mapear a string para seu label usando o contador da estrutura
-            // Nota: Este é um approach simplificado. Uma implementação completa
-            // deveria manter um mapa de strings para labels
-            // Por agora, assumimos que as strings são processadas em ordem
-            static int current_str = 0;
-            mips_emit(gen, "    la %s, str%d\n", reg, current_str);
-            current_str++;
+            // O rótulo vem do pool, preenchido por collect_strings
+            mips_emit(gen, "    la %s, %s\n", reg,
+                      string_pool_label(gen->strings, expr->data.string.label_id));
             return reg;
         }
             
         case AST_UNARY_OP: {
-            const char *operand_reg = mips_gen_expression(gen, expr->data.unary_op.operand);
+            const char *operand_reg = gen_operand(gen, expr->data.unary_op.operand);
             if (!operand_reg) return NULL;
+            reg = result_register(gen, operand_reg);
+            if (!reg) return NULL;
             
             if (strcmp(expr->data.unary_op.operator, "-") == 0) {
-                mips_emit(gen, "    neg %s, %s\n", operand_reg, operand_reg);
-            } else if (strcmp(expr->data.unary_op.operator, "not") == 0) {
-                mips_emit(gen, "    xori %s, %s, 1\n", operand_reg, operand_reg);
+                mips_emit(gen, "    neg %s, %s\n", reg, operand_reg);
+            } else if (opt_op_is(expr->data.unary_op.operator, "not")) {
+                mips_emit(gen, "    xori %s, %s, 1\n", reg, operand_reg);
+            } else if (reg != operand_reg) {
+                mips_emit(gen, "    move %s, %s\n", reg, operand_reg);
             }
             
-            return operand_reg;
+            return reg;
         }
             
         default:
@@ -186,20 +659,531 @@ const char* mips_gen_expression(MIPSCodeGen *gen, ASTNode *expr) {
     }
 }
 
+// Custo aproximado, em ciclos, das instruções envolvidas na redução de
+// força. Uma reescrita só é usada se for mais barata que a original.
+typedef enum {
+    COST_ALU,       // addu, subu, sll, sra, srl
+    COST_LI,        // li (constante em registrador)
+    COST_MUL,       // mul
+    COST_MULT_HI,   // mult + mfhi
+    COST_DIV        // div + mflo + teste de divisor zero
+} CostClass;
+
+static const int instr_cost[] = {
+    [COST_ALU] = 1,
+    [COST_LI] = 1,
+    [COST_MUL] = 5,
+    [COST_MULT_HI] = 6,
+    [COST_DIV] = 38
+};
+
+// Representação em dígitos com sinal (CSD) de |c|: c = soma de
+// sign[i] * 2^shift[i]. Retorna o número de dígitos não nulos.
+static int csd_digits(unsigned int value, int shift[32], int sign[32]) {
+    int count = 0;
+    int bit = 0;
+    unsigned long long v = value;
+
+    while (v != 0) {
+        if (v & 1) {
+            int digit = ((v & 3) == 3) ? -1 : 1;
+            shift[count] = bit;
+            sign[count] = digit;
+            count++;
+            v = (digit == 1) ? v - 1 : v + 1;
+        }
+        v >>= 1;
+        bit++;
+    }
+    return count;
+}
+
+// x * c com deslocamentos e somas; NULL se a sequência não compensa
+static const char* gen_mul_const(MIPSCodeGen *gen, ASTNode *operand, int c) {
+    if (c == 0 && !opt_expr_may_trap(operand)) {
+        const char *reg = reg_alloc_acquire(gen->reg_alloc);
+        if (!reg) return NULL;
+        mips_emit(gen, "    li %s, 0\n", reg);
+        return reg;
+    }
+
+    unsigned int magnitude = c < 0 ? 0u - (unsigned int)c : (unsigned int)c;
+    int shift[32], sign[32];
+    int digits = csd_digits(magnitude, shift, sign);
+
+    // Um deslocamento por dígito (exceto 2^0), uma soma entre dígitos e
+    // a negação final
+    int cost = digits - 1 + (c < 0 ? 1 : 0);
+    for (int i = 0; i < digits; i++) {
+        if (shift[i] != 0) cost++;
+    }
+    if (c == 0 || cost * instr_cost[COST_ALU] >= instr_cost[COST_LI] + instr_cost[COST_MUL]) {
+        return NULL;
+    }
+
+    const char *x = gen_operand(gen, operand);
+    if (!x) return NULL;
+
+    if (digits == 1) {
+        const char *dst = result_register(gen, x);
+        if (!dst) return NULL;
+        const char *src = x;
+        if (shift[0] != 0) {
+            mips_emit(gen, "    sll %s, %s, %d\n", dst, src, shift[0]);
+            src = dst;
+        }
+        if (c < 0) {
+            mips_emit(gen, "    subu %s, $zero, %s\n", dst, src);
+            src = dst;
+        }
+        if (src != dst) {
+            mips_emit(gen, "    move %s, %s\n", dst, src);
+        }
+        return dst;
+    }
+
+    const char *acc = reg_alloc_acquire(gen->reg_alloc);
+    const char *tmp = reg_alloc_acquire(gen->reg_alloc);
+    if (!acc || !tmp) return NULL;
+
+    // Dígito mais significativo primeiro (sempre positivo no CSD)
+    int top = digits - 1;
+    mips_emit(gen, "    sll %s, %s, %d\n", acc, x, shift[top]);
+    for (int i = top - 1; i >= 0; i--) {
+        const char *term = x;
+        if (shift[i] != 0) {
+            mips_emit(gen, "    sll %s, %s, %d\n", tmp, x, shift[i]);
+            term = tmp;
+        }
+        mips_emit(gen, "    %s %s, %s, %s\n", sign[i] > 0 ? "addu" : "subu", acc, acc, term);
+    }
+    if (c < 0) {
+        mips_emit(gen, "    subu %s, $zero, %s\n", acc, acc);
+    }
+
+    reg_alloc_release(gen->reg_alloc, tmp);
+    reg_alloc_release(gen->reg_alloc, x);
+    return acc;
+}
+
+// Número mágico para divisão com sinal por constante
+// (Hacker's Delight, 2ª ed., figura 10-1). Requer |d| >= 2.
+static void signed_magic(int d, int *magic, int *shift) {
+    const unsigned int two31 = 0x80000000u;
+    unsigned int ad = d < 0 ? 0u - (unsigned int)d : (unsigned int)d;
+    unsigned int t = two31 + ((unsigned int)d >> 31);
+    unsigned int anc = t - 1 - t % ad;
+    unsigned int q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned int q2 = two31 / ad, r2 = two31 - q2 * ad;
+    unsigned int delta;
+    int p = 31;
+
+    do {
+        p++;
+        q1 = 2 * q1;
+        r1 = 2 * r1;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 = 2 * q2;
+        r2 = 2 * r2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    *magic = (int)(q2 + 1);
+    if (d < 0) *magic = -*magic;
+    *shift = p - 32;
+}
+
+// O passe vrp provou que a expressão nunca é negativa?
+static int is_non_negative(ASTNode *expr) {
+    if (expr->type == AST_INTEGER) return expr->data.integer.value >= 0;
+    ValueRange *range = ast_range(expr);
+    return range && range->known && range->lo >= 0;
+}
+
+// x / d (truncando em direção a zero, como o div do MIPS); NULL se não compensa
+static const char* gen_div_const(MIPSCodeGen *gen, ASTNode *operand, int d) {
+    if (d == 0 || d == (int)0x80000000) {
+        return NULL;
+    }
+
+    unsigned int magnitude = d < 0 ? 0u - (unsigned int)d : (unsigned int)d;
+    int is_pow2 = (magnitude & (magnitude - 1)) == 0;
+
+    if (is_pow2 && magnitude > 1) {
+        int k = 0;
+        while ((1u << k) != magnitude) k++;
+
+        // Dividendo não negativo: o deslocamento já trunca em direção a zero
+        if (is_non_negative(operand)) {
+            const char *x = gen_operand(gen, operand);
+            if (!x) return NULL;
+            const char *q = result_register(gen, x);
+            if (!q) return NULL;
+            mips_emit(gen, "    sra %s, %s, %d\n", q, x, k);
+            if (d < 0) {
+                mips_emit(gen, "    subu %s, $zero, %s\n", q, q);
+            }
+            return q;
+        }
+
+        // Soma 2^k - 1 aos dividendos negativos antes do deslocamento aritmético
+        if (4 * instr_cost[COST_ALU] >= instr_cost[COST_DIV]) return NULL;
+
+        const char *x = gen_operand(gen, operand);
+        const char *t = reg_alloc_acquire(gen->reg_alloc);
+        if (!x || !t) return NULL;
+
+        if (k == 1) {
+            mips_emit(gen, "    srl %s, %s, 31\n", t, x);
+        } else {
+            mips_emit(gen, "    sra %s, %s, 31\n", t, x);
+            mips_emit(gen, "    srl %s, %s, %d\n", t, t, 32 - k);
+        }
+        mips_emit(gen, "    addu %s, %s, %s\n", t, x, t);
+        // O quociente fica em x se ele for temporário, senão no próprio t
+        const char *q = is_temp_register(x) ? x : t;
+        mips_emit(gen, "    sra %s, %s, %d\n", q, t, k);
+        if (d < 0) {
+            mips_emit(gen, "    subu %s, $zero, %s\n", q, q);
+        }
+        if (q != t) reg_alloc_release(gen->reg_alloc, t);
+        return q;
+    }
+
+    if (magnitude == 1) {
+        const char *x = mips_gen_expression(gen, operand);
+        if (x && d < 0) {
+            mips_emit(gen, "    neg %s, %s\n", x, x);
+        }
+        return x;
+    }
+
+    // Multiplicação pela parte alta do número mágico
+    int cost = instr_cost[COST_LI] + instr_cost[COST_MULT_HI] + 3 * instr_cost[COST_ALU];
+    if (cost >= instr_cost[COST_DIV]) return NULL;
+
+    int magic, shift;
+    signed_magic(d, &magic, &shift);
+
+    const char *x = gen_operand(gen, operand);
+    const char *q = reg_alloc_acquire(gen->reg_alloc);
+    const char *t = reg_alloc_acquire(gen->reg_alloc);
+    if (!x || !q || !t) return NULL;
+
+    mips_emit(gen, "    li %s, %d\n", t, magic);
+    mips_emit(gen, "    mult %s, %s\n", x, t);
+    mips_emit(gen, "    mfhi %s\n", q);
+    if (d > 0 && magic < 0) {
+        mips_emit(gen, "    addu %s, %s, %s\n", q, q, x);
+    } else if (d < 0 && magic > 0) {
+        mips_emit(gen, "    subu %s, %s, %s\n", q, q, x);
+    }
+    if (shift > 0) {
+        mips_emit(gen, "    sra %s, %s, %d\n", q, q, shift);
+    }
+    // Corrige o arredondamento: soma 1 quando o quociente é negativo (nunca
+    // é, se o dividendo e o divisor não são negativos)
+    if (d < 0 || !is_non_negative(operand)) {
+        mips_emit(gen, "    srl %s, %s, 31\n", t, q);
+        mips_emit(gen, "    addu %s, %s, %s\n", q, q, t);
+    }
+
+    reg_alloc_release(gen->reg_alloc, t);
+    reg_alloc_release(gen->reg_alloc, x);
+    return q;
+}
+
+static int is_relational(const char *op) {
+    return strcmp(op, "<") == 0 || strcmp(op, "<=") == 0 || strcmp(op, ">") == 0 ||
+           strcmp(op, ">=") == 0 || strcmp(op, "=") == 0 || strcmp(op, "/=") == 0;
+}
+
+// Relação que vale quando a original é falsa
+static const char* negate_relation(const char *op) {
+    if (strcmp(op, "<") == 0) return ">=";
+    if (strcmp(op, "<=") == 0) return ">";
+    if (strcmp(op, ">") == 0) return "<=";
+    if (strcmp(op, ">=") == 0) return "<";
+    if (strcmp(op, "=") == 0) return "/=";
+    return "=";
+}
+
+// Relação equivalente com os operandos trocados
+static const char* swap_relation(const char *op) {
+    if (strcmp(op, "<") == 0) return ">";
+    if (strcmp(op, "<=") == 0) return ">=";
+    if (strcmp(op, ">") == 0) return "<";
+    if (strcmp(op, ">=") == 0) return "<=";
+    return op;
+}
+
+static int fits_simm16(long long value) {
+    return value >= -32768 && value <= 32767;
+}
+
+// Comparação seguida de desvio, sem materializar o booleano:
+//   x REL 0      -> beqz/bnez/bltz/blez/bgtz/bgez x
+//   x = y, x /= y -> beq/bne
+//   x < y        -> slt + bnez (beqz com o sentido invertido)
+//   x < c        -> slti + bnez/beqz (x <= c e x > c viram x < c+1)
+static int gen_compare_branch(MIPSCodeGen *gen, ASTNode *cond, const char *label, int jump_if) {
+    const char *rel = cond->data.binary_op.operator;
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+
+    if (!jump_if) {
+        rel = negate_relation(rel);
+    }
+
+    // Constante sempre à direita
+    if (left->type == AST_INTEGER && right->type != AST_INTEGER) {
+        ASTNode *tmp = left;
+        left = right;
+        right = tmp;
+        rel = swap_relation(rel);
+    }
+
+    // Dois operandos calculados: o mais pesado primeiro
+    const char *left_reg, *right_reg = NULL;
+    if (right->type == AST_INTEGER) {
+        left_reg = gen_operand(gen, left);
+    } else {
+        gen_operand_pair(gen, left, right, &left_reg, &right_reg);
+        if (!right_reg) return 0;
+    }
+    if (!left_reg) return 0;
+
+    // Comparação com zero: desvio direto sobre o registrador
+    if (right->type == AST_INTEGER && right->data.integer.value == 0) {
+        const char *branch = strcmp(rel, "=") == 0 ? "beqz" :
+                             strcmp(rel, "/=") == 0 ? "bnez" :
+                             strcmp(rel, "<") == 0 ? "bltz" :
+                             strcmp(rel, "<=") == 0 ? "blez" :
+                             strcmp(rel, ">") == 0 ? "bgtz" : "bgez";
+        mips_emit(gen, "    %s %s, %s\n", branch, left_reg, label);
+        reg_alloc_release(gen->reg_alloc, left_reg);
+        return 1;
+    }
+
+    // Comparação com imediato: x < c, x >= c, e x <= c / x > c como x < c+1
+    if (right->type == AST_INTEGER && strcmp(rel, "=") != 0 && strcmp(rel, "/=") != 0) {
+        long long c = right->data.integer.value;
+        int less = strcmp(rel, "<") == 0 || strcmp(rel, "<=") == 0;
+        if (strcmp(rel, "<=") == 0 || strcmp(rel, ">") == 0) {
+            c++;
+        }
+        if (fits_simm16(c)) {
+            const char *flag = result_register(gen, left_reg);
+            if (!flag) return 0;
+            mips_emit(gen, "    slti %s, %s, %lld\n", flag, left_reg, c);
+            mips_emit(gen, "    %s %s, %s\n", less ? "bnez" : "beqz", flag, label);
+            reg_alloc_release(gen->reg_alloc, flag);
+            return 1;
+        }
+    }
+
+    if (!right_reg) right_reg = gen_operand(gen, right);
+    if (!right_reg) return 0;
+
+    if (strcmp(rel, "=") == 0 || strcmp(rel, "/=") == 0) {
+        mips_emit(gen, "    %s %s, %s, %s\n", strcmp(rel, "=") == 0 ? "beq" : "bne",
+                  left_reg, right_reg, label);
+    } else {
+        // a < b e a >= b usam slt a,b; a > b e a <= b usam slt b,a
+        int swap = strcmp(rel, ">") == 0 || strcmp(rel, "<=") == 0;
+        int on_true = strcmp(rel, "<") == 0 || strcmp(rel, ">") == 0;
+        const char *flag = is_temp_register(right_reg) ? right_reg : result_register(gen, left_reg);
+        if (!flag) return 0;
+        mips_emit(gen, "    slt %s, %s, %s\n", flag,
+                  swap ? right_reg : left_reg, swap ? left_reg : right_reg);
+        mips_emit(gen, "    %s %s, %s\n", on_true ? "bnez" : "beqz", flag, label);
+        reg_alloc_release(gen->reg_alloc, flag);
+    }
+
+    reg_alloc_release(gen->reg_alloc, right_reg);
+    reg_alloc_release(gen->reg_alloc, left_reg);
+    return 1;
+}
+
+// Código de desvio para condições: salta para 'label' quando a condição
+// vale 'jump_if' e segue em frente caso contrário. and/or avaliam o operando
+// direito só quando o esquerdo não decide o resultado (Ada RM 11.6 permite
+// omitir uma verificação cujo resultado não é necessário) e not apenas troca
+// o sentido do salto, então nenhum booleano intermediário é materializado.
+static int gen_cond_jump(MIPSCodeGen *gen, ASTNode *cond, const char *label, int jump_if) {
+    if (cond->type == AST_BINARY_OP) {
+        const char *op = cond->data.binary_op.operator;
+        int is_and = opt_op_is(op, "and");
+
+        if (is_and || opt_op_is(op, "or")) {
+            ASTNode *left = cond->data.binary_op.left;
+            ASTNode *right = cond->data.binary_op.right;
+
+            // "a and b" falso / "a or b" verdadeiro: qualquer operando decide
+            if (is_and != jump_if) {
+                return gen_cond_jump(gen, left, label, jump_if) &&
+                       gen_cond_jump(gen, right, label, jump_if);
+            }
+
+            // Caso contrário o esquerdo só pode encerrar o teste sem saltar
+            char skip_label[32];
+            strcpy(skip_label, mips_new_label(gen));
+            if (!gen_cond_jump(gen, left, skip_label, !jump_if)) return 0;
+            if (!gen_cond_jump(gen, right, label, jump_if)) return 0;
+            mips_emit(gen, "%s:\n", skip_label);
+            return 1;
+        }
+    } else if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        return gen_cond_jump(gen, cond->data.unary_op.operand, label, !jump_if);
+    }
+
+    if (cond->type == AST_BINARY_OP && is_relational(cond->data.binary_op.operator)) {
+        return gen_compare_branch(gen, cond, label, jump_if);
+    }
+
+    const char *reg = gen_operand(gen, cond);
+    if (!reg) return 0;
+    mips_emit(gen, "    %s %s, %s\n", jump_if ? "bnez" : "beqz", reg, label);
+    reg_alloc_release(gen->reg_alloc, reg);
+    return 1;
+}
+
+// Salta para 'label' quando a condição vale 'jump_if' (usado por if e while)
+static int gen_branch(MIPSCodeGen *gen, ASTNode *cond, const char *label, int jump_if) {
+    if (gen->options->level > 0) {
+        return gen_cond_jump(gen, cond, label, jump_if);
+    }
+
+    const char *reg = mips_gen_expression(gen, cond);
+    if (!reg) return 0;
+    mips_emit(gen, "    %s %s, %s\n", jump_if ? "bnez" : "beqz", reg, label);
+    reg_alloc_release(gen->reg_alloc, reg);
+    return 1;
+}
+
+// Valor 0/1 de uma condição calculado por código de desvio
+static const char* gen_condition_value(MIPSCodeGen *gen, ASTNode *cond) {
+    const char *reg = reg_alloc_acquire(gen->reg_alloc);
+    if (!reg) {
+        fprintf(stderr, "Error: No available registers\n");
+        return NULL;
+    }
+
+    char end_label[32];
+    strcpy(end_label, mips_new_label(gen));
+    mips_emit(gen, "    li %s, 0\n", reg);
+    if (!gen_cond_jump(gen, cond, end_label, 0)) return NULL;
+    mips_emit(gen, "    li %s, 1\n", reg);
+    mips_emit(gen, "%s:\n", end_label);
+    return reg;
+}
+
+// Forma imediata (addi, addiu, slti, andi, ori) quando um operando é uma
+// constante de 16 bits; NULL se a operação não tem forma imediata
+static const char* gen_immediate_op(MIPSCodeGen *gen, ASTNode *node, const char *target) {
+    const char *op = node->data.binary_op.operator;
+    ASTNode *left = node->data.binary_op.left;
+    ASTNode *right = node->data.binary_op.right;
+    int add = strcmp(op, "+") == 0;
+    int logical = opt_op_is(op, "and") || opt_op_is(op, "or");
+
+    // + e and/or são comutativos: a constante vai para a direita
+    if ((add || logical) && left->type == AST_INTEGER && right->type != AST_INTEGER) {
+        ASTNode *tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (right->type != AST_INTEGER) return NULL;
+
+    long long c = right->data.integer.value;
+    const char *form;
+
+    if (add || strcmp(op, "-") == 0) {
+        if (!add) c = -c;
+        if (!fits_simm16(c)) return NULL;
+        form = node->data.binary_op.unchecked ? "addiu" : "addi";
+    } else if (strcmp(op, "<") == 0) {
+        if (!fits_simm16(c)) return NULL;
+        form = "slti";
+    } else if (logical) {
+        // andi/ori estendem o imediato com zeros
+        if (c < 0 || c > 0xFFFF) return NULL;
+        form = opt_op_is(op, "and") ? "andi" : "ori";
+    } else {
+        return NULL;
+    }
+
+    const char *reg = gen_operand(gen, left);
+    if (!reg) return NULL;
+    const char *result = target ? target : result_register(gen, reg);
+    if (!result) return NULL;
+    mips_emit(gen, "    %s %s, %s, %lld\n", form, result, reg, c);
+    if (result != reg) reg_alloc_release(gen->reg_alloc, reg);
+    return result;
+}
+
 const char* mips_gen_binary_op(MIPSCodeGen *gen, ASTNode *node) {
-    const char *left_reg = mips_gen_expression(gen, node->data.binary_op.left);
-    const char *right_reg = mips_gen_expression(gen, node->data.binary_op.right);
-    
+    ASTNode *left = node->data.binary_op.left;
+    ASTNode *right = node->data.binary_op.right;
+
+    // O destino pedido vale só para esta operação, não para os operandos
+    const char *target = gen->target;
+    gen->target = NULL;
+
+    // Redução de força para multiplicação e divisão por constantes
+    if (gen->options->level > 0) {
+        const char *reduced = NULL;
+        int handled = 0;
+
+        if (strcmp(node->data.binary_op.operator, "*") == 0) {
+            if (right->type == AST_INTEGER) {
+                handled = 1;
+                reduced = gen_mul_const(gen, left, right->data.integer.value);
+            } else if (left->type == AST_INTEGER) {
+                handled = 1;
+                reduced = gen_mul_const(gen, right, left->data.integer.value);
+            }
+        } else if (strcmp(node->data.binary_op.operator, "/") == 0 && right->type == AST_INTEGER) {
+            handled = 1;
+            reduced = gen_div_const(gen, left, right->data.integer.value);
+        }
+
+        if (handled && reduced) {
+            return reduced;
+        }
+
+        // and/or cujo operando direito pode levantar exceção: o valor é
+        // montado com desvios para que o direito só rode quando necessário
+        const char *op = node->data.binary_op.operator;
+        if ((opt_op_is(op, "and") || opt_op_is(op, "or")) && opt_expr_may_trap(right)) {
+            return gen_condition_value(gen, node);
+        }
+
+        const char *immediate = gen_immediate_op(gen, node, target);
+        if (immediate) {
+            return immediate;
+        }
+    }
+
+    const char *left_reg, *right_reg;
+    gen_operand_pair(gen, left, right, &left_reg, &right_reg);
     if (!left_reg || !right_reg) return NULL;
     
     const char *op = node->data.binary_op.operator;
-    const char *result_reg = left_reg;  // Reusar registrador da esquerda
+    // Reusar um registrador dos operandos (o da esquerda, se temporário)
+    const char *result_reg = target ? target :
+                             is_temp_register(right_reg) && !is_temp_register(left_reg) ? right_reg :
+                             result_register(gen, left_reg);
+    if (!result_reg) return NULL;
     
     // Operadores aritméticos
     if (strcmp(op, "+") == 0) {
-        mips_emit(gen, "    add %s, %s, %s\n", result_reg, left_reg, right_reg);
+        mips_emit(gen, "    %s %s, %s, %s\n", node->data.binary_op.unchecked ? "addu" : "add",
+                  result_reg, left_reg, right_reg);
     } else if (strcmp(op, "-") == 0) {
-        mips_emit(gen, "    sub %s, %s, %s\n", result_reg, left_reg, right_reg);
+        mips_emit(gen, "    %s %s, %s, %s\n", node->data.binary_op.unchecked ? "subu" : "sub",
+                  result_reg, left_reg, right_reg);
     } else if (strcmp(op, "*") == 0) {
         mips_emit(gen, "    mul %s, %s, %s\n", result_reg, left_reg, right_reg);
     } else if (strcmp(op, "/") == 0) {
@@ -220,48 +1204,483 @@ const char* mips_gen_binary_op(MIPSCodeGen *gen, ASTNode *node) {
         mips_emit(gen, "    sne %s, %s, %s\n", result_reg, left_reg, right_reg);
     }
     // Operadores lógicos
-    else if (strcmp(op, "and") == 0) {
+    else if (opt_op_is(op, "and")) {
         mips_emit(gen, "    and %s, %s, %s\n", result_reg, left_reg, right_reg);
-    } else if (strcmp(op, "or") == 0) {
+    } else if (opt_op_is(op, "or")) {
         mips_emit(gen, "    or %s, %s, %s\n", result_reg, left_reg, right_reg);
     }
     
-    // Liberar registrador da direita
-    reg_alloc_release(gen->reg_alloc, right_reg);
+    // Liberar os operandos que não guardam o resultado
+    if (right_reg != result_reg) reg_alloc_release(gen->reg_alloc, right_reg);
+    if (left_reg != result_reg) reg_alloc_release(gen->reg_alloc, left_reg);
     
     return result_reg;
 }
 
 void mips_gen_assignment(MIPSCodeGen *gen, ASTNode *node) {
-    const char *expr_reg = mips_gen_expression(gen, node->data.assignment.expression);
-    if (!expr_reg) return;
-    
+    ASTNode *expr = node->data.assignment.expression;
+
     // Obter símbolo
     Symbol *symbol = symbol_table_lookup(gen->symbol_table, node->data.assignment.identifier);
+    const char *home = symbol ? var_register(gen, symbol) : NULL;
+
+    // Variável promovida: a constante ou a operação binária do topo escreve
+    // direto no registrador dela
+    if (home && expr->type == AST_INTEGER) {
+        mips_emit(gen, "    li %s, %d\n", home, expr->data.integer.value);
+        return;
+    }
+    if (home && expr->type == AST_BINARY_OP) {
+        gen->target = home;
+    }
+
+    const char *expr_reg = gen_operand(gen, expr);
+    gen->target = NULL;
+    if (!expr_reg) return;
+    
     if (!symbol) {
         fprintf(stderr, "Error: Undefined variable '%s'\n", node->data.assignment.identifier);
         reg_alloc_release(gen->reg_alloc, expr_reg);
         return;
     }
     
-    // Armazenar no offset relativo ao $fp
-    mips_emit(gen, "    sw %s, %d($fp)\n", expr_reg, symbol->offset);
+    // Armazenar no offset relativo ao $fp (ou no registrador da variável)
+    gen_store_var(gen, expr_reg, symbol);
     
     // Liberar registrador
     reg_alloc_release(gen->reg_alloc, expr_reg);
 }
 
+// Um braço é frio quando roda no máximo 1/PROFILE_COLD_RATIO das vezes
+// que o if executa
+#define PROFILE_COLD_RATIO 16
+
+static int is_cold_arm(MIPSCodeGen *gen, ASTNode *arm) {
+    if (!arm || !gen->cold || gen->output == gen->cold) return 0;
+    if (gen->block_count <= 0 || arm->data.block.profile_count < 0) return 0;
+    return arm->data.block.profile_count * PROFILE_COLD_RATIO <= gen->block_count;
+}
+
+static void gen_cold_arm(MIPSCodeGen *gen, ASTNode *arm, const char *label, const char *end_label) {
+    FILE *hot = gen->output;
+    gen->output = gen->cold;
+    mips_emit(gen, "%s:\n", label);
+    mips_gen_statement(gen, arm);
+    mips_emit(gen, "    j %s\n", end_label);
+    gen->output = hot;
+}
+
+// If com um braço frio: o braço quente segue direto e o frio vai para a
+// seção fria, no fim do código, saltando de volta ao terminar.
+//
+//     <cond>; desvio para Lcold       (beqz para else frio, bnez para then frio)
+//     <braço quente>
+//   Lend:
+//   ...
+//   Lcold:                            (seção fria)
+//     <braço frio>
+//     j Lend
+static int gen_outlined_if(MIPSCodeGen *gen, ASTNode *node) {
+    ASTNode *then_block = node->data.if_stmt.then_block;
+    ASTNode *else_block = node->data.if_stmt.else_block;
+    ASTNode *cold_arm, *hot_arm;
+    int jump_if;
+
+    if (is_cold_arm(gen, then_block)) {
+        cold_arm = then_block;
+        hot_arm = else_block;
+        jump_if = 1;
+    } else if (is_cold_arm(gen, else_block)) {
+        cold_arm = else_block;
+        hot_arm = then_block;
+        jump_if = 0;
+    } else {
+        return 0;
+    }
+
+    char cold_label[32];
+    char end_label[32];
+    strcpy(cold_label, mips_new_label(gen));
+    strcpy(end_label, mips_new_label(gen));
+
+    if (!gen_branch(gen, node->data.if_stmt.condition, cold_label, jump_if)) return 1;
+
+    // Os braços são gerados na ordem do fonte (a numeração das strings segue
+    // a ordem de geração), cada um na sua seção
+    if (cold_arm == then_block) {
+        gen_cold_arm(gen, cold_arm, cold_label, end_label);
+        mips_gen_statement(gen, hot_arm);
+        mips_emit(gen, "%s:\n", end_label);
+    } else {
+        mips_gen_statement(gen, hot_arm);
+        mips_emit(gen, "%s:\n", end_label);
+        gen_cold_arm(gen, cold_arm, cold_label, end_label);
+    }
+    return 1;
+}
+
+// Conversão de if (if-conversion): diamantes e triângulos pequenos viram
+// código sem desvio. O if
+//
+//     if x > y then m := x; else m := y; end if;
+//
+// é gerado como
+//
+//     <x>; <y>; slt c, y, x
+//     movn <y>, <x>, c        (m recebe x quando c /= 0)
+//     sw <y>, m
+//
+// Os dois valores são calculados sempre, então só expressões que não podem
+// levantar exceção (especuláveis) entram. Sem else, o valor antigo da
+// variável faz o papel do braço ausente; "v := v + 1" e "v := v - 1" sem
+// else somam o próprio resultado 0/1 da comparação (add verificado continua
+// levantando exceção exatamente quando o braço levantaria).
+
+// Ciclos perdidos por um desvio mal previsto
+#define BRANCH_MISPREDICT_PENALTY 4
+
+// Pode ser calculada mesmo quando o if não a executaria? + e - verificados
+// só entram depois que o vrp provou que não transbordam (marcados unchecked)
+static int is_speculatable(ASTNode *expr) {
+    switch (expr->type) {
+        case AST_INTEGER:
+        case AST_IDENTIFIER:
+            return 1;
+        case AST_UNARY_OP:
+            // neg levanta exceção com o menor inteiro
+            if (strcmp(expr->data.unary_op.operator, "-") == 0 &&
+                expr->data.unary_op.operand->type != AST_INTEGER) {
+                return 0;
+            }
+            return is_speculatable(expr->data.unary_op.operand);
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            ASTNode *right = expr->data.binary_op.right;
+            if ((strcmp(op, "+") == 0 || strcmp(op, "-") == 0) && !expr->data.binary_op.unchecked) {
+                return 0;
+            }
+            if (strcmp(op, "/") == 0 &&
+                !(right->type == AST_INTEGER && right->data.integer.value != 0 &&
+                  right->data.integer.value != -1)) {
+                return 0;
+            }
+            return is_speculatable(expr->data.binary_op.left) && is_speculatable(right);
+        }
+        default:
+            return 0;
+    }
+}
+
+// Instruções estimadas para calcular a expressão num registrador
+static int expr_cost(ASTNode *expr) {
+    switch (expr->type) {
+        case AST_INTEGER:
+        case AST_IDENTIFIER:
+            return instr_cost[COST_LI];
+        case AST_UNARY_OP:
+            return expr_cost(expr->data.unary_op.operand) + instr_cost[COST_ALU];
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            ASTNode *right = expr->data.binary_op.right;
+            int cost = expr_cost(expr->data.binary_op.left);
+            int constant = right->type == AST_INTEGER;
+
+            if (!constant) cost += expr_cost(right);
+            if (strcmp(op, "*") == 0) {
+                cost += instr_cost[COST_MUL];
+            } else if (strcmp(op, "/") == 0) {
+                cost += constant ? instr_cost[COST_MULT_HI] + 2 * instr_cost[COST_ALU]
+                                 : instr_cost[COST_DIV];
+            } else {
+                cost += instr_cost[COST_ALU];
+            }
+            return cost;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Atribuição única de um braço (NULL se o braço tem outra forma)
+static ASTNode* single_assignment(ASTNode *arm) {
+    if (!arm || arm->type != AST_BLOCK || arm->data.block.count != 1) return NULL;
+    ASTNode *stmt = arm->data.block.statements[0];
+    return stmt->type == AST_ASSIGNMENT ? stmt : NULL;
+}
+
+static int is_empty_arm(ASTNode *arm) {
+    return !arm || (arm->type == AST_BLOCK && arm->data.block.count == 0);
+}
+
+// "v := v + 1" ou "v := v - 1": passo +1/-1, 0 se não tem essa forma
+static int unit_step(ASTNode *assign) {
+    ASTNode *expr = assign->data.assignment.expression;
+    if (expr->type != AST_BINARY_OP) return 0;
+
+    const char *op = expr->data.binary_op.operator;
+    ASTNode *left = expr->data.binary_op.left;
+    ASTNode *right = expr->data.binary_op.right;
+    int add = strcmp(op, "+") == 0;
+    if (!add && strcmp(op, "-") != 0) return 0;
+
+    if (add && left->type == AST_INTEGER) {
+        ASTNode *tmp = left;
+        left = right;
+        right = tmp;
+    }
+    if (left->type != AST_IDENTIFIER || right->type != AST_INTEGER ||
+        strcmp(left->data.identifier.name, assign->data.assignment.identifier) != 0) {
+        return 0;
+    }
+
+    int step = right->data.integer.value;
+    if (step != 1 && step != -1) return 0;
+    return add ? step : -step;
+}
+
+// A condição pode virar um valor de seleção? Os operandos de comparações
+// são avaliados de qualquer forma; o resto precisa ser especulável
+static int is_select_condition(ASTNode *cond) {
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        return is_select_condition(cond->data.unary_op.operand);
+    }
+    if (cond->type == AST_BINARY_OP && is_relational(cond->data.binary_op.operator)) {
+        return 1;
+    }
+    return is_speculatable(cond);
+}
+
+// O valor de gen_select_condition precisa de uma instrução para virar 0/1
+// verdadeiro quando a condição vale 'truth'? (espelha as formas escolhidas lá)
+static int select_needs_normalize(ASTNode *cond, int truth) {
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        return select_needs_normalize(cond->data.unary_op.operand, !truth);
+    }
+    if (cond->type != AST_BINARY_OP || !is_relational(cond->data.binary_op.operator)) {
+        return !truth;
+    }
+
+    const char *rel = cond->data.binary_op.operator;
+    int constant = cond->data.binary_op.right->type == AST_INTEGER ||
+                   cond->data.binary_op.left->type == AST_INTEGER;
+    if (cond->data.binary_op.left->type == AST_INTEGER) {
+        rel = swap_relation(rel);
+    }
+    if (strcmp(rel, "=") == 0 || strcmp(rel, "/=") == 0) return 1;
+
+    int inverted = strcmp(rel, ">=") == 0 ||
+                   (constant ? strcmp(rel, ">") == 0 : strcmp(rel, "<=") == 0);
+    return inverted == truth;
+}
+
+// Registrador que é diferente de zero exatamente quando a condição vale
+// !*inverted. *flag indica se o valor é 0/1 (senão é só zero/não zero).
+static const char* gen_select_condition(MIPSCodeGen *gen, ASTNode *cond, int *inverted, int *flag) {
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        const char *reg = gen_select_condition(gen, cond->data.unary_op.operand, inverted, flag);
+        *inverted = !*inverted;
+        return reg;
+    }
+
+    *inverted = 0;
+    *flag = 1;
+    if (cond->type != AST_BINARY_OP || !is_relational(cond->data.binary_op.operator)) {
+        return mips_gen_expression(gen, cond);
+    }
+
+    const char *rel = cond->data.binary_op.operator;
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+    int equality = strcmp(rel, "=") == 0 || strcmp(rel, "/=") == 0;
+
+    if (left->type == AST_INTEGER && right->type != AST_INTEGER) {
+        ASTNode *tmp = left;
+        left = right;
+        right = tmp;
+        rel = swap_relation(rel);
+    }
+
+    const char *reg = mips_gen_expression(gen, left);
+    if (!reg) return NULL;
+
+    // a = b e a /= b: a xor b é zero exatamente quando são iguais
+    if (equality) {
+        *inverted = strcmp(rel, "=") == 0;
+        *flag = 0;
+    }
+
+    if (right->type == AST_INTEGER) {
+        long long c = right->data.integer.value;
+        if (equality && c == 0) return reg;
+        if (equality && c > 0 && c <= 0xFFFF) {
+            mips_emit(gen, "    xori %s, %s, %lld\n", reg, reg, c);
+            return reg;
+        }
+        // x <= c e x > c como x < c+1
+        if (!equality) {
+            int below = strcmp(rel, "<=") == 0 || strcmp(rel, ">") == 0;
+            if (below) c++;
+            if (fits_simm16(c)) {
+                mips_emit(gen, "    slti %s, %s, %lld\n", reg, reg, c);
+                *inverted = strcmp(rel, ">=") == 0 || strcmp(rel, ">") == 0;
+                return reg;
+            }
+        }
+    }
+
+    const char *right_reg = mips_gen_expression(gen, right);
+    if (!right_reg) return NULL;
+
+    if (equality) {
+        mips_emit(gen, "    xor %s, %s, %s\n", reg, reg, right_reg);
+    } else {
+        // a < b e a >= b usam slt a,b; a > b e a <= b usam slt b,a
+        int swap = strcmp(rel, ">") == 0 || strcmp(rel, "<=") == 0;
+        mips_emit(gen, "    slt %s, %s, %s\n", reg,
+                  swap ? right_reg : reg, swap ? reg : right_reg);
+        *inverted = strcmp(rel, "<=") == 0 || strcmp(rel, ">=") == 0;
+    }
+    reg_alloc_release(gen->reg_alloc, right_reg);
+    return reg;
+}
+
+// Compara, em unidades de (execuções do if), o custo do código com desvio e
+// o da seleção. Com perfil, usa a fração medida de execuções do braço then
+// e conta como erros as do braço menos frequente; sem perfil, supõe metade
+// para cada braço e um erro do preditor a cada quatro desvios. Tudo é
+// multiplicado por 'total' para ficar em inteiros.
+static int select_pays_off(MIPSCodeGen *gen, ASTNode *then_block, int then_cost, int else_cost,
+                           int jump, int select_cost) {
+    long long total = 4;
+    long long taken = 2;
+    long long missed = 1;
+
+    if (gen->block_count > 0 && then_block && then_block->data.block.profile_count >= 0 &&
+        then_block->data.block.profile_count <= gen->block_count) {
+        total = gen->block_count;
+        taken = then_block->data.block.profile_count;
+        missed = taken < total - taken ? taken : total - taken;
+    }
+
+    long long branch = total * instr_cost[COST_ALU] + taken * (then_cost + jump) +
+                       (total - taken) * else_cost + missed * BRANCH_MISPREDICT_PENALTY;
+    return total * select_cost <= branch;
+}
+
+static int gen_select_if(MIPSCodeGen *gen, ASTNode *node) {
+    ASTNode *cond = node->data.if_stmt.condition;
+    ASTNode *then_block = node->data.if_stmt.then_block;
+    ASTNode *else_block = node->data.if_stmt.else_block;
+    ASTNode *then_assign = single_assignment(then_block);
+    ASTNode *else_assign = single_assignment(else_block);
+
+    if (!is_select_condition(cond)) return 0;
+    if (!then_assign && !else_assign) return 0;
+    if (then_assign && else_assign) {
+        if (strcmp(then_assign->data.assignment.identifier,
+                   else_assign->data.assignment.identifier) != 0) return 0;
+    } else if (!is_empty_arm(then_assign ? else_block : then_block)) {
+        return 0;
+    }
+
+    ASTNode *assign = then_assign ? then_assign : else_assign;
+    Symbol *symbol = symbol_table_lookup(gen->symbol_table, assign->data.assignment.identifier);
+    if (!symbol) return 0;
+
+    int triangle = !then_assign || !else_assign;
+    int step = triangle ? unit_step(assign) : 0;
+    int then_cost = then_assign ? expr_cost(then_assign->data.assignment.expression) : 0;
+    int else_cost = else_assign ? expr_cost(else_assign->data.assignment.expression) : 0;
+    int select_cost;
+
+    if (step) {
+        // lw, add/sub do valor 0/1 e, se preciso, a normalização
+        select_cost = (2 + select_needs_normalize(cond, then_assign != NULL)) * instr_cost[COST_ALU];
+    } else {
+        if ((then_assign && !is_speculatable(then_assign->data.assignment.expression)) ||
+            (else_assign && !is_speculatable(else_assign->data.assignment.expression))) {
+            return 0;
+        }
+        // Braço ausente: carrega o valor antigo; mais o movn/movz
+        select_cost = then_cost + else_cost + (triangle ? instr_cost[COST_LI] : 0) +
+                      instr_cost[COST_ALU];
+    }
+    // O sw é comum aos dois braços de um diamante; num triângulo a seleção
+    // sempre grava, o desvio só quando o braço executa
+    if (triangle) {
+        select_cost += instr_cost[COST_ALU];
+        if (then_assign) then_cost += instr_cost[COST_ALU];
+        else else_cost += instr_cost[COST_ALU];
+    }
+    // O braço then de um diamante termina com j para o fim
+    if (!select_pays_off(gen, then_block, then_cost, else_cost, !triangle, select_cost)) return 0;
+
+    int inverted, flag;
+    const char *cond_reg = gen_select_condition(gen, cond, &inverted, &flag);
+    if (!cond_reg) return 1;
+    // Só o braço else atribui: seleciona com a condição trocada
+    if (!then_assign) inverted = !inverted;
+
+    const char *value_reg;
+    if (step) {
+        // Normaliza para 1 quando o braço executaria e 0 caso contrário
+        if (!flag) {
+            mips_emit(gen, inverted ? "    sltiu %s, %s, 1\n" : "    sltu %s, $zero, %s\n",
+                      cond_reg, cond_reg);
+        } else if (inverted) {
+            mips_emit(gen, "    xori %s, %s, 1\n", cond_reg, cond_reg);
+        }
+
+        // Variável promovida: a soma é feita no próprio registrador
+        const char *home = var_register(gen, symbol);
+        value_reg = home ? home : reg_alloc_acquire(gen->reg_alloc);
+        if (!value_reg) {
+            fprintf(stderr, "Error: No available registers\n");
+            return 1;
+        }
+        ASTNode *expr = assign->data.assignment.expression;
+        if (!home) gen_load_var(gen, value_reg, symbol);
+        mips_emit(gen, "    %s%s %s, %s, %s\n", step > 0 ? "add" : "sub",
+                  expr->data.binary_op.unchecked ? "u" : "", value_reg, value_reg, cond_reg);
+    } else {
+        const char *chosen = gen_operand(gen, assign->data.assignment.expression);
+        const char *other;
+        if (triangle) {
+            // Variável promovida: o movn/movz escreve direto no registrador
+            const char *home = var_register(gen, symbol);
+            other = home ? home : reg_alloc_acquire(gen->reg_alloc);
+            if (other && !home) gen_load_var(gen, other, symbol);
+        } else {
+            other = mips_gen_expression(gen, else_assign->data.assignment.expression);
+        }
+        if (!chosen || !other) {
+            if (!other) fprintf(stderr, "Error: No available registers\n");
+            return 1;
+        }
+
+        // other recebe chosen quando o braço de chosen executaria
+        mips_emit(gen, "    %s %s, %s, %s\n", inverted ? "movz" : "movn", other, chosen, cond_reg);
+        reg_alloc_release(gen->reg_alloc, chosen);
+        value_reg = other;
+    }
+
+    gen_store_var(gen, value_reg, symbol);
+    reg_alloc_release(gen->reg_alloc, value_reg);
+    reg_alloc_release(gen->reg_alloc, cond_reg);
+    return 1;
+}
+
 void mips_gen_if(MIPSCodeGen *gen, ASTNode *node) {
-    const char *else_label = mips_new_label(gen);
-    const char *end_label = mips_new_label(gen);
-    
-    // Avaliar condição
-    const char *cond_reg = mips_gen_expression(gen, node->data.if_stmt.condition);
-    if (!cond_reg) return;
+    if (gen_outlined_if(gen, node)) return;
+    if (gen->options->level > 0 && gen_select_if(gen, node)) return;
+
+    char else_label[32];
+    char end_label[32];
+    strcpy(else_label, mips_new_label(gen));
+    strcpy(end_label, mips_new_label(gen));
     
     // Se condição é falsa, pular para else
-    mips_emit(gen, "    beqz %s, %s\n", cond_reg, else_label);
-    reg_alloc_release(gen->reg_alloc, cond_reg);
+    if (!gen_branch(gen, node->data.if_stmt.condition, else_label, 0)) return;
     
     // Bloco then
     mips_gen_statement(gen, node->data.if_stmt.then_block);
@@ -279,20 +1698,65 @@ void mips_gen_if(MIPSCodeGen *gen, ASTNode *node) {
     mips_emit(gen, "%s:\n", end_label);
 }
 
+// Condições maiores que isto não são duplicadas na rotação de laços
+#define ROTATE_MAX_COND_NODES 8
+
+// Laço rotacionado: o teste fica no fim do corpo, então cada iteração paga
+// um único desvio condicional em vez de beqz + j.
+//
+//     <cond>; beqz Lend          (guarda, executa uma vez)
+//   Lbody:
+//     <corpo>
+//     <cond>; bnez Lbody
+//   Lend:
+//
+// Condições grandes não são duplicadas: a entrada salta direto para o teste.
+static void mips_gen_rotated_while(MIPSCodeGen *gen, ASTNode *node) {
+    ASTNode *cond = node->data.while_stmt.condition;
+    char body_label[32];
+    char end_label[32];
+    char test_label[32] = "";
+    strcpy(body_label, mips_new_label(gen));
+    strcpy(end_label, mips_new_label(gen));
+
+    if (opt_node_count(cond) <= ROTATE_MAX_COND_NODES) {
+        // Guarda de entrada
+        if (!gen_cond_jump(gen, cond, end_label, 0)) return;
+    } else {
+        strcpy(test_label, mips_new_label(gen));
+        mips_emit(gen, "    j %s\n", test_label);
+    }
+
+    // Corpo do loop
+    mips_emit(gen, "%s:\n", body_label);
+    mips_gen_statement(gen, node->data.while_stmt.body);
+
+    // Teste no fim: volta ao corpo enquanto a condição for verdadeira
+    if (test_label[0]) {
+        mips_emit(gen, "%s:\n", test_label);
+    }
+    if (!gen_cond_jump(gen, cond, body_label, 1)) return;
+
+    // Label de fim
+    mips_emit(gen, "%s:\n", end_label);
+}
+
 void mips_gen_while(MIPSCodeGen *gen, ASTNode *node) {
-    const char *start_label = mips_new_label(gen);
-    const char *end_label = mips_new_label(gen);
+    if (gen->options->level > 0) {
+        mips_gen_rotated_while(gen, node);
+        return;
+    }
+
+    char start_label[32];
+    char end_label[32];
+    strcpy(start_label, mips_new_label(gen));
+    strcpy(end_label, mips_new_label(gen));
     
     // Label de início do loop
     mips_emit(gen, "%s:\n", start_label);
     
-    // Avaliar condição
-    const char *cond_reg = mips_gen_expression(gen, node->data.while_stmt.condition);
-    if (!cond_reg) return;
-    
     // Se condição é falsa, sair do loop
-    mips_emit(gen, "    beqz %s, %s\n", cond_reg, end_label);
-    reg_alloc_release(gen->reg_alloc, cond_reg);
+    if (!gen_branch(gen, node->data.while_stmt.condition, end_label, 0)) return;
     
     // Corpo do loop
     mips_gen_statement(gen, node->data.while_stmt.body);
@@ -354,21 +1818,108 @@ void mips_gen_get_line(MIPSCodeGen *gen, ASTNode *node) {
     mips_emit(gen, "    syscall\n");
     
     // Armazenar resultado
-    mips_emit(gen, "    sw $v0, %d($fp)\n", symbol->offset);
+    gen_store_var(gen, "$v0", symbol);
+}
+
+void mips_gen_profile_counter(MIPSCodeGen *gen, ASTNode *node) {
+    const char *base = reg_alloc_acquire(gen->reg_alloc);
+    const char *count = reg_alloc_acquire(gen->reg_alloc);
+    if (!base || !count) {
+        fprintf(stderr, "Error: No available registers\n");
+        return;
+    }
+
+    int offset = 4 * node->data.profile_counter.id;
+    mips_emit(gen, "    la %s, prof_counts\n", base);
+    mips_emit(gen, "    lw %s, %d(%s)\n", count, offset, base);
+    mips_emit(gen, "    addiu %s, %s, 1\n", count, count);
+    mips_emit(gen, "    sw %s, %d(%s)\n", count, offset, base);
+
+    reg_alloc_release(gen->reg_alloc, count);
+    reg_alloc_release(gen->reg_alloc, base);
+}
+
+// Imprime o perfil no formato lido por -fprofile-use
+static void mips_emit_profile_dump(MIPSCodeGen *gen) {
+    const char *ptr = reg_alloc_acquire(gen->reg_alloc);
+    const char *id = reg_alloc_acquire(gen->reg_alloc);
+    const char *limit = reg_alloc_acquire(gen->reg_alloc);
+    if (!ptr || !id || !limit) {
+        fprintf(stderr, "Error: No available registers\n");
+        return;
+    }
+
+    char loop_label[32];
+    strcpy(loop_label, mips_new_label(gen));
+
+    mips_emit(gen, "    # Profile dump\n");
+    mips_emit(gen, "    la $a0, prof_blocks_tag\n");
+    mips_emit(gen, "    li $v0, 4\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    li $a0, %d\n", gen->options->profile_blocks);
+    mips_emit(gen, "    li $v0, 1\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    la $a0, newline\n");
+    mips_emit(gen, "    li $v0, 4\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    la %s, prof_counts\n", ptr);
+    mips_emit(gen, "    li %s, 0\n", id);
+    mips_emit(gen, "    li %s, %d\n", limit, gen->options->profile_blocks);
+    mips_emit(gen, "%s:\n", loop_label);
+    mips_emit(gen, "    la $a0, prof_tag\n");
+    mips_emit(gen, "    li $v0, 4\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    move $a0, %s\n", id);
+    mips_emit(gen, "    li $v0, 1\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    la $a0, prof_sep\n");
+    mips_emit(gen, "    li $v0, 4\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    lw $a0, 0(%s)\n", ptr);
+    mips_emit(gen, "    li $v0, 1\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    la $a0, newline\n");
+    mips_emit(gen, "    li $v0, 4\n");
+    mips_emit(gen, "    syscall\n");
+    mips_emit(gen, "    addiu %s, %s, 4\n", ptr, ptr);
+    mips_emit(gen, "    addiu %s, %s, 1\n", id, id);
+    mips_emit(gen, "    bne %s, %s, %s\n", id, limit, loop_label);
+
+    reg_alloc_release(gen->reg_alloc, limit);
+    reg_alloc_release(gen->reg_alloc, id);
+    reg_alloc_release(gen->reg_alloc, ptr);
 }
 
 void mips_gen_statement(MIPSCodeGen *gen, ASTNode *stmt) {
     if (!stmt) return;
     
     switch (stmt->type) {
-        case AST_BLOCK:
+        case AST_BLOCK: {
+            long long outer = gen->block_count;
+            if (stmt->data.block.profile_count >= 0) {
+                gen->block_count = stmt->data.block.profile_count;
+            }
             for (int i = 0; i < stmt->data.block.count; i++) {
+                if (gen->options->level > 0 && stmt->data.block.statements[i]->type == AST_PUT_LINE) {
+                    int end = put_line_run_end(stmt, i);
+                    put_line_run(gen, stmt, i, end, 1);
+                    i = end - 1;
+                    continue;
+                }
                 mips_gen_statement(gen, stmt->data.block.statements[i]);
             }
+            gen->block_count = outer;
+            break;
+        }
+
+        case AST_PROFILE_COUNTER:
+            mips_gen_profile_counter(gen, stmt);
             break;
             
         case AST_ASSIGNMENT:
-            mips_gen_assignment(gen, stmt);
+            if (!is_static_init(gen, stmt)) {
+                mips_gen_assignment(gen, stmt);
+            }
             break;
             
         case AST_IF_STATEMENT:
@@ -404,16 +1955,24 @@ void mips_emit_text_section(MIPSCodeGen *gen, ASTNode *ast) {
         mips_emit(gen, "main:\n");
         
         // Prólogo
-        mips_emit(gen, "    # Procedure prologue\n");
-        mips_emit(gen, "    addi $sp, $sp, -4\n");
-        mips_emit(gen, "    sw $fp, 0($sp)\n");
-        mips_emit(gen, "    move $fp, $sp\n");
-        
-        // Alocar espaço para variáveis locais
-        // Calcular tamanho necessário baseado na tabela de símbolos
         int frame_size = gen->symbol_table->next_offset;
-        if (frame_size > 0) {
-            mips_emit(gen, "    addi $sp, $sp, -%d\n", frame_size);
+        mips_emit(gen, "    # Procedure prologue\n");
+        if (gen->frame_image) {
+            // Frame estático em .data, já com os valores iniciais
+            mips_emit(gen, "    la $fp, frame\n");
+        } else if (gen->options->level == 0) {
+            mips_emit(gen, "    addi $sp, $sp, -4\n");
+            mips_emit(gen, "    sw $fp, 0($sp)\n");
+            mips_emit(gen, "    move $fp, $sp\n");
+
+            // Alocar espaço para variáveis locais
+            // Calcular tamanho necessário baseado na tabela de símbolos
+            if (frame_size > 0) {
+                mips_emit(gen, "    addi $sp, $sp, -%d\n", frame_size);
+            }
+        }
+        for (int i = 0; i < gen->zero_init_count; i++) {
+            mips_emit(gen, "    move %s, $zero\n", gen->zero_init_regs[i]);
         }
         
         mips_emit(gen, "\n");
@@ -422,27 +1981,127 @@ void mips_emit_text_section(MIPSCodeGen *gen, ASTNode *ast) {
         mips_gen_statement(gen, ast->data.procedure.block);
         
         mips_emit(gen, "\n");
+
+        if (gen->options->profile_generate) {
+            mips_emit_profile_dump(gen);
+            mips_emit(gen, "\n");
+        }
         
-        // Epílogo
+        // Epílogo (o frame estático não tem o que desfazer)
         mips_emit(gen, "    # Procedure epilogue\n");
-        if (frame_size > 0) {
-            mips_emit(gen, "    addi $sp, $sp, %d\n", frame_size);
+        if (gen->options->level == 0) {
+            if (frame_size > 0) {
+                mips_emit(gen, "    addi $sp, $sp, %d\n", frame_size);
+            }
+            mips_emit(gen, "    lw $fp, 0($sp)\n");
+            mips_emit(gen, "    addi $sp, $sp, 4\n");
         }
-        mips_emit(gen, "    lw $fp, 0($sp)\n");
-        mips_emit(gen, "    addi $sp, $sp, 4\n");
         
         // Encerrar programa
         mips_emit(gen, "    li $v0, 10\n");  // syscall exit
         mips_emit(gen, "    syscall\n");
+
+        // Braços frios movidos para fora do caminho quente
+        if (gen->cold) {
+            fflush(gen->cold);
+            if (gen->cold_size > 0) {
+                mips_emit(gen, "\n    # Cold code (profile)\n");
+                fwrite(gen->cold_buffer, 1, gen->cold_size, gen->output);
+            }
+        }
     }
 }
 
-void mips_codegen_generate(MIPSCodeGen *gen, ASTNode *ast) {
-    if (!gen || !ast) return;
+// Acrescenta os slots de spill ao fim do frame estático. Sem frame (todas
+// as variáveis promovidas), cria um só para eles e carrega $fp no prólogo
+static void extend_frame(MIPSCodeGen *gen, AsmBuffer *buf, int spill_words) {
+    if (!gen->frame_image) {
+        for (int i = 0; i < buf->count; i++) {
+            if (strcmp(buf->lines[i].text, "    # Procedure prologue") == 0) {
+                asm_buffer_insert(buf, i + 1, "    la $fp, frame");
+                break;
+            }
+        }
+    }
+
+    gen->frame_image = (int*)realloc(gen->frame_image, (gen->frame_words + spill_words) * sizeof(int));
+    for (int i = 0; i < spill_words; i++) {
+        gen->frame_image[gen->frame_words + i] = 0;
+    }
+    gen->frame_words += spill_words;
+}
+
+int mips_codegen_generate(MIPSCodeGen *gen, ASTNode *ast) {
+    if (!gen || !ast) return 0;
     
     mips_emit(gen, "# Generated MIPS Assembly\n");
     mips_emit(gen, "# Ada to MIPS Compiler\n\n");
     
-    mips_emit_data_section(gen, ast);
+    if (gen->options->level > 0) {
+        promote_variables(gen, ast);
+        find_static_inits(gen, ast);
+    }
+    mips_collect_strings(gen, ast);
+
+    if (gen->options->level == 0) {
+        mips_emit_data_section(gen);
+        mips_emit_text_section(gen, ast);
+        return 1;
+    }
+
+    // Com otimização, o texto é gerado com registradores virtuais e passa
+    // pela alocação, pelo superotimizador (se pedido), pelo threading de
+    // saltos e pela fusão de sufixos antes de ser escrito. A seção .data vem
+    // depois da alocação, que pode aumentar o frame com slots de spill
+    char *text = NULL;
+    size_t size = 0;
+    FILE *output = gen->output;
+    gen->output = open_memstream(&text, &size);
     mips_emit_text_section(gen, ast);
+    fclose(gen->output);
+    gen->output = output;
+
+    AsmBuffer *buf = asm_buffer_parse(text, size);
+    RegAllocStats alloc_stats;
+    int spill_base = gen->frame_image ? 4 * gen->frame_words : 0;
+    if (reg_alloc_assign(gen->reg_alloc, buf, spill_base, &alloc_stats) < 0) {
+        // O texto ainda tem registradores virtuais: nada é escrito
+        asm_buffer_free(buf);
+        free(text);
+        return 0;
+    }
+    if (gen->reg_alloc->stack_offset > 0) {
+        extend_frame(gen, buf, gen->reg_alloc->stack_offset / 4);
+    }
+
+    mips_emit_data_section(gen);
+    if (gen->options->superopt_cache) {
+        SuperoptStats stats;
+        mips_superoptimize(buf, gen->options->superopt_cache, &stats);
+        printf("Superoptimizer: %d rewrite(s), %d cache hit(s), %d search(es), %d skipped\n",
+               stats.rewrites, stats.hits, stats.searches, stats.skipped);
+    }
+    PeepholeStats peephole;
+    printf("Peephole: %d instruction(s) removed\n", mips_peephole(buf, &peephole));
+    for (int r = 0; r < peephole.count; r++) {
+        if (peephole.removed[r] > 0) {
+            printf("  %-12s %d\n", peephole.names[r], peephole.removed[r]);
+        }
+    }
+    mips_thread_jumps(buf);
+    if (mips_merge_tails(buf) > 0) {
+        // Os rótulos de junção que só recebiam os saltos fundidos ficam sem uso
+        mips_thread_jumps(buf);
+    }
+    if (gen->options->delayed_branch) {
+        // Por último: os passes acima não conhecem delay slots
+        ScheduleStats stats;
+        mips_schedule(buf, &stats);
+        printf("Scheduler: %d of %d delay slot(s) filled, %d load stall(s), %d -> %d static cycle(s)\n",
+               stats.filled, stats.branches, stats.load_stalls, stats.cycles_before, stats.cycles_after);
+    }
+    asm_buffer_write(buf, output);
+    asm_buffer_free(buf);
+    free(text);
+    return 1;
 }
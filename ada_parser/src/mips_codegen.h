@@ -5,23 +5,42 @@
 #include "ast.h"
 #include "symbol_table.h"
 #include "register_alloc.h"
+#include "optimizer.h"
+#include "string_pool.h"
+
+// Registradores que guardam variáveis promovidas ($s0-$s7, $v1, $a1-$a3)
+#define MIPS_PROMOTED_MAX 12
 
 // Gerador de código MIPS
 typedef struct {
     FILE *output;
     SymbolTable *symbol_table;
     RegisterAllocator *reg_alloc;
+    const OptimizerOptions *options;
     int label_counter;
-    int string_counter;
+    StringPool *strings;        // Strings da seção .data
+    FILE *cold;                 // Código frio (perfil), emitido depois do epílogo
+    char *cold_buffer;
+    size_t cold_size;
+    long long block_count;      // Execuções do bloco atual segundo o perfil (-1 sem perfil)
+    int *frame_image;           // Valores iniciais de cada slot do frame estático (NULL em -O0)
+    int frame_words;
+    ASTNode **static_inits;     // Atribuições já feitas pela imagem do frame
+    int static_init_count;
+    const char **var_regs;      // Registrador de cada slot do frame (NULL se fica na memória)
+    const char *zero_init_regs[MIPS_PROMOTED_MAX];  // Promovidas lidas antes da primeira escrita
+    int zero_init_count;
+    const char *target;         // Destino pedido para o resultado da próxima operação binária
 } MIPSCodeGen;
 
 // Protótipos das funções
-MIPSCodeGen* mips_codegen_create(FILE *output, SymbolTable *table);
+MIPSCodeGen* mips_codegen_create(FILE *output, SymbolTable *table, const OptimizerOptions *options);
 void mips_codegen_free(MIPSCodeGen *gen);
-void mips_codegen_generate(MIPSCodeGen *gen, ASTNode *ast);
+int mips_codegen_generate(MIPSCodeGen *gen, ASTNode *ast);    // 0 se a geração falhou
 
 // Seções do MIPS
-void mips_emit_data_section(MIPSCodeGen *gen, ASTNode *ast);
+void mips_collect_strings(MIPSCodeGen *gen, ASTNode *ast);
+void mips_emit_data_section(MIPSCodeGen *gen);
 void mips_emit_text_section(MIPSCodeGen *gen, ASTNode *ast);
 
 // Geração de statements
@@ -31,6 +50,7 @@ void mips_gen_if(MIPSCodeGen *gen, ASTNode *node);
 void mips_gen_while(MIPSCodeGen *gen, ASTNode *node);
 void mips_gen_put_line(MIPSCodeGen *gen, ASTNode *node);
 void mips_gen_get_line(MIPSCodeGen *gen, ASTNode *node);
+void mips_gen_profile_counter(MIPSCodeGen *gen, ASTNode *node);
 
 // Geração de expressões (retorna registrador usado)
 const char* mips_gen_expression(MIPSCodeGen *gen, ASTNode *expr);
@@ -38,7 +58,6 @@ const char* mips_gen_binary_op(MIPSCodeGen *gen, ASTNode *node);
 
 // Helpers
 const char* mips_new_label(MIPSCodeGen *gen);
-const char* mips_new_string_label(MIPSCodeGen *gen);
 void mips_emit(MIPSCodeGen *gen, const char *format, ...);
 
 #endif
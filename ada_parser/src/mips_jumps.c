@@ -0,0 +1,235 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Threading de saltos sobre o código gerado.
+//
+// O gerador emite cada construção isoladamente, então um if dentro do braço
+// then de outro termina em "j Lfim_interno" e Lfim_interno cai direto em
+// "j Lfim_externo". Este passe:
+//   - redireciona cada desvio cujo alvo começa com "j X" direto para X,
+//     seguindo a cadeia inteira;
+//   - troca "bcond L1; j L2; L1:" por "b!cond L2; L1:";
+//   - remove "j L" quando L é a próxima instrução;
+//   - remove instruções inalcançáveis depois de um j (até um rótulo usado)
+//     e rótulos Ln que ninguém referencia.
+// Repete até não haver mudanças, então cada caminho executa o menor número
+// de desvios que a estrutura permite.
+
+typedef struct {
+    const char *name;
+    int index;
+    int refs;
+} LabelEntry;
+
+typedef struct {
+    AsmBuffer *buf;
+    char *dead;             // Linhas marcadas para remoção nesta varredura
+    LabelEntry *labels;
+    int label_count;
+} JumpState;
+
+static int compare_labels(const void *a, const void *b) {
+    return strcmp(((const LabelEntry*)a)->name, ((const LabelEntry*)b)->name);
+}
+
+static LabelEntry* find_label(JumpState *st, const char *name) {
+    LabelEntry key = { name, 0, 0 };
+    return (LabelEntry*)bsearch(&key, st->labels, st->label_count, sizeof(LabelEntry), compare_labels);
+}
+
+// Rótulos criados por mips_new_label (os demais, como main, são externos)
+static int is_local_label(const char *name) {
+    if (name[0] != 'L' || !name[1]) return 0;
+    for (const char *p = name + 1; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return 0;
+    }
+    return 1;
+}
+
+static void build_labels(JumpState *st) {
+    AsmBuffer *buf = st->buf;
+    st->label_count = 0;
+    st->labels = (LabelEntry*)realloc(st->labels, (buf->count + 1) * sizeof(LabelEntry));
+
+    for (int i = 0; i < buf->count; i++) {
+        if (buf->lines[i].label[0]) {
+            st->labels[st->label_count].name = buf->lines[i].label;
+            st->labels[st->label_count].index = i;
+            st->labels[st->label_count].refs = 0;
+            st->label_count++;
+        }
+    }
+    qsort(st->labels, st->label_count, sizeof(LabelEntry), compare_labels);
+
+    for (int i = 0; i < buf->count; i++) {
+        if (asm_is_branch(&buf->lines[i])) {
+            LabelEntry *entry = find_label(st, asm_branch_target(&buf->lines[i]));
+            if (entry) entry->refs++;
+        }
+    }
+}
+
+// Próxima instrução viva depois da linha 'from' (-1 se não há); *labels
+// recebe quantos rótulos vivos aparecem no caminho
+static int next_instruction(JumpState *st, int from, int *labels) {
+    if (labels) *labels = 0;
+    for (int i = from + 1; i < st->buf->count; i++) {
+        if (st->dead[i]) continue;
+        if (asm_is_instruction(&st->buf->lines[i])) return i;
+        if (labels && st->buf->lines[i].label[0]) (*labels)++;
+    }
+    return -1;
+}
+
+// O rótulo é definido entre a linha 'from' e a próxima instrução?
+static int label_falls_through(JumpState *st, int from, const char *name) {
+    LabelEntry *entry = find_label(st, name);
+    if (!entry || entry->index <= from || st->dead[entry->index]) return 0;
+
+    int next = next_instruction(st, from, NULL);
+    return next < 0 || entry->index < next;
+}
+
+// Destino final de um salto para 'name', seguindo rótulos que começam com j
+static const char* resolve(JumpState *st, const char *name) {
+    for (int hops = 0; hops < st->label_count; hops++) {
+        LabelEntry *entry = find_label(st, name);
+        if (!entry) break;
+
+        int next = next_instruction(st, entry->index, NULL);
+        if (next < 0 || !asm_is_jump(&st->buf->lines[next])) break;
+
+        const char *target = asm_branch_target(&st->buf->lines[next]);
+        if (strcmp(target, name) == 0) break;
+        name = target;
+    }
+    return name;
+}
+
+static void retarget(JumpState *st, AsmLine *line, const char *label) {
+    LabelEntry *old_entry = find_label(st, asm_branch_target(line));
+    LabelEntry *new_entry = find_label(st, label);
+    if (old_entry) old_entry->refs--;
+    if (new_entry) new_entry->refs++;
+
+    // O rótulo aponta para o texto de outra linha, que pode ser reescrita
+    char copy[ASM_ARG_SIZE];
+    strcpy(copy, label);
+    asm_set_branch_target(line, copy);
+}
+
+static void kill_line(JumpState *st, int index) {
+    AsmLine *line = &st->buf->lines[index];
+    if (asm_is_branch(line)) {
+        LabelEntry *entry = find_label(st, asm_branch_target(line));
+        if (entry) entry->refs--;
+    }
+    st->dead[index] = 1;
+}
+
+static int sweep(JumpState *st) {
+    AsmBuffer *buf = st->buf;
+    int changes = 0;
+
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        if (st->dead[i] || !asm_is_branch(line)) continue;
+
+        // Cadeias de saltos: vai direto ao destino final
+        const char *final = resolve(st, asm_branch_target(line));
+        if (strcmp(final, asm_branch_target(line)) != 0) {
+            retarget(st, line, final);
+            changes++;
+        }
+
+        if (asm_is_jump(line)) {
+            // Salto para a instrução seguinte
+            if (label_falls_through(st, i, asm_branch_target(line))) {
+                kill_line(st, i);
+                changes++;
+                continue;
+            }
+
+            // Código depois do salto só é alcançável por um rótulo usado
+            for (int k = i + 1; k < buf->count; k++) {
+                AsmLine *next = &buf->lines[k];
+                if (st->dead[k]) continue;
+                if (next->label[0]) {
+                    LabelEntry *entry = find_label(st, next->label);
+                    if (!is_local_label(next->label) || (entry && entry->refs > 0)) break;
+                } else if (asm_is_instruction(next)) {
+                    kill_line(st, k);
+                    changes++;
+                }
+            }
+            continue;
+        }
+
+        // "bcond L1; j L2; L1:" -> "b!cond L2; L1:"
+        int between;
+        int next = next_instruction(st, i, &between);
+        if (next < 0 || between > 0 || !asm_is_jump(&buf->lines[next])) continue;
+        if (!label_falls_through(st, next, asm_branch_target(line))) continue;
+
+        const char *inverted = asm_inverted_branch(line->op);
+        char target[ASM_ARG_SIZE];
+        strcpy(target, asm_branch_target(&buf->lines[next]));
+
+        LabelEntry *old_entry = find_label(st, asm_branch_target(line));
+        if (old_entry) old_entry->refs--;
+        kill_line(st, next);
+
+        const char *args[ASM_MAX_ARGS];
+        char copy[ASM_MAX_ARGS][ASM_ARG_SIZE];
+        for (int a = 0; a < line->arg_count; a++) {
+            strcpy(copy[a], a == line->arg_count - 1 ? target : line->args[a]);
+            args[a] = copy[a];
+        }
+        asm_set_instruction(line, inverted, line->arg_count, args);
+
+        LabelEntry *new_entry = find_label(st, target);
+        if (new_entry) new_entry->refs++;
+        changes++;
+    }
+
+    // Rótulos locais sem referências
+    for (int l = 0; l < st->label_count; l++) {
+        LabelEntry *entry = &st->labels[l];
+        if (entry->refs == 0 && is_local_label(entry->name) && !st->dead[entry->index]) {
+            st->dead[entry->index] = 1;
+            changes++;
+        }
+    }
+    return changes;
+}
+
+int mips_thread_jumps(AsmBuffer *buf) {
+    JumpState st;
+    st.buf = buf;
+    st.dead = NULL;
+    st.labels = NULL;
+    st.label_count = 0;
+
+    int total = 0;
+    int changes;
+    do {
+        st.dead = (char*)realloc(st.dead, buf->count + 1);
+        memset(st.dead, 0, buf->count + 1);
+        build_labels(&st);
+
+        changes = sweep(&st);
+        total += changes;
+
+        // Remove as linhas marcadas (de trás para frente: os índices não mudam)
+        for (int i = buf->count - 1; i >= 0; i--) {
+            if (st.dead[i]) asm_buffer_remove(buf, i);
+        }
+    } while (changes > 0);
+
+    free(st.labels);
+    free(st.dead);
+    return total;
+}
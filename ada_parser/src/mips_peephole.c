@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Otimização peephole sobre o código já alocado.
+//
+// Uma tabela de regras é aplicada a janelas de instruções seguidas (sem
+// rótulo no meio, já que outro caminho poderia entrar ali). Cada regra olha
+// as primeiras instruções da janela e, se casar, reescreve o trecho e
+// retorna quantas instruções removeu:
+//
+//     sw $t0, 8($fp)              sw $t0, 8($fp)
+//     lw $t0, 8($fp)       ->
+//
+//     li $t1, 12                  addi $t0, $t0, 12
+//     add $t0, $t0, $t1    ->
+//
+//     lw $t0, 44($fp)             lw $a0, 44($fp)
+//     move $a0, $t0        ->
+//
+// Reescritas que descartam o valor de um registrador dependem de ele estar
+// morto depois do trecho; isso é verificado seguindo o fluxo (quedas e
+// alvos dos desvios) até uma escrita ou uma leitura do registrador.
+
+#define PEEPHOLE_WINDOW 2
+
+static void set_args(AsmLine *line, const char *op, int count, char args[][ASM_ARG_SIZE]) {
+    const char *list[ASM_MAX_ARGS];
+    for (int k = 0; k < count; k++) list[k] = args[k];
+    asm_set_instruction(line, op, count, list);
+}
+
+static int fits_simm16(long long c) {
+    return c >= -32768 && c <= 32767;
+}
+
+// "li $x, c" com o valor em 'value'
+static int is_li(const AsmLine *line, long long *value) {
+    if (strcmp(line->op, "li") != 0 || line->arg_count != 2) return 0;
+    char *end;
+    *value = strtoll(line->args[1], &end, 0);
+    return *end == '\0';
+}
+
+// Regras. at[] tem as linhas da janela (at[1] < 0 se a janela tem uma só)
+
+// move $r, $r
+static int rule_self_move(AsmBuffer *buf, const int *at) {
+    AsmLine *line = &buf->lines[at[0]];
+    if (strcmp(line->op, "move") != 0 || strcmp(line->args[0], line->args[1]) != 0) return 0;
+    asm_buffer_remove(buf, at[0]);
+    return 1;
+}
+
+// sw $r, A; lw $r, A -> sw $r, A
+static int rule_store_load(AsmBuffer *buf, const int *at) {
+    if (at[1] < 0) return 0;
+    AsmLine *sw = &buf->lines[at[0]], *lw = &buf->lines[at[1]];
+    if (strcmp(sw->op, "sw") != 0 || strcmp(lw->op, "lw") != 0) return 0;
+    if (strcmp(sw->args[0], lw->args[0]) != 0 || strcmp(sw->args[1], lw->args[1]) != 0) return 0;
+    asm_buffer_remove(buf, at[1]);
+    return 1;
+}
+
+// lw $r, A; sw $r, A -> lw $r, A (o endereço já tem o valor)
+static int rule_load_store(AsmBuffer *buf, const int *at) {
+    if (at[1] < 0) return 0;
+    AsmLine *lw = &buf->lines[at[0]], *sw = &buf->lines[at[1]];
+    if (strcmp(lw->op, "lw") != 0 || strcmp(sw->op, "sw") != 0) return 0;
+    if (strcmp(lw->args[0], sw->args[0]) != 0 || strcmp(lw->args[1], sw->args[1]) != 0) return 0;
+    if (strstr(lw->args[1], lw->args[0])) return 0;     // lw $t0, 0($t0)
+    asm_buffer_remove(buf, at[1]);
+    return 1;
+}
+
+// sw $r, A; sw $s, A -> sw $s, A
+static int rule_dead_store(AsmBuffer *buf, const int *at) {
+    if (at[1] < 0) return 0;
+    AsmLine *a = &buf->lines[at[0]], *b = &buf->lines[at[1]];
+    if (strcmp(a->op, "sw") != 0 || strcmp(b->op, "sw") != 0) return 0;
+    if (strcmp(a->args[1], b->args[1]) != 0) return 0;
+    asm_buffer_remove(buf, at[0]);
+    return 1;
+}
+
+// li $x, c; OP ..., $x -> OP ..., c (forma imediata) ou $zero quando c = 0
+static int rule_li_operand(AsmBuffer *buf, const int *at) {
+    if (at[1] < 0) return 0;
+    AsmLine *li = &buf->lines[at[0]], *use = &buf->lines[at[1]];
+    long long c;
+    if (!is_li(li, &c)) return 0;
+
+    const char *x = li->args[0];
+    if (!asm_reads_reg(use, x) || strcmp(use->op, "syscall") == 0) return 0;
+    for (int k = 0; k < use->arg_count; k++) {
+        if (strchr(use->args[k], '(') && asm_operand_reads(use, k, x)) return 0;
+    }
+    if (!asm_writes_reg(use, x) && asm_live_after(buf, at[1], x)) return 0;
+
+    char args[ASM_MAX_ARGS][ASM_ARG_SIZE];
+    int count = use->arg_count;
+    for (int k = 0; k < count; k++) strcpy(args[k], use->args[k]);
+    char op[16];
+    strcpy(op, use->op);
+
+    if (c == 0) {
+        // Zero: o próprio $zero substitui o registrador
+        for (int k = 0; k < count; k++) {
+            if (asm_operand_reads(use, k, x)) strcpy(args[k], "$zero");
+        }
+    } else {
+        // Forma imediata: OP $d, $a, $x (ou $x, $a nos comutativos)
+        static const struct { const char *op, *imm; int commutative, unsigned_imm, negate; } forms[] = {
+            { "add",  "addi",  1, 0, 0 },
+            { "addu", "addiu", 1, 0, 0 },
+            { "sub",  "addi",  0, 0, 1 },
+            { "subu", "addiu", 0, 0, 1 },
+            { "slt",  "slti",  0, 0, 0 },
+            { "sltu", "sltiu", 0, 0, 0 },
+            { "and",  "andi",  1, 1, 0 },
+            { "or",   "ori",   1, 1, 0 },
+            { "xor",  "xori",  1, 1, 0 },
+        };
+        if (count != 3) return 0;
+
+        int f = -1;
+        for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); i++) {
+            if (strcmp(forms[i].op, op) == 0) f = (int)i;
+        }
+        if (f < 0) return 0;
+
+        const char *other;
+        if (strcmp(args[2], x) == 0 && strcmp(args[1], x) != 0) {
+            other = args[1];
+        } else if (forms[f].commutative && strcmp(args[1], x) == 0 && strcmp(args[2], x) != 0) {
+            other = args[2];
+        } else {
+            return 0;
+        }
+
+        long long imm = forms[f].negate ? -c : c;
+        if (forms[f].unsigned_imm ? (imm < 0 || imm > 0xFFFF) : !fits_simm16(imm)) return 0;
+
+        char source[ASM_ARG_SIZE];
+        strcpy(source, other);
+        strcpy(args[1], source);
+        snprintf(args[2], ASM_ARG_SIZE, "%lld", imm);
+        strcpy(op, forms[f].imm);
+    }
+
+    set_args(use, op, count, args);
+    asm_buffer_remove(buf, at[0]);
+    return 1;
+}
+
+// OP $t, ...; move $d, $t -> OP $d, ... quando $t morre no move
+static int rule_retarget(AsmBuffer *buf, const int *at) {
+    if (at[1] < 0) return 0;
+    AsmLine *def = &buf->lines[at[0]], *move = &buf->lines[at[1]];
+    if (strcmp(move->op, "move") != 0 || def->arg_count == 0) return 0;
+
+    const char *t = move->args[1];
+    const char *d = move->args[0];
+    if (!asm_writes_reg(def, t) || strcmp(d, "$zero") == 0) return 0;
+    if (strchr(def->args[0], '(')) return 0;
+
+    // As pseudo-instruções podem escrever o destino antes de ler tudo
+    if (asm_reads_reg(def, d)) return 0;
+    if (asm_live_after(buf, at[1], t)) return 0;
+
+    char args[ASM_MAX_ARGS][ASM_ARG_SIZE];
+    char op[16];
+    strcpy(op, def->op);
+    for (int k = 0; k < def->arg_count; k++) strcpy(args[k], def->args[k]);
+    strcpy(args[0], d);
+    set_args(def, op, def->arg_count, args);
+    asm_buffer_remove(buf, at[1]);
+    return 1;
+}
+
+// Desvio ou j para o rótulo logo adiante
+static int rule_jump_next(AsmBuffer *buf, const int *at) {
+    AsmLine *line = &buf->lines[at[0]];
+    if (!asm_is_branch(line)) return 0;
+    for (int i = at[0] + 1; i < buf->count; i++) {
+        AsmLine *next = &buf->lines[i];
+        if (strcmp(next->label, asm_branch_target(line)) == 0) {
+            asm_buffer_remove(buf, at[0]);
+            return 1;
+        }
+        if (asm_is_instruction(next)) break;
+    }
+    return 0;
+}
+
+typedef struct {
+    const char *name;
+    int (*apply)(AsmBuffer *buf, const int *at);
+} PeepholeRule;
+
+static const PeepholeRule rules[] = {
+    { "self-move",   rule_self_move },
+    { "store-load",  rule_store_load },
+    { "load-store",  rule_load_store },
+    { "dead-store",  rule_dead_store },
+    { "li-operand",  rule_li_operand },
+    { "retarget",    rule_retarget },
+    { "jump-next",   rule_jump_next },
+};
+
+#define RULE_COUNT (int)(sizeof(rules) / sizeof(rules[0]))
+
+int mips_peephole(AsmBuffer *buf, PeepholeStats *stats) {
+    stats->count = RULE_COUNT;
+    for (int r = 0; r < RULE_COUNT; r++) {
+        stats->names[r] = rules[r].name;
+        stats->removed[r] = 0;
+    }
+
+    int total = 0;
+    for (int i = 0; i < buf->count; i++) {
+        if (!asm_is_instruction(&buf->lines[i])) continue;
+
+        // Janela: a instrução i e as seguintes até um rótulo
+        int at[PEEPHOLE_WINDOW];
+        int n = 0;
+        for (int j = i; j < buf->count && n < PEEPHOLE_WINDOW; j++) {
+            AsmLine *line = &buf->lines[j];
+            if (line->label[0] && j > i) break;
+            if (asm_is_instruction(line)) at[n++] = j;
+        }
+        for (int k = n; k < PEEPHOLE_WINDOW; k++) at[k] = -1;
+
+        for (int r = 0; r < RULE_COUNT; r++) {
+            int removed = rules[r].apply(buf, at);
+            if (removed > 0) {
+                stats->removed[r] += removed;
+                total += removed;
+                // A reescrita pode formar um padrão com a instrução anterior
+                i = i > 1 ? i - 2 : -1;
+                break;
+            }
+        }
+    }
+    return total;
+}
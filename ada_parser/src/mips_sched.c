@@ -0,0 +1,423 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Escalonamento para ".set noreorder" (-fdelayed-branch).
+//
+// Sem ".set noreorder" o montador cobre os hazards do pipeline clássico de
+// cinco estágios sozinho: põe um nop no delay slot de cada desvio e entre um
+// lw e a instrução seguinte quando ela lê o registrador carregado. Este passe
+// assume esse trabalho:
+//   - cada bloco básico passa por um escalonador de lista sobre o grafo de
+//     dependências (registradores, memória, HI/LO, syscalls), com prioridade
+//     pelo caminho crítico, o que afasta os lw dos seus usos;
+//   - o desvio que fecha o bloco fica por último e o delay slot recebe uma
+//     instrução do bloco da qual nada mais depende:
+//
+//         addiu $s5, $s5, 1            addiu $s5, $s5, 1
+//         addiu $s6, $s6, 3            slti $t0, $s5, 14
+//         slti $t0, $s5, 14     ->     bnez $t0, L0
+//         bnez $t0, L0                 addiu $s6, $s6, 3
+//
+//   - onde nada serve, entra um nop explícito.
+// O modelo do pipeline (um ciclo por instrução, mais um por delay slot vazio
+// e por uso logo depois de um lw) dá o custo estático antes e depois.
+
+#define SCHED_MAX_BLOCK 256
+#define SCHED_MAX_REGS 4
+
+typedef struct {
+    char uses[SCHED_MAX_REGS][ASM_ARG_SIZE];
+    char defs[2][ASM_ARG_SIZE];
+    int use_count;
+    int def_count;
+    int load;           // lw: o resultado só pode ser lido duas instruções depois
+    int store;
+    int barrier;        // syscall e afins: nada passa por cima
+    int trap;           // Pode gerar exceção: mantém a ordem entre elas
+} SchedInfo;
+
+static int op_in(const char *op, const char *const *list) {
+    for (int i = 0; list[i]; i++) {
+        if (strcmp(op, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_load(const AsmLine *line) {
+    return strcmp(line->op, "lw") == 0;
+}
+
+static void add_reg(char regs[][ASM_ARG_SIZE], int *count, int max, const char *reg) {
+    if (strcmp(reg, "$zero") == 0 || *count >= max) return;
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(regs[i], reg) == 0) return;
+    }
+    strcpy(regs[(*count)++], reg);
+}
+
+static void analyze(const AsmLine *line, SchedInfo *info) {
+    static const char *const traps[] = { "add", "sub", "addi", "neg", "div", "rem", "teq", "break", NULL };
+    static const char *const barriers[] = { "syscall", "break", "jal", "jr", NULL };
+    static const char *const hi_writers[] = { "mult", "multu", "mul", "div", "divu", "rem", "remu", NULL };
+    static const char *const hi_readers[] = { "mfhi", "mflo", "div", "divu", "rem", "remu", NULL };
+
+    memset(info, 0, sizeof(*info));
+    for (int k = 0; k < line->arg_count; k++) {
+        int role = asm_operand_role(line, k);
+        const char *arg = line->args[k];
+        const char *paren = strchr(arg, '(');
+        if (paren) {
+            char base[ASM_ARG_SIZE];
+            snprintf(base, sizeof(base), "%s", paren + 1);
+            char *close = strchr(base, ')');
+            if (close) *close = '\0';
+            add_reg(info->uses, &info->use_count, SCHED_MAX_REGS, base);
+            continue;
+        }
+        if (role & ASM_USE) add_reg(info->uses, &info->use_count, SCHED_MAX_REGS, arg);
+        if (role & ASM_DEF) add_reg(info->defs, &info->def_count, 2, arg);
+    }
+
+    // HI/LO como um registrador a mais; div de três operandos lê o resultado (mflo)
+    if (op_in(line->op, hi_writers)) add_reg(info->defs, &info->def_count, 2, "hi");
+    if (op_in(line->op, hi_readers) && !(strcmp(line->op, "div") == 0 && line->arg_count == 2)) {
+        add_reg(info->uses, &info->use_count, SCHED_MAX_REGS, "hi");
+    }
+
+    // syscall: os registradores de asm_syscall_uses; read_int escreve $v0
+    if (strcmp(line->op, "syscall") == 0) {
+        for (int k = 0; asm_syscall_uses[k]; k++) {
+            add_reg(info->uses, &info->use_count, SCHED_MAX_REGS, asm_syscall_uses[k]);
+        }
+        add_reg(info->defs, &info->def_count, 2, "$v0");
+    }
+
+    info->load = is_load(line);
+    info->store = strcmp(line->op, "sw") == 0;
+    info->barrier = op_in(line->op, barriers);
+    info->trap = op_in(line->op, traps) && !(strcmp(line->op, "div") == 0 && line->arg_count == 2);
+}
+
+static int reads(const SchedInfo *info, const char *reg) {
+    for (int i = 0; i < info->use_count; i++) {
+        if (strcmp(info->uses[i], reg) == 0) return 1;
+    }
+    return 0;
+}
+
+static int writes(const SchedInfo *info, const char *reg) {
+    for (int i = 0; i < info->def_count; i++) {
+        if (strcmp(info->defs[i], reg) == 0) return 1;
+    }
+    return 0;
+}
+
+// "off($fp)"/"off($sp)" com o mesmo registrador base e offsets diferentes
+static int disjoint(const char *a, const char *b) {
+    const char *pa = strchr(a, '('), *pb = strchr(b, '(');
+    if (!pa || !pb || strcmp(pa, pb) != 0) return 0;
+    if (strcmp(pa, "($fp)") != 0 && strcmp(pa, "($sp)") != 0) return 0;
+    return atoi(a) != atoi(b);
+}
+
+// Latência da dependência de j (posterior) em i, ou 0 se são independentes
+static int dependence(const AsmLine *li, const SchedInfo *i, const AsmLine *lj, const SchedInfo *j,
+                      int base_written) {
+    int latency = 0;
+    for (int k = 0; k < i->def_count; k++) {
+        if (reads(j, i->defs[k])) {
+            return i->load ? 2 : 1;
+        }
+        if (writes(j, i->defs[k])) latency = 1;
+    }
+    for (int k = 0; k < i->use_count; k++) {
+        if (writes(j, i->uses[k])) latency = 1;
+    }
+    if (i->barrier || j->barrier || (i->trap && j->trap)) latency = 1;
+    if ((i->store && (j->load || j->store)) || (i->load && j->store)) {
+        if (base_written || !disjoint(li->args[1], lj->args[1])) latency = 1;
+    }
+    return latency;
+}
+
+// Cabe no delay slot: uma única instrução de máquina, sem desvio nem lw.
+// mfhi/mflo também ficam de fora: no slot de um desvio tomado, o mult/div
+// seguinte está no alvo, onde insert_hazard_nops não olha
+static int slot_safe(const AsmLine *line, const SchedInfo *info) {
+    static const char *const alu[] = {
+        "add", "addu", "sub", "subu", "and", "or", "xor", "nor", "slt", "sltu",
+        "sllv", "srlv", "srav", "move", "mult", "multu", "mul",
+        "neg", "negu", "not", "movn", "movz", NULL
+    };
+    static const char *const imm[] = {
+        "addi", "addiu", "andi", "ori", "xori", "slti", "sltiu", "sll", "srl", "sra", "lui", NULL
+    };
+    if (info->barrier) return 0;
+    if (op_in(line->op, alu)) {
+        for (int k = 0; k < line->arg_count; k++) {
+            if (line->args[k][0] != '$') return 0;
+        }
+        return 1;
+    }
+    if (op_in(line->op, imm)) return 1;
+    if (strcmp(line->op, "li") == 0) {
+        char *end;
+        long long value = strtoll(line->args[1], &end, 0);
+        return *end == '\0' && value >= -32768 && value <= 65535;
+    }
+    if (strcmp(line->op, "sw") == 0) {
+        const char *paren = strchr(line->args[1], '(');
+        int offset = atoi(line->args[1]);
+        return paren && offset >= -32768 && offset <= 32767;
+    }
+    return 0;
+}
+
+// Ciclos do trecho no modelo do pipeline: o que o montador pagaria em
+// modo reorder, ou as instruções (com os nops) em noreorder
+static int pipeline_cycles(AsmBuffer *buf, int reorder) {
+    int cycles = 0;
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        if (!asm_is_instruction(line)) continue;
+        cycles++;
+        if (!reorder) continue;
+        if (asm_is_branch(line)) cycles++;
+        AsmLine *next = asm_next_instruction(buf, i + 1, NULL);
+        if (is_load(line) && next) {
+            SchedInfo info;
+            analyze(next, &info);
+            if (reads(&info, line->args[0])) cycles++;
+        }
+    }
+    return cycles;
+}
+
+// Escalona o bloco de instruções nas linhas at[0..n-1]; a última pode ser
+// o desvio que o fecha. Retorna quantas linhas foram inseridas (nop)
+static int schedule_block(AsmBuffer *buf, const int *at, int n, ScheduleStats *stats) {
+    SchedInfo info[SCHED_MAX_BLOCK];
+    static unsigned char lat[SCHED_MAX_BLOCK][SCHED_MAX_BLOCK];
+    int prio[SCHED_MAX_BLOCK], earliest[SCHED_MAX_BLOCK], preds[SCHED_MAX_BLOCK];
+    int order[SCHED_MAX_BLOCK], done[SCHED_MAX_BLOCK];
+
+    for (int i = 0; i < n; i++) analyze(&buf->lines[at[i]], &info[i]);
+    int term = asm_is_branch(&buf->lines[at[n - 1]]) ? n - 1 : -1;
+
+    // Bases de endereço escritas no bloco invalidam a comparação de offsets
+    int fp_written = 0;
+    for (int i = 0; i < n; i++) {
+        if (writes(&info[i], "$fp") || writes(&info[i], "$sp")) fp_written = 1;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            lat[i][j] = j > i ? dependence(&buf->lines[at[i]], &info[i],
+                                           &buf->lines[at[j]], &info[j], fp_written) : 0;
+        }
+    }
+
+    // Preenchimento do delay slot: a última instrução de que nada depende
+    int filler = -1;
+    for (int c = term - 1; c >= 0 && filler < 0; c--) {
+        int free = slot_safe(&buf->lines[at[c]], &info[c]);
+        for (int j = c + 1; j < n && free; j++) {
+            if (lat[c][j]) free = 0;
+        }
+        if (free) filler = c;
+    }
+
+    // Prioridade: caminho mais longo até o fim do bloco
+    for (int i = n - 1; i >= 0; i--) {
+        prio[i] = 1;
+        for (int j = i + 1; j < n; j++) {
+            if (lat[i][j] && lat[i][j] + prio[j] > prio[i]) prio[i] = lat[i][j] + prio[j];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        earliest[i] = 0;
+        done[i] = i == filler;
+        preds[i] = 0;
+        for (int p = 0; p < i; p++) {
+            if (lat[p][i]) preds[i]++;
+        }
+    }
+
+    // Escalonador de lista: entre as prontas, a de maior prioridade que já
+    // pode executar sem esperar; se nenhuma pode, a de maior prioridade
+    int total = n - (filler >= 0), cycle = 0;
+    for (int s = 0; s < total; s++) {
+        int best = -1, best_waits = 0;
+        for (int i = 0; i < n; i++) {
+            if (done[i] || preds[i] > 0) continue;
+            if (i == term && s < total - 1) continue;
+            int waits = earliest[i] > cycle;
+            if (best < 0 || waits < best_waits || (waits == best_waits && prio[i] > prio[best])) {
+                best = i;
+                best_waits = waits;
+            }
+        }
+        order[s] = best;
+        done[best] = 1;
+        if (earliest[best] > cycle) cycle = earliest[best];
+        for (int j = best + 1; j < n; j++) {
+            if (lat[best][j]) {
+                preds[j]--;
+                if (cycle + lat[best][j] > earliest[j]) earliest[j] = cycle + lat[best][j];
+            }
+        }
+        cycle++;
+    }
+    if (filler >= 0) order[total] = filler;
+
+    AsmLine lines[SCHED_MAX_BLOCK];
+    for (int s = 0; s < n; s++) lines[s] = buf->lines[at[order[s]]];
+    for (int s = 0; s < n; s++) buf->lines[at[s]] = lines[s];
+
+    if (term < 0) return 0;
+    stats->branches++;
+    if (filler >= 0) {
+        stats->filled++;
+        return 0;
+    }
+    asm_buffer_insert(buf, at[n - 1] + 1, "    nop");
+    return 1;
+}
+
+// Nops que o escalonamento não evitou: uso logo depois de um lw e
+// mult/div a menos de duas instruções de um mfhi/mflo
+static void insert_hazard_nops(AsmBuffer *buf, ScheduleStats *stats) {
+    static const char *const hi_writers[] = { "mult", "multu", "mul", "div", "divu", "rem", "remu", NULL };
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        if (!asm_is_instruction(line)) continue;
+
+        int j;
+        AsmLine *next = asm_next_instruction(buf, i + 1, &j);
+        if (!next) break;
+        if (is_load(line)) {
+            SchedInfo info;
+            analyze(next, &info);
+            if (reads(&info, line->args[0])) {
+                asm_buffer_insert(buf, i + 1, "    nop");
+                stats->load_stalls++;
+            }
+        } else if (strcmp(line->op, "mfhi") == 0 || strcmp(line->op, "mflo") == 0) {
+            int before = i;
+            for (int d = 1; d <= 2 && next; d++) {
+                if (op_in(next->op, hi_writers)) {
+                    // Um nop não pode separar o desvio do seu delay slot
+                    int at = asm_is_branch(&buf->lines[before]) ? before : j;
+                    for (int k = d; k <= 2; k++) asm_buffer_insert(buf, at, "    nop");
+                    break;
+                }
+                before = j;
+                next = asm_next_instruction(buf, j + 1, &j);
+            }
+        }
+    }
+}
+
+// Pode executar num caminho que antes não a executava: não grava memória,
+// não gera exceção e seus resultados estão mortos a partir de 'from'
+static int harmless_at(AsmBuffer *buf, const AsmLine *line, int from) {
+    SchedInfo info;
+    analyze(line, &info);
+    if (info.store || info.trap || info.load || !slot_safe(line, &info)) return 0;
+    for (int k = 0; k < info.def_count; k++) {
+        if (strcmp(info.defs[k], "hi") == 0 || asm_live_at(buf, from, info.defs[k], 1)) return 0;
+    }
+    return 1;
+}
+
+// Delay slot ainda vazio depois do desvio na linha 'branch': tenta a
+// primeira instrução do alvo (o desvio passa a ir para depois dela) ou,
+// num desvio condicional, a primeira do caminho que cai direto
+static int fill_from_successors(AsmBuffer *buf, int branch, int *next_label) {
+    AsmLine *line = &buf->lines[branch];
+    int slot = branch + 1;
+    int conditional = !asm_is_jump(line);
+    int label = asm_find_label(buf, asm_branch_target(line));
+    if (label < 0) return 0;
+
+    int first;
+    AsmLine *target = asm_next_instruction(buf, label + 1, &first);
+    int from_target = target && first != branch && first != slot;
+    for (int i = label + 1; from_target && i < first; i++) {
+        if (buf->lines[i].label[0]) from_target = 0;
+    }
+    if (from_target) {
+        SchedInfo info;
+        analyze(target, &info);
+        from_target = slot_safe(target, &info) && !info.load && !asm_is_branch(target) &&
+                      (!conditional || harmless_at(buf, target, slot + 1));
+    }
+
+    int next = -1;
+    AsmLine *fall = conditional ? asm_next_instruction(buf, slot + 1, &next) : NULL;
+    int from_fall = fall && !asm_is_branch(fall);
+    for (int i = slot + 1; from_fall && i <= next; i++) {
+        if (buf->lines[i].label[0]) from_fall = 0;
+    }
+    from_fall = from_fall && harmless_at(buf, fall, label);
+
+    // Num laço (alvo para trás) o caminho quente é o desvio tomado
+    if (from_target && (label < branch || !from_fall)) {
+        char name[ASM_ARG_SIZE], label_line[ASM_ARG_SIZE + 2];
+        snprintf(name, sizeof(name), "L%d", (*next_label)++);
+        snprintf(label_line, sizeof(label_line), "%s:", name);
+
+        const char *args[ASM_MAX_ARGS];
+        for (int k = 0; k < target->arg_count; k++) args[k] = target->args[k];
+        asm_set_instruction(&buf->lines[slot], target->op, target->arg_count, args);
+        asm_set_branch_target(&buf->lines[branch], name);
+        asm_buffer_insert(buf, first + 1, label_line);
+        return 1;
+    }
+    if (from_fall) {
+        const char *args[ASM_MAX_ARGS];
+        for (int k = 0; k < fall->arg_count; k++) args[k] = fall->args[k];
+        asm_set_instruction(&buf->lines[slot], fall->op, fall->arg_count, args);
+        asm_buffer_remove(buf, next);
+        return 1;
+    }
+    return 0;
+}
+
+int mips_schedule(AsmBuffer *buf, ScheduleStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->cycles_before = pipeline_cycles(buf, 1);
+
+    int at[SCHED_MAX_BLOCK];
+    int n = 0;
+    int text = -1;
+    for (int i = 0; i <= buf->count; i++) {
+        AsmLine *line = i < buf->count ? &buf->lines[i] : NULL;
+        if (line && text < 0 && strstr(line->text, ".globl")) text = i;
+
+        // Rótulos, comentários e diretivas separam os blocos; linhas vazias não
+        int instruction = line && asm_is_instruction(line);
+        int boundary = !line || (!instruction && line->text[strspn(line->text, " \t")] != '\0');
+        if (instruction) at[n++] = i;
+        if (n > 0 && (boundary || asm_is_branch(line) || n == SCHED_MAX_BLOCK)) {
+            i += schedule_block(buf, at, n, stats);
+            n = 0;
+        }
+    }
+
+    // Delay slots que o próprio bloco não preencheu
+    int next_label = asm_max_label_number(buf) + 1;
+    for (int i = 0; i + 1 < buf->count; i++) {
+        if (asm_is_branch(&buf->lines[i]) && strcmp(buf->lines[i + 1].op, "nop") == 0 &&
+            fill_from_successors(buf, i, &next_label)) {
+            stats->filled++;
+        }
+    }
+
+    insert_hazard_nops(buf, stats);
+    if (text >= 0) asm_buffer_insert(buf, text + 1, ".set noreorder");
+    stats->cycles_after = pipeline_cycles(buf, 0);
+    return stats->filled;
+}
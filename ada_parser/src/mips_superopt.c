@@ -0,0 +1,1254 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+// Superotimização enumerativa (-fsuperopt).
+//
+// Procura trechos de até SUPEROPT_MAX_WINDOW instruções aritméticas e lógicas
+// seguidas (sem acesso à memória, desvios ou instruções que geram exceção,
+// como add e sub) que deixam um único registrador vivo, e busca por força
+// bruta a sequência mais curta que calcula o mesmo valor:
+//
+//     li $t0, 5                   li $a0, 5
+//     move $a0, $t0        ->
+//
+// Um candidato passa primeiro por SUPEROPT_TESTS vetores de teste durante a
+// busca, depois por SUPEROPT_CHECKS vetores aleatórios e por uma prova de
+// equivalência simbólica:
+//   - se as duas sequências só usam operações bit a bit, cada bit do
+//     resultado depende apenas do mesmo bit das entradas, e testar todas as
+//     combinações de entradas 0 e ~0 cobre todos os casos;
+//   - senão, as duas são reduzidas a polinômios módulo 2^32 (addu, subu,
+//     mul, sll e constantes formam um anel), com as demais operações como
+//     funções não interpretadas dos argumentos já normalizados; os
+//     polinômios precisam ser idênticos.
+// Candidatos sem prova são descartados.
+//
+// A busca é cara, então o resultado de cada trecho (a reescrita ou "-" se não
+// há uma melhor dentro do orçamento) vai para um cache em disco, indexado
+// pelo trecho com os registradores renomeados. Compilações seguintes aplicam
+// as reescritas do cache sem buscar, mas ainda as verificam. Além do
+// orçamento de cada trecho há um para a compilação inteira: quando ele acaba,
+// os trechos que não estão no cache ficam como estão (e sem entrada no cache,
+// para serem procurados numa próxima compilação).
+
+#define SUPEROPT_MAX_WINDOW 5       // Instruções no trecho original
+#define SUPEROPT_MAX_SEARCH 3       // Instruções na sequência procurada
+#define SUPEROPT_MAX_INPUTS 4
+#define SUPEROPT_BUDGET 1000000L    // Instruções candidatas avaliadas por trecho
+#define SUPEROPT_TOTAL_BUDGET 8000000L  // ... e na compilação inteira
+#define SUPEROPT_TESTS 16
+#define SUPEROPT_CHECKS 512
+#define SUPEROPT_MAX_IMMS 12
+#define SUPEROPT_POOL (1 + SUPEROPT_MAX_INPUTS + SUPEROPT_MAX_SEARCH)
+
+typedef enum { FORM_RRR, FORM_RRI, FORM_RRU, FORM_RRS, FORM_RI, FORM_RR } Form;
+
+typedef enum {
+    OP_ADDU, OP_SUBU, OP_AND, OP_OR, OP_XOR, OP_NOR, OP_SLT, OP_SLTU,
+    OP_SLLV, OP_SRLV, OP_SRAV, OP_MUL,
+    OP_ADDIU, OP_SLTI, OP_SLTIU, OP_ANDI, OP_ORI, OP_XORI, OP_SLL, OP_SRL, OP_SRA,
+    OP_LI, OP_LUI, OP_MOVE, OP_NEGU, OP_NOT,
+    OP_SGT, OP_SLE, OP_SGE, OP_SEQ, OP_SNE,
+    OP_COUNT
+} Op;
+
+typedef struct {
+    const char *name;
+    Form form;
+    int cost;           // Ciclos (li fora de 16 bits custa mais um)
+    int commutative;
+    int bitwise;        // Cada bit do resultado só depende do mesmo bit dos operandos
+    int search;         // Usada nas sequências candidatas
+} OpInfo;
+
+static const OpInfo op_info[OP_COUNT] = {
+    [OP_ADDU]  = { "addu",  FORM_RRR, 1, 1, 0, 1 },
+    [OP_SUBU]  = { "subu",  FORM_RRR, 1, 0, 0, 1 },
+    [OP_AND]   = { "and",   FORM_RRR, 1, 1, 1, 1 },
+    [OP_OR]    = { "or",    FORM_RRR, 1, 1, 1, 1 },
+    [OP_XOR]   = { "xor",   FORM_RRR, 1, 1, 1, 1 },
+    [OP_NOR]   = { "nor",   FORM_RRR, 1, 1, 1, 1 },
+    [OP_SLT]   = { "slt",   FORM_RRR, 1, 0, 0, 1 },
+    [OP_SLTU]  = { "sltu",  FORM_RRR, 1, 0, 0, 1 },
+    [OP_SLLV]  = { "sllv",  FORM_RRR, 1, 0, 0, 1 },
+    [OP_SRLV]  = { "srlv",  FORM_RRR, 1, 0, 0, 1 },
+    [OP_SRAV]  = { "srav",  FORM_RRR, 1, 0, 0, 1 },
+    [OP_MUL]   = { "mul",   FORM_RRR, 5, 1, 0, 1 },
+    [OP_ADDIU] = { "addiu", FORM_RRI, 1, 0, 0, 1 },
+    [OP_SLTI]  = { "slti",  FORM_RRI, 1, 0, 0, 1 },
+    [OP_SLTIU] = { "sltiu", FORM_RRI, 1, 0, 0, 1 },
+    [OP_ANDI]  = { "andi",  FORM_RRU, 1, 0, 1, 1 },
+    [OP_ORI]   = { "ori",   FORM_RRU, 1, 0, 1, 1 },
+    [OP_XORI]  = { "xori",  FORM_RRU, 1, 0, 1, 1 },
+    [OP_SLL]   = { "sll",   FORM_RRS, 1, 0, 0, 1 },
+    [OP_SRL]   = { "srl",   FORM_RRS, 1, 0, 0, 1 },
+    [OP_SRA]   = { "sra",   FORM_RRS, 1, 0, 0, 1 },
+    [OP_LI]    = { "li",    FORM_RI,  1, 0, 1, 1 },
+    [OP_LUI]   = { "lui",   FORM_RI,  1, 0, 1, 0 },
+    [OP_MOVE]  = { "move",  FORM_RR,  1, 0, 1, 0 },
+    [OP_NEGU]  = { "negu",  FORM_RR,  1, 0, 0, 0 },
+    [OP_NOT]   = { "not",   FORM_RR,  1, 0, 1, 0 },
+    [OP_SGT]   = { "sgt",   FORM_RRR, 1, 0, 0, 0 },
+    [OP_SLE]   = { "sle",   FORM_RRR, 2, 0, 0, 0 },
+    [OP_SGE]   = { "sge",   FORM_RRR, 2, 0, 0, 0 },
+    [OP_SEQ]   = { "seq",   FORM_RRR, 2, 1, 0, 0 },
+    [OP_SNE]   = { "sne",   FORM_RRR, 2, 1, 0, 0 },
+};
+
+static const char *reg_names[32] = {
+    "$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+    "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+    "$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"
+};
+
+// Instrução de um trecho (operandos são registradores) ou de um candidato
+// (operandos são valores: 0 é $zero, depois as entradas, depois os temporários)
+typedef struct {
+    Op op;
+    int dst;
+    int src[2];
+    int32_t imm;
+} Instr;
+
+typedef struct {
+    Instr code[SUPEROPT_MAX_WINDOW];
+    int lines[SUPEROPT_MAX_WINDOW];     // Linhas do buffer
+    int count;
+    int inputs[SUPEROPT_MAX_INPUTS];    // Registradores lidos antes de escritos
+    int input_count;
+    int output;                         // Único registrador vivo depois do trecho
+    int cost;
+} Window;
+
+typedef struct {
+    Instr code[SUPEROPT_MAX_SEARCH];
+    int length;
+} Candidate;
+
+// ---------------------------------------------------------------------------
+// Instruções
+
+static int reg_index(const char *name) {
+    for (int i = 0; i < 32; i++) {
+        if (strcmp(reg_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static int source_count(Form form) {
+    switch (form) {
+        case FORM_RRR: return 2;
+        case FORM_RI: return 0;
+        default: return 1;
+    }
+}
+
+static int parse_number(const char *text, long long *value) {
+    char *end;
+    if (!*text) return 0;
+    *value = strtoll(text, &end, 0);
+    return *end == '\0';
+}
+
+static int li_cost(int32_t value) {
+    return value >= -32768 && value <= 65535 ? 1 : 2;
+}
+
+static int instr_cost(const Instr *in) {
+    return in->op == OP_LI ? li_cost(in->imm) : op_info[in->op].cost;
+}
+
+// Lê uma instrução pura (sem memória, desvio ou exceção); 0 se não é
+static int parse_instr(const AsmLine *line, Instr *in) {
+    int op = -1;
+    for (int i = 0; i < OP_COUNT; i++) {
+        if (strcmp(op_info[i].name, line->op) == 0) op = i;
+    }
+    if (op < 0) return 0;
+
+    Form form = op_info[op].form;
+    int regs = 1 + source_count(form);
+    int expected = form == FORM_RRR || form == FORM_RR ? regs : regs + 1;
+    if (line->arg_count != expected) return 0;
+
+    in->op = (Op)op;
+    in->dst = reg_index(line->args[0]);
+    // Só registradores de uso geral; $at, $sp, $fp e afins ficam de fora
+    if (in->dst < 2 || in->dst > 25) return 0;
+
+    in->src[0] = in->src[1] = 0;
+    for (int i = 1; i < regs; i++) {
+        in->src[i - 1] = reg_index(line->args[i]);
+        if (in->src[i - 1] < 0) return 0;
+    }
+
+    in->imm = 0;
+    if (expected > regs) {
+        long long value;
+        if (!parse_number(line->args[regs], &value)) return 0;
+        switch (form) {
+            case FORM_RRI: if (value < -32768 || value > 32767) return 0; break;
+            case FORM_RRU: if (value < 0 || value > 65535) return 0; break;
+            case FORM_RRS: if (value < 0 || value > 31) return 0; break;
+            case FORM_RI:
+                if (op == OP_LUI ? (value < 0 || value > 65535)
+                                 : (value < INT32_MIN || value > (long long)UINT32_MAX)) return 0;
+                break;
+            default: break;
+        }
+        in->imm = (int32_t)(uint32_t)value;
+    }
+    return 1;
+}
+
+static uint32_t shift_right_arith(uint32_t value, int amount) {
+    if (amount == 0 || !(value & 0x80000000u)) return value >> amount;
+    return (value >> amount) | ~(0xFFFFFFFFu >> amount);
+}
+
+static uint32_t eval_op(Op op, uint32_t a, uint32_t b, int32_t imm) {
+    switch (op) {
+        case OP_ADDU:  return a + b;
+        case OP_SUBU:  return a - b;
+        case OP_AND:   return a & b;
+        case OP_OR:    return a | b;
+        case OP_XOR:   return a ^ b;
+        case OP_NOR:   return ~(a | b);
+        case OP_SLT:   return (int32_t)a < (int32_t)b;
+        case OP_SLTU:  return a < b;
+        case OP_SLLV:  return a << (b & 31);
+        case OP_SRLV:  return a >> (b & 31);
+        case OP_SRAV:  return shift_right_arith(a, b & 31);
+        case OP_MUL:   return a * b;
+        case OP_ADDIU: return a + (uint32_t)imm;
+        case OP_SLTI:  return (int32_t)a < imm;
+        case OP_SLTIU: return a < (uint32_t)imm;
+        case OP_ANDI:  return a & (uint32_t)imm;
+        case OP_ORI:   return a | (uint32_t)imm;
+        case OP_XORI:  return a ^ (uint32_t)imm;
+        case OP_SLL:   return a << imm;
+        case OP_SRL:   return a >> imm;
+        case OP_SRA:   return shift_right_arith(a, imm);
+        case OP_LI:    return (uint32_t)imm;
+        case OP_LUI:   return (uint32_t)imm << 16;
+        case OP_MOVE:  return a;
+        case OP_NEGU:  return 0u - a;
+        case OP_NOT:   return ~a;
+        case OP_SGT:   return (int32_t)a > (int32_t)b;
+        case OP_SLE:   return (int32_t)a <= (int32_t)b;
+        case OP_SGE:   return (int32_t)a >= (int32_t)b;
+        case OP_SEQ:   return a == b;
+        case OP_SNE:   return a != b;
+        default:       return 0;
+    }
+}
+
+static uint32_t run_window(const Window *win, const uint32_t *inputs) {
+    uint32_t regs[32] = { 0 };
+    for (int i = 0; i < win->input_count; i++) regs[win->inputs[i]] = inputs[i];
+    for (int i = 0; i < win->count; i++) {
+        const Instr *in = &win->code[i];
+        regs[in->dst] = eval_op(in->op, regs[in->src[0]], regs[in->src[1]], in->imm);
+        regs[0] = 0;
+    }
+    return regs[win->output];
+}
+
+static uint32_t run_candidate(const Candidate *cand, int input_count, const uint32_t *inputs) {
+    uint32_t values[SUPEROPT_POOL] = { 0 };
+    for (int i = 0; i < input_count; i++) values[1 + i] = inputs[i];
+    for (int i = 0; i < cand->length; i++) {
+        const Instr *in = &cand->code[i];
+        values[in->dst] = eval_op(in->op, values[in->src[0]], values[in->src[1]], in->imm);
+    }
+    return values[cand->code[cand->length - 1].dst];
+}
+
+// ---------------------------------------------------------------------------
+// Vetores de teste
+
+static uint32_t next_random(uint32_t *state) {
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static const uint32_t edge_values[] = {
+    0, 1, 0xFFFFFFFFu, 0x80000000u, 0x7FFFFFFFu, 2, 31, 32, 0xFFFF, 0x10000, 0xFFFF8000u, 3
+};
+#define EDGE_COUNT (int)(sizeof(edge_values) / sizeof(edge_values[0]))
+
+static void test_vector(int index, int input_count, uint32_t *state, uint32_t *inputs) {
+    for (int i = 0; i < input_count; i++) {
+        if (index < EDGE_COUNT) {
+            inputs[i] = edge_values[(index + 5 * i) % EDGE_COUNT];
+        } else {
+            uint32_t r = next_random(state);
+            // Metade dos valores pequenos, onde comparações e deslocamentos mudam
+            inputs[i] = (r & 1) ? r : (uint32_t)((int32_t)(r >> 1) % 64);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Prova simbólica
+
+#define SYM_MAX_MONOS 16
+#define SYM_MAX_FACTORS 6
+#define SYM_MAX_ATOMS 48
+#define SYM_KEY_SIZE 256
+
+typedef struct {
+    uint32_t coef;
+    int count;
+    unsigned char factors[SYM_MAX_FACTORS];     // Átomos, em ordem crescente
+} Mono;
+
+typedef struct {
+    int ok;             // 0 se estourou algum limite (não prova nada)
+    int count;
+    Mono monos[SYM_MAX_MONOS];
+} Poly;
+
+typedef struct {
+    char keys[SYM_MAX_ATOMS][SYM_KEY_SIZE];
+    int count;
+} AtomTable;
+
+static int compare_monos(const Mono *a, const Mono *b) {
+    if (a->count != b->count) return a->count - b->count;
+    return memcmp(a->factors, b->factors, a->count);
+}
+
+static void poly_const(Poly *p, uint32_t value) {
+    p->ok = 1;
+    p->count = 0;
+    if (value) {
+        p->monos[0].coef = value;
+        p->monos[0].count = 0;
+        p->count = 1;
+    }
+}
+
+// Acrescenta scale * m a p, mantendo os monômios ordenados e sem coeficiente 0
+static void poly_add_mono(Poly *p, const Mono *m, uint32_t scale) {
+    uint32_t coef = m->coef * scale;
+    if (!coef || !p->ok) return;
+
+    int i = 0;
+    while (i < p->count && compare_monos(&p->monos[i], m) < 0) i++;
+    if (i < p->count && compare_monos(&p->monos[i], m) == 0) {
+        p->monos[i].coef += coef;
+        if (!p->monos[i].coef) {
+            memmove(&p->monos[i], &p->monos[i + 1], (p->count - i - 1) * sizeof(Mono));
+            p->count--;
+        }
+        return;
+    }
+    if (p->count == SYM_MAX_MONOS) {
+        p->ok = 0;
+        return;
+    }
+    memmove(&p->monos[i + 1], &p->monos[i], (p->count - i) * sizeof(Mono));
+    p->monos[i] = *m;
+    p->monos[i].coef = coef;
+    p->count++;
+}
+
+static void poly_combine(Poly *r, const Poly *a, const Poly *b, uint32_t b_scale) {
+    *r = *a;
+    r->ok = a->ok && b->ok;
+    for (int i = 0; i < b->count; i++) poly_add_mono(r, &b->monos[i], b_scale);
+}
+
+static void poly_multiply(Poly *r, const Poly *a, const Poly *b) {
+    poly_const(r, 0);
+    r->ok = a->ok && b->ok;
+    for (int i = 0; i < a->count && r->ok; i++) {
+        for (int j = 0; j < b->count && r->ok; j++) {
+            const Mono *x = &a->monos[i], *y = &b->monos[j];
+            if (x->count + y->count > SYM_MAX_FACTORS) {
+                r->ok = 0;
+                break;
+            }
+            // Junta os fatores ordenados
+            Mono m;
+            m.coef = x->coef * y->coef;
+            m.count = 0;
+            int p = 0, q = 0;
+            while (p < x->count || q < y->count) {
+                if (q >= y->count || (p < x->count && x->factors[p] <= y->factors[q])) {
+                    m.factors[m.count++] = x->factors[p++];
+                } else {
+                    m.factors[m.count++] = y->factors[q++];
+                }
+            }
+            poly_add_mono(r, &m, 1);
+        }
+    }
+}
+
+static int poly_is_const(const Poly *p, uint32_t *value) {
+    if (p->count == 0) {
+        *value = 0;
+        return 1;
+    }
+    if (p->count == 1 && p->monos[0].count == 0) {
+        *value = p->monos[0].coef;
+        return 1;
+    }
+    return 0;
+}
+
+// Forma canônica em texto; 0 se não cabe
+static int poly_key(const Poly *p, char *out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    for (int i = 0; i < p->count; i++) {
+        len += snprintf(out + len, len < size ? size - len : 0, "%s%u", i ? "+" : "", p->monos[i].coef);
+        for (int f = 0; f < p->monos[i].count; f++) {
+            len += snprintf(out + len, len < size ? size - len : 0, "*a%d", p->monos[i].factors[f]);
+        }
+    }
+    return len < size;
+}
+
+static int intern_atom(AtomTable *atoms, const char *key) {
+    for (int i = 0; i < atoms->count; i++) {
+        if (strcmp(atoms->keys[i], key) == 0) return i;
+    }
+    if (atoms->count == SYM_MAX_ATOMS) return -1;
+    strcpy(atoms->keys[atoms->count], key);
+    return atoms->count++;
+}
+
+static void poly_atom(Poly *p, AtomTable *atoms, const char *key) {
+    int id = strlen(key) < SYM_KEY_SIZE ? intern_atom(atoms, key) : -1;
+    poly_const(p, 0);
+    if (id < 0) {
+        p->ok = 0;
+        return;
+    }
+    Mono m;
+    m.coef = 1;
+    m.count = 1;
+    m.factors[0] = (unsigned char)id;
+    poly_add_mono(p, &m, 1);
+}
+
+// Valor simbólico de uma operação sobre valores já normalizados
+static void sym_eval(Poly *r, AtomTable *atoms, Op op, const Poly *a, const Poly *b, int32_t imm) {
+    uint32_t ca, cb;
+    int a_const = poly_is_const(a, &ca);
+    int b_const = poly_is_const(b, &cb);
+    int sources = source_count(op_info[op].form);
+
+    if (!a->ok || (sources == 2 && !b->ok)) {
+        r->ok = 0;
+        return;
+    }
+
+    Poly scale;
+    switch (op) {
+        case OP_ADDU: poly_combine(r, a, b, 1); return;
+        case OP_SUBU: poly_combine(r, a, b, 0xFFFFFFFFu); return;
+        case OP_MUL: poly_multiply(r, a, b); return;
+        case OP_MOVE: *r = *a; return;
+        case OP_NEGU:
+            poly_const(&scale, 0);
+            poly_combine(r, &scale, a, 0xFFFFFFFFu);
+            return;
+        case OP_ADDIU:
+            poly_const(&scale, (uint32_t)imm);
+            poly_combine(r, a, &scale, 1);
+            return;
+        case OP_SLL:
+            poly_const(&scale, 1u << imm);
+            poly_multiply(r, a, &scale);
+            return;
+        case OP_SLLV:
+            if (b_const) {
+                poly_const(&scale, 1u << (cb & 31));
+                poly_multiply(r, a, &scale);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    // Constantes se dobram; o resto vira um átomo
+    if ((sources < 1 || a_const) && (sources < 2 || b_const)) {
+        poly_const(r, eval_op(op, ca, cb, imm));
+        return;
+    }
+
+    // Formas equivalentes com o mesmo átomo: not a = nor(a, 0), sgt a, b = slt b, a
+    Poly zero;
+    if (op == OP_NOT) {
+        poly_const(&zero, 0);
+        op = OP_NOR;
+        b = &zero;
+        sources = 2;
+    } else if (op == OP_SGT) {
+        const Poly *t = a;
+        a = b;
+        b = t;
+        op = OP_SLT;
+    }
+
+    char ka[SYM_KEY_SIZE], kb[SYM_KEY_SIZE], key[SYM_KEY_SIZE];
+    if (!poly_key(a, ka, sizeof(ka)) || (sources == 2 && !poly_key(b, kb, sizeof(kb)))) {
+        r->ok = 0;
+        return;
+    }
+
+    const char *name = op_info[op].name;
+    int n;
+    if (sources == 2) {
+        int swap = op_info[op].commutative && strcmp(ka, kb) > 0;
+        n = snprintf(key, sizeof(key), "%s(%s|%s)", name, swap ? kb : ka, swap ? ka : kb);
+    } else {
+        n = snprintf(key, sizeof(key), "%s(%s|#%d)", name, ka, imm);
+    }
+    if (n >= (int)sizeof(key)) {
+        r->ok = 0;
+        return;
+    }
+    poly_atom(r, atoms, key);
+}
+
+static int all_bitwise(const Instr *code, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!op_info[code[i].op].bitwise) return 0;
+    }
+    return 1;
+}
+
+static int prove_equivalent(const Window *win, const Candidate *cand) {
+    int k = win->input_count;
+
+    // Fragmento bit a bit: todas as combinações de 0 e ~0
+    if (all_bitwise(win->code, win->count) && all_bitwise(cand->code, cand->length)) {
+        for (int mask = 0; mask < (1 << k); mask++) {
+            uint32_t inputs[SUPEROPT_MAX_INPUTS];
+            for (int i = 0; i < k; i++) inputs[i] = (mask >> i) & 1 ? 0xFFFFFFFFu : 0;
+            if (run_window(win, inputs) != run_candidate(cand, k, inputs)) return 0;
+        }
+        return 1;
+    }
+
+    static AtomTable atoms;
+    atoms.count = 0;
+
+    Poly regs[32], values[SUPEROPT_POOL];
+    for (int i = 0; i < 32; i++) poly_const(&regs[i], 0);
+    for (int i = 0; i < SUPEROPT_POOL; i++) poly_const(&values[i], 0);
+    for (int i = 0; i < k; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "in%d", i);
+        poly_atom(&regs[win->inputs[i]], &atoms, key);
+        values[1 + i] = regs[win->inputs[i]];
+    }
+
+    for (int i = 0; i < win->count; i++) {
+        const Instr *in = &win->code[i];
+        Poly result;
+        sym_eval(&result, &atoms, in->op, &regs[in->src[0]], &regs[in->src[1]], in->imm);
+        regs[in->dst] = result;
+    }
+    for (int i = 0; i < cand->length; i++) {
+        const Instr *in = &cand->code[i];
+        Poly result;
+        sym_eval(&result, &atoms, in->op, &values[in->src[0]], &values[in->src[1]], in->imm);
+        values[in->dst] = result;
+    }
+
+    const Poly *expected = &regs[win->output];
+    const Poly *actual = &values[cand->code[cand->length - 1].dst];
+    if (!expected->ok || !actual->ok) return 0;
+
+    char ke[SYM_KEY_SIZE], ka[SYM_KEY_SIZE];
+    return poly_key(expected, ke, sizeof(ke)) && poly_key(actual, ka, sizeof(ka)) && strcmp(ke, ka) == 0;
+}
+
+// Testes aleatórios e prova
+static int verify(const Window *win, const Candidate *cand) {
+    uint32_t state = 0x9E3779B9u;
+    for (int t = 0; t < SUPEROPT_CHECKS; t++) {
+        uint32_t inputs[SUPEROPT_MAX_INPUTS];
+        test_vector(t, win->input_count, &state, inputs);
+        if (run_window(win, inputs) != run_candidate(cand, win->input_count, inputs)) return 0;
+    }
+    return prove_equivalent(win, cand);
+}
+
+static int candidate_cost(const Candidate *cand) {
+    int cost = 0;
+    for (int i = 0; i < cand->length; i++) cost += instr_cost(&cand->code[i]);
+    return cost;
+}
+
+// ---------------------------------------------------------------------------
+// Busca
+
+typedef struct {
+    const Window *win;
+    uint32_t target[SUPEROPT_TESTS];
+    uint32_t values[SUPEROPT_POOL][SUPEROPT_TESTS];
+    int value_count;
+    int32_t imms[SUPEROPT_MAX_IMMS];    // Imediatos de addiu, slti, andi, ...
+    int imm_count;
+    int32_t shifts[SUPEROPT_MAX_IMMS];
+    int shift_count;
+    int32_t consts[SUPEROPT_MAX_IMMS];  // Valores de li
+    int const_count;
+    Candidate cand;
+    int uses[SUPEROPT_POOL];
+    int length;
+    long budget;
+    int found;
+} Search;
+
+static void add_imm(int32_t *list, int *count, int32_t value) {
+    for (int i = 0; i < *count; i++) {
+        if (list[i] == value) return;
+    }
+    if (*count < SUPEROPT_MAX_IMMS) list[(*count)++] = value;
+}
+
+static int imm_fits(Form form, int32_t value) {
+    switch (form) {
+        case FORM_RRI: return value >= -32768 && value <= 32767;
+        case FORM_RRU: return value >= 0 && value <= 65535;
+        case FORM_RRS: return value >= 1 && value <= 31;
+        default: return 1;
+    }
+}
+
+static void search_try(Search *s, int depth, int cost);
+
+// Avalia a instrução s->cand.code[depth] e continua a busca
+static void search_step(Search *s, int depth, int cost) {
+    Instr *in = &s->cand.code[depth];
+    int dst = s->value_count;
+    uint32_t *result = s->values[dst];
+    int sources = source_count(op_info[in->op].form);
+
+    if (--s->budget < 0) return;
+    for (int t = 0; t < SUPEROPT_TESTS; t++) {
+        result[t] = eval_op(in->op, s->values[in->src[0]][t], s->values[in->src[1]][t], in->imm);
+    }
+    in->dst = dst;
+
+    if (depth == s->length - 1) {
+        if (memcmp(result, s->target, sizeof(s->target)) != 0) return;
+        // Todo temporário precisa ser usado
+        for (int v = 1 + s->win->input_count; v < dst; v++) {
+            if (s->uses[v] == 0 && in->src[0] != v && (sources < 2 || in->src[1] != v)) return;
+        }
+        s->cand.length = s->length;
+        if (verify(s->win, &s->cand)) s->found = 1;
+        return;
+    }
+
+    // Valor repetido não ajuda
+    for (int v = 0; v < dst; v++) {
+        if (memcmp(result, s->values[v], sizeof(s->values[v])) == 0) return;
+    }
+
+    for (int i = 0; i < sources; i++) s->uses[in->src[i]]++;
+    s->value_count++;
+    search_try(s, depth + 1, cost);
+    s->value_count--;
+    for (int i = 0; i < sources; i++) s->uses[in->src[i]]--;
+}
+
+static void search_try(Search *s, int depth, int cost) {
+    int remaining = s->length - depth - 1;
+    Instr *in = &s->cand.code[depth];
+
+    for (int op = 0; op < OP_COUNT && !s->found && s->budget > 0; op++) {
+        if (!op_info[op].search) continue;
+        Form form = op_info[op].form;
+        in->op = (Op)op;
+        in->imm = 0;
+        in->src[0] = in->src[1] = 0;
+
+        if (form == FORM_RI) {
+            for (int c = 0; c < s->const_count && !s->found; c++) {
+                in->imm = s->consts[c];
+                if (cost + li_cost(in->imm) + remaining >= s->win->cost) continue;
+                search_step(s, depth, cost + li_cost(in->imm));
+            }
+            continue;
+        }
+
+        int next = cost + op_info[op].cost;
+        if (next + remaining >= s->win->cost) continue;
+
+        for (int a = 0; a < s->value_count && !s->found; a++) {
+            in->src[0] = a;
+            if (form == FORM_RRR) {
+                for (int b = op_info[op].commutative ? a : 0; b < s->value_count && !s->found; b++) {
+                    if (a == 0 && b == 0) continue;
+                    in->src[1] = b;
+                    search_step(s, depth, next);
+                }
+            } else {
+                // Operando $zero dá uma constante, que o li já cobre
+                if (a == 0) continue;
+                const int32_t *list = form == FORM_RRS ? s->shifts : s->imms;
+                int count = form == FORM_RRS ? s->shift_count : s->imm_count;
+                for (int i = 0; i < count && !s->found; i++) {
+                    if (!imm_fits(form, list[i])) continue;
+                    in->imm = list[i];
+                    search_step(s, depth, next);
+                }
+            }
+        }
+    }
+}
+
+// Sequência mais curta (e mais barata que o trecho) equivalente; 0 se não há
+// dentro do orçamento, -1 se a busca parou porque o orçamento da compilação
+// (*remaining, que é descontado) acabou antes
+static int search(const Window *win, Candidate *out, long *remaining) {
+    static Search s;
+    memset(&s, 0, sizeof(s));
+    s.win = win;
+    int limited = *remaining < SUPEROPT_BUDGET;
+    long start = limited ? *remaining : SUPEROPT_BUDGET;
+    s.budget = start;
+
+    uint32_t state = 0x2545F491u;
+    for (int t = 0; t < SUPEROPT_TESTS; t++) {
+        uint32_t inputs[SUPEROPT_MAX_INPUTS];
+        test_vector(t, win->input_count, &state, inputs);
+        s.target[t] = run_window(win, inputs);
+        s.values[0][t] = 0;
+        for (int i = 0; i < win->input_count; i++) s.values[1 + i][t] = inputs[i];
+    }
+    s.value_count = 1 + win->input_count;
+
+    // Constantes do próprio trecho, seus opostos e ±1
+    add_imm(s.imms, &s.imm_count, 1);
+    add_imm(s.imms, &s.imm_count, -1);
+    add_imm(s.shifts, &s.shift_count, 1);
+    add_imm(s.shifts, &s.shift_count, 31);
+    for (int i = 0; i < win->count; i++) {
+        const Instr *in = &win->code[i];
+        Form form = op_info[in->op].form;
+        if (form == FORM_RRR || form == FORM_RR) continue;
+        int32_t value = in->op == OP_LUI ? (int32_t)((uint32_t)in->imm << 16) : in->imm;
+        add_imm(s.consts, &s.const_count, value);
+        add_imm(s.imms, &s.imm_count, value);
+        add_imm(s.imms, &s.imm_count, (int32_t)(0u - (uint32_t)value));
+        if (value >= 1 && value <= 31) add_imm(s.shifts, &s.shift_count, value);
+    }
+
+    int max_length = win->count - 1 < SUPEROPT_MAX_SEARCH ? win->count - 1 : SUPEROPT_MAX_SEARCH;
+    for (s.length = 1; s.length <= max_length && !s.found && s.budget > 0; s.length++) {
+        search_try(&s, 0, 0);
+    }
+    *remaining -= start - (s.budget > 0 ? s.budget : 0);
+    if (!s.found) return limited && s.budget <= 0 ? -1 : 0;
+    *out = s.cand;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Trechos no código
+
+// Ops que escrevem o primeiro operando e leem os demais
+static int writes_first(const AsmLine *line) {
+    static const char *ops[] = {
+        "add", "addi", "sub", "neg", "lw", "la", "mfhi", "mflo", "rem"
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(ops[i], line->op) == 0) return 1;
+    }
+    if (strcmp(line->op, "div") == 0) return line->arg_count == 3;
+    for (int i = 0; i < OP_COUNT; i++) {
+        if (strcmp(op_info[i].name, line->op) == 0) return 1;
+    }
+    return 0;
+}
+
+// Ops que só leem seus operandos (movn/movz escrevem só às vezes)
+static int reads_only(const AsmLine *line) {
+    static const char *ops[] = {
+        "sw", "movn", "movz", "mult", "multu", "teq", "mthi", "mtlo"
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(ops[i], line->op) == 0) return 1;
+    }
+    return strcmp(line->op, "div") == 0 && line->arg_count == 2;
+}
+
+// O operando menciona o registrador (direto ou como base de "off($r)")
+static int mentions(const char *arg, int reg) {
+    const char *paren = strchr(arg, '(');
+    if (paren) {
+        char base[ASM_ARG_SIZE];
+        strncpy(base, paren + 1, sizeof(base) - 1);
+        base[sizeof(base) - 1] = '\0';
+        char *close = strchr(base, ')');
+        if (close) *close = '\0';
+        return reg_index(base) == reg;
+    }
+    return reg_index(arg) == reg;
+}
+
+// O registrador pode ser lido depois da linha 'from'? Desvios e rótulos
+// encerram a varredura de forma conservadora
+static int live_after(AsmBuffer *buf, int from, int reg) {
+    for (int i = from + 1; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        if (line->label[0]) return 1;
+        if (!asm_is_instruction(line)) continue;
+
+        if (strcmp(line->op, "syscall") == 0) {
+            if (asm_reads_reg(line, reg_names[reg])) return 1;
+            continue;
+        }
+
+        int first = writes_first(line);
+        if (!first && !reads_only(line)) return 1;
+        for (int a = first ? 1 : 0; a < line->arg_count; a++) {
+            if (mentions(line->args[a], reg)) return 1;
+        }
+        if (first && mentions(line->args[0], reg) && !strchr(line->args[0], '(')) return 0;
+    }
+    return 0;
+}
+
+// Monta o trecho com as instruções lines[0..count); 0 se não serve
+static int build_window(AsmBuffer *buf, const int *lines, int count, Window *win) {
+    int written[32] = { 0 };
+    win->count = count;
+    win->input_count = 0;
+    win->cost = 0;
+
+    for (int i = 0; i < count; i++) {
+        Instr *in = &win->code[i];
+        parse_instr(&buf->lines[lines[i]], in);
+        win->lines[i] = lines[i];
+        win->cost += instr_cost(in);
+
+        for (int s = 0; s < source_count(op_info[in->op].form); s++) {
+            int reg = in->src[s];
+            if (reg == 0 || written[reg]) continue;
+            int known = 0;
+            for (int k = 0; k < win->input_count; k++) known |= win->inputs[k] == reg;
+            if (known) continue;
+            if (win->input_count == SUPEROPT_MAX_INPUTS) return 0;
+            win->inputs[win->input_count++] = reg;
+        }
+        written[in->dst] = 1;
+    }
+
+    // Exatamente um registrador escrito continua vivo
+    int outputs = 0;
+    for (int reg = 1; reg < 32; reg++) {
+        if (written[reg] && live_after(buf, lines[count - 1], reg)) {
+            win->output = reg;
+            outputs++;
+        }
+    }
+    return outputs == 1;
+}
+
+// Chave do cache: o trecho com os registradores renomeados na ordem em que
+// aparecem (%0, %1, ...) e o registrador de saída
+static void window_key(const Window *win, char *out, size_t size) {
+    int names[32];
+    int next = 0;
+    for (int i = 0; i < 32; i++) names[i] = -1;
+
+    size_t len = 0;
+    for (int i = 0; i < win->count; i++) {
+        const Instr *in = &win->code[i];
+        Form form = op_info[in->op].form;
+        int regs[3] = { in->dst, in->src[0], in->src[1] };
+        int reg_count = 1 + source_count(form);
+
+        len += snprintf(out + len, size - len, "%s%s", i ? "; " : "", op_info[in->op].name);
+        for (int r = 0; r < reg_count; r++) {
+            if (regs[r] == 0) {
+                len += snprintf(out + len, size - len, "%s$zero", r ? ", " : " ");
+                continue;
+            }
+            if (names[regs[r]] < 0) names[regs[r]] = next++;
+            len += snprintf(out + len, size - len, "%s%%%d", r ? ", " : " ", names[regs[r]]);
+        }
+        if (form != FORM_RRR && form != FORM_RR) {
+            len += snprintf(out + len, size - len, ", %d", in->imm);
+        }
+    }
+    snprintf(out + len, size - len, " -> %%%d", names[win->output]);
+}
+
+// Reescrita: "op t0, i1, 4; op t1, t0, $zero" (iN entradas, tN temporários)
+static void candidate_text(const Candidate *cand, int input_count, char *out, size_t size) {
+    size_t len = 0;
+    for (int i = 0; i < cand->length; i++) {
+        const Instr *in = &cand->code[i];
+        Form form = op_info[in->op].form;
+        len += snprintf(out + len, size - len, "%s%s t%d", i ? "; " : "", op_info[in->op].name, i);
+        for (int s = 0; s < source_count(form); s++) {
+            int v = in->src[s];
+            if (v == 0) {
+                len += snprintf(out + len, size - len, ", $zero");
+            } else if (v <= input_count) {
+                len += snprintf(out + len, size - len, ", i%d", v - 1);
+            } else {
+                len += snprintf(out + len, size - len, ", t%d", v - 1 - input_count);
+            }
+        }
+        if (form != FORM_RRR && form != FORM_RR) {
+            len += snprintf(out + len, size - len, ", %d", in->imm);
+        }
+    }
+}
+
+static int parse_value(const char *text, int input_count, int temps, int *value) {
+    long long n;
+    if (strcmp(text, "$zero") == 0) {
+        *value = 0;
+        return 1;
+    }
+    if ((text[0] == 'i' || text[0] == 't') && parse_number(text + 1, &n) && n >= 0) {
+        if (text[0] == 'i' && n < input_count) {
+            *value = 1 + (int)n;
+            return 1;
+        }
+        if (text[0] == 't' && n < temps) {
+            *value = 1 + input_count + (int)n;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int parse_candidate(const char *text, int input_count, Candidate *cand) {
+    char *copy = strdup(text);
+    cand->length = 0;
+    int ok = 1;
+
+    for (char *part = strtok(copy, ";"); part && ok; part = strtok(NULL, ";")) {
+        if (cand->length == SUPEROPT_MAX_SEARCH) {
+            ok = 0;
+            break;
+        }
+        char args[4][ASM_ARG_SIZE];
+        int argc = 0;
+        char op[16];
+        if (sscanf(part, " %15s", op) != 1) {
+            ok = 0;
+            break;
+        }
+        const char *p = strstr(part, op) + strlen(op);
+        while (*p && argc < 4) {
+            while (*p == ' ' || *p == ',') p++;
+            if (!*p) break;
+            size_t n = strcspn(p, ", ");
+            if (n >= ASM_ARG_SIZE) n = ASM_ARG_SIZE - 1;
+            memcpy(args[argc], p, n);
+            args[argc][n] = '\0';
+            argc++;
+            p += n;
+        }
+
+        int code = -1;
+        for (int i = 0; i < OP_COUNT; i++) {
+            if (strcmp(op_info[i].name, op) == 0) code = i;
+        }
+        Instr *in = &cand->code[cand->length];
+        if (code < 0) {
+            ok = 0;
+            break;
+        }
+        Form form = op_info[code].form;
+        int sources = source_count(form);
+        int has_imm = form != FORM_RRR && form != FORM_RR;
+        long long imm = 0;
+        char expected_dst[8];
+        snprintf(expected_dst, sizeof(expected_dst), "t%d", cand->length);
+
+        in->op = (Op)code;
+        in->src[0] = in->src[1] = 0;
+        in->dst = 1 + input_count + cand->length;
+        ok = argc == 1 + sources + has_imm && strcmp(args[0], expected_dst) == 0;
+        for (int s = 0; s < sources && ok; s++) {
+            ok = parse_value(args[1 + s], input_count, cand->length, &in->src[s]);
+        }
+        if (ok && has_imm) {
+            ok = parse_number(args[1 + sources], &imm) && imm >= INT32_MIN && imm <= INT32_MAX &&
+                 (form == FORM_RI || imm_fits(form, (int32_t)imm) || (form == FORM_RRS && imm == 0));
+            in->imm = (int32_t)imm;
+        }
+        cand->length++;
+    }
+
+    free(copy);
+    return ok && cand->length > 0;
+}
+
+// Escolhe registradores para os temporários entre os que o trecho escreve;
+// o último vai para o registrador de saída
+static int assign_registers(const Window *win, const Candidate *cand, int *reg_of) {
+    int k = win->input_count;
+    int last_use[SUPEROPT_POOL];
+    int written[32] = { 0 };
+
+    for (int v = 0; v < SUPEROPT_POOL; v++) last_use[v] = -1;
+    for (int i = 0; i < cand->length; i++) {
+        for (int s = 0; s < source_count(op_info[cand->code[i].op].form); s++) {
+            last_use[cand->code[i].src[s]] = i;
+        }
+    }
+    for (int i = 0; i < win->count; i++) written[win->code[i].dst] = 1;
+
+    reg_of[0] = 0;
+    for (int i = 0; i < k; i++) reg_of[1 + i] = win->inputs[i];
+
+    for (int i = 0; i < cand->length; i++) {
+        int value = 1 + k + i;
+        if (i == cand->length - 1) {
+            reg_of[value] = win->output;
+            break;
+        }
+
+        reg_of[value] = -1;
+        for (int reg = 1; reg < 32 && reg_of[value] < 0; reg++) {
+            if (!written[reg]) continue;
+            int busy = 0;
+            for (int v = 1; v < value; v++) {
+                if (reg_of[v] == reg && last_use[v] > i) busy = 1;
+            }
+            if (!busy) reg_of[value] = reg;
+        }
+        if (reg_of[value] < 0) return 0;
+    }
+    return 1;
+}
+
+static int apply(AsmBuffer *buf, const Window *win, const Candidate *cand) {
+    int reg_of[SUPEROPT_POOL];
+    if (!assign_registers(win, cand, reg_of)) return 0;
+
+    int at = win->lines[0];
+    for (int i = win->count - 1; i >= 0; i--) {
+        asm_buffer_remove(buf, win->lines[i]);
+    }
+
+    for (int i = cand->length - 1; i >= 0; i--) {
+        const Instr *in = &cand->code[i];
+        Form form = op_info[in->op].form;
+        char text[96];
+        int len = snprintf(text, sizeof(text), "    %s %s", op_info[in->op].name, reg_names[reg_of[in->dst]]);
+        for (int s = 0; s < source_count(form); s++) {
+            len += snprintf(text + len, sizeof(text) - len, ", %s", reg_names[reg_of[in->src[s]]]);
+        }
+        if (form != FORM_RRR && form != FORM_RR) {
+            snprintf(text + len, sizeof(text) - len, ", %d", in->imm);
+        }
+        asm_buffer_insert(buf, at, text);
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Cache em disco: uma linha "trecho => reescrita" (ou "=> -") por trecho
+
+typedef struct {
+    char **keys;
+    char **rewrites;
+    char *fresh;        // Entrada nova desta compilação (ainda não está no arquivo)
+    int count;
+    int capacity;
+    int dirty;
+} Cache;
+
+// Uma chave repetida fica com a última reescrita (a do fim do arquivo)
+static void cache_put(Cache *cache, const char *key, const char *rewrite, int fresh) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->keys[i], key) == 0) {
+            free(cache->rewrites[i]);
+            cache->rewrites[i] = strdup(rewrite);
+            cache->fresh[i] = (char)fresh;
+            return;
+        }
+    }
+    if (cache->count == cache->capacity) {
+        cache->capacity = cache->capacity ? cache->capacity * 2 : 64;
+        cache->keys = (char**)realloc(cache->keys, cache->capacity * sizeof(char*));
+        cache->rewrites = (char**)realloc(cache->rewrites, cache->capacity * sizeof(char*));
+        cache->fresh = (char*)realloc(cache->fresh, cache->capacity);
+    }
+    cache->keys[cache->count] = strdup(key);
+    cache->rewrites[cache->count] = strdup(rewrite);
+    cache->fresh[cache->count] = (char)fresh;
+    cache->count++;
+}
+
+static const char* cache_get(Cache *cache, const char *key) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->keys[i], key) == 0) return cache->rewrites[i];
+    }
+    return NULL;
+}
+
+static void cache_load(Cache *cache, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return;
+
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    while ((len = getline(&line, &size, file)) > 0) {
+        if (line[len - 1] == '\n') line[--len] = '\0';
+        char *sep = strstr(line, " => ");
+        if (line[0] == '#' || !sep) continue;
+        *sep = '\0';
+        cache_put(cache, line, sep + 4, 0);
+    }
+    free(line);
+    fclose(file);
+}
+
+// Acrescenta ao arquivo só as entradas novas, numa única escrita, para que
+// compilações que compartilham o cache não apaguem as entradas umas das outras
+static void cache_save(Cache *cache, const char *path) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->fresh[i]) fprintf(out, "%s => %s\n", cache->keys[i], cache->rewrites[i]);
+    }
+    fclose(out);
+
+    FILE *file = fopen(path, "a");
+    if (!file) {
+        fprintf(stderr, "Warning: could not write superoptimizer cache %s\n", path);
+        free(text);
+        return;
+    }
+    setvbuf(file, NULL, _IONBF, 0);
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        fputs("# Superoptimizer cache: <window> -> <live register> => <rewrite> | -\n", file);
+    }
+    fwrite(text, 1, size, file);
+    fclose(file);
+    free(text);
+}
+
+static void cache_free(Cache *cache) {
+    for (int i = 0; i < cache->count; i++) {
+        free(cache->keys[i]);
+        free(cache->rewrites[i]);
+    }
+    free(cache->keys);
+    free(cache->rewrites);
+    free(cache->fresh);
+}
+
+// ---------------------------------------------------------------------------
+
+// Reescrita para o trecho: do cache (verificada de novo) ou da busca, se
+// ainda há orçamento
+static int find_rewrite(Cache *cache, const Window *win, Candidate *cand, long *remaining,
+                        SuperoptStats *stats) {
+    char key[512], text[256];
+    window_key(win, key, sizeof(key));
+
+    const char *cached = cache_get(cache, key);
+    if (cached) {
+        if (strcmp(cached, "-") == 0) {
+            stats->hits++;
+            return 0;
+        }
+        if (parse_candidate(cached, win->input_count, cand) &&
+            candidate_cost(cand) < win->cost && verify(win, cand)) {
+            stats->hits++;
+            return 1;
+        }
+        // Entrada inválida: procura de novo e a substitui
+    }
+
+    if (*remaining <= 0) {
+        stats->skipped++;
+        return 0;
+    }
+    stats->searches++;
+    int found = search(win, cand, remaining);
+    if (found < 0) {
+        // Busca incompleta: não diz nada sobre o trecho
+        stats->skipped++;
+        return 0;
+    }
+    if (found) {
+        candidate_text(cand, win->input_count, text, sizeof(text));
+    } else {
+        strcpy(text, "-");
+    }
+    cache_put(cache, key, text, 1);
+    cache->dirty = 1;
+    return found;
+}
+
+static int is_pure(AsmBuffer *buf, int index) {
+    Instr in;
+    return parse_instr(&buf->lines[index], &in);
+}
+
+int mips_superoptimize(AsmBuffer *buf, const char *cache_path, SuperoptStats *stats) {
+    Cache cache = { NULL, NULL, NULL, 0, 0, 0 };
+    cache_load(&cache, cache_path);
+    stats->rewrites = stats->hits = stats->searches = stats->skipped = 0;
+    long remaining = SUPEROPT_TOTAL_BUDGET;
+
+    for (int i = 0; i < buf->count; i++) {
+        if (!is_pure(buf, i)) continue;
+
+        // Sequência de instruções puras a partir da linha i
+        int run[64];
+        int n = 0;
+        for (int j = i; j < buf->count && n < 64; j++) {
+            AsmLine *line = &buf->lines[j];
+            if (line->label[0]) break;
+            if (!asm_is_instruction(line)) continue;
+            if (!is_pure(buf, j)) break;
+            run[n++] = j;
+        }
+        if (n < 2) continue;
+
+        // Do trecho mais longo para o mais curto, a partir do início
+        int rewritten = 0;
+        for (int len = n < SUPEROPT_MAX_WINDOW ? n : SUPEROPT_MAX_WINDOW; len >= 2 && !rewritten; len--) {
+            Window win;
+            Candidate cand;
+            if (!build_window(buf, run, len, &win)) continue;
+            if (find_rewrite(&cache, &win, &cand, &remaining, stats) && apply(buf, &win, &cand)) {
+                stats->rewrites++;
+                rewritten = 1;
+            }
+        }
+        // Depois de reescrever, tenta de novo a partir da mesma linha
+        if (rewritten) i--;
+    }
+
+    if (cache.dirty) cache_save(&cache, cache_path);
+    cache_free(&cache);
+    return stats->rewrites;
+}
@@ -0,0 +1,187 @@
+#define _GNU_SOURCE
+#include "mips_asm.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Fusão de sufixos idênticos (cross-jumping) sobre o código gerado.
+//
+// Os braços de um if costumam terminar com as mesmas instruções antes de
+// chegar ao rótulo de junção, como o "la $a0, newline; li $v0, 4; syscall"
+// que imprime o fim de linha de cada Put_Line:
+//
+//     <então>; la $a0, newline; li $v0, 4; syscall; j Lend
+//     <senão>; la $a0, newline; li $v0, 4; syscall
+//   Lend:
+//
+// Para cada rótulo, os predecessores são os "j L" e a instrução que cai no
+// rótulo. Quando dois deles terminam com as mesmas k instruções, a cópia de
+// um predecessor que salta é trocada por "j L'", com L' posto antes da cópia
+// do outro:
+//
+//     <então>; j Lt
+//     <senão>
+//   Lt:
+//     la $a0, newline; li $v0, 4; syscall
+//   Lend:
+//
+// O caminho desviado executa o mesmo número de instruções (o j só muda de
+// lugar) e o código diminui k instruções. Sufixos não atravessam rótulos nem
+// desvios. Repete até não haver mais sufixos comuns.
+
+typedef struct {
+    int end;        // Última instrução antes do rótulo (ou do j)
+    int jump;       // Índice do "j L", ou -1 se cai no rótulo
+} Predecessor;
+
+// Comentários e linhas vazias
+static int is_filler(const AsmLine *line) {
+    return !line->label[0] && !asm_is_instruction(line);
+}
+
+static int same_instruction(const AsmLine *a, const AsmLine *b) {
+    if (strcmp(a->op, b->op) != 0 || a->arg_count != b->arg_count) return 0;
+    for (int i = 0; i < a->arg_count; i++) {
+        if (strcmp(a->args[i], b->args[i]) != 0) return 0;
+    }
+    return 1;
+}
+
+// Instrução viva anterior à linha 'from' (-1 se chega a um rótulo ou ao início)
+static int previous_instruction(AsmBuffer *buf, int from) {
+    for (int i = from - 1; i >= 0; i--) {
+        if (buf->lines[i].label[0]) return -1;
+        if (asm_is_instruction(&buf->lines[i])) return i;
+    }
+    return -1;
+}
+
+// A instrução encerra o fluxo (j ou a syscall de saída)?
+static int ends_flow(AsmBuffer *buf, int index) {
+    AsmLine *line = &buf->lines[index];
+    if (asm_is_jump(line)) return 1;
+    if (strcmp(line->op, "syscall") != 0) return 0;
+
+    int prev = previous_instruction(buf, index);
+    return prev >= 0 && strcmp(buf->lines[prev].op, "li") == 0 &&
+           strcmp(buf->lines[prev].args[0], "$v0") == 0 &&
+           strcmp(buf->lines[prev].args[1], "10") == 0;
+}
+
+// Quantas instruções iguais terminam em a e b (percorrendo para trás);
+// *a_start e *b_start recebem a primeira instrução comum de cada lado
+static int common_suffix(AsmBuffer *buf, int a, int b, int *a_start, int *b_start) {
+    int count = 0;
+    while (a >= 0 && b >= 0 && a != b) {
+        while (a >= 0 && is_filler(&buf->lines[a])) a--;
+        while (b >= 0 && is_filler(&buf->lines[b])) b--;
+        if (a < 0 || b < 0) break;
+
+        AsmLine *la = &buf->lines[a];
+        AsmLine *lb = &buf->lines[b];
+        if (la->label[0] || lb->label[0] || asm_is_branch(la) || asm_is_branch(lb)) break;
+        if (!same_instruction(la, lb)) break;
+
+        *a_start = a;
+        *b_start = b;
+        count++;
+        a--;
+        b--;
+    }
+    return count;
+}
+
+// Predecessores do rótulo na linha 'index'
+static int collect_predecessors(AsmBuffer *buf, int index, Predecessor *preds) {
+    const char *name = buf->lines[index].label;
+    int count = 0;
+
+    // Quem cai no rótulo (outros rótulos no caminho não interrompem)
+    for (int i = index - 1; i >= 0; i--) {
+        AsmLine *line = &buf->lines[i];
+        if (!asm_is_instruction(line)) continue;
+        if (!ends_flow(buf, i) && !asm_is_branch(line)) {
+            preds[count].end = i;
+            preds[count].jump = -1;
+            count++;
+        }
+        break;
+    }
+
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        if (!asm_is_jump(line) || strcmp(asm_branch_target(line), name) != 0) continue;
+        int end = previous_instruction(buf, i);
+        if (end < 0) continue;
+        preds[count].end = end;
+        preds[count].jump = i;
+        count++;
+    }
+    return count;
+}
+
+// Troca as instruções [start, jump] de um predecessor por "j target" e põe
+// o rótulo target antes de 'keep_start'
+static void merge(AsmBuffer *buf, int start, int jump, int keep_start, const char *target) {
+    const char *args[1] = { target };
+    char label_line[ASM_ARG_SIZE + 2];
+    snprintf(label_line, sizeof(label_line), "%s:", target);
+
+    // Edita primeiro a parte mais ao fim, para os índices da outra valerem
+    if (start > keep_start) {
+        asm_set_instruction(&buf->lines[start], "j", 1, args);
+        for (int i = jump; i > start; i--) asm_buffer_remove(buf, i);
+        asm_buffer_insert(buf, keep_start, label_line);
+    } else {
+        asm_buffer_insert(buf, keep_start, label_line);
+        asm_set_instruction(&buf->lines[start], "j", 1, args);
+        for (int i = jump; i > start; i--) asm_buffer_remove(buf, i);
+    }
+}
+
+// Procura um par de predecessores com sufixo comum e funde; 1 se fundiu
+static int merge_one(AsmBuffer *buf, int *next_label) {
+    Predecessor *preds = (Predecessor*)malloc((buf->count + 1) * sizeof(Predecessor));
+
+    for (int l = 0; l < buf->count; l++) {
+        if (!buf->lines[l].label[0]) continue;
+
+        int count = collect_predecessors(buf, l, preds);
+        int best = 0, best_from = -1, from_start = 0, into_start = 0;
+
+        // Só um predecessor que salta pode perder sua cópia
+        for (int i = 0; i < count; i++) {
+            if (preds[i].jump < 0) continue;
+            for (int j = 0; j < count; j++) {
+                if (i == j) continue;
+                int a_start, b_start;
+                int k = common_suffix(buf, preds[i].end, preds[j].end, &a_start, &b_start);
+                if (k > best) {
+                    best = k;
+                    best_from = i;
+                    from_start = a_start;
+                    into_start = b_start;
+                }
+            }
+        }
+
+        if (best > 0) {
+            char target[ASM_ARG_SIZE];
+            snprintf(target, sizeof(target), "L%d", (*next_label)++);
+            merge(buf, from_start, preds[best_from].jump, into_start, target);
+            free(preds);
+            return 1;
+        }
+    }
+
+    free(preds);
+    return 0;
+}
+
+int mips_merge_tails(AsmBuffer *buf) {
+    int next_label = asm_max_label_number(buf) + 1;
+    int merges = 0;
+    while (merge_one(buf, &next_label)) {
+        merges++;
+    }
+    return merges;
+}
@@ -0,0 +1,346 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Simplificação algébrica e reassociação.
+//
+// O parser monta uma sequência de operadores de mesma precedência como uma
+// árvore inclinada à esquerda: "a + b + c + d" vira ((a + b) + c) + d, com
+// três somas dependentes uma da outra. Este passe reescreve cada sequência
+// numa forma canônica:
+//   - as constantes são agrupadas num único literal, à direita
+//     (x + 1 + 2 => x + 3, 2 * x * 3 => x * 6, x / 2 / 3 => x / 6);
+//   - identidades: x + 0, x - 0, x * 1 e x / 1 => x; x * 0 => 0;
+//     x - x (termos opostos da mesma sequência) => 0; not not x => x;
+//   - sequências de quatro ou mais termos são reequilibradas,
+//     (a + b) + (c + d), reduzindo a altura de dependência para log2(n).
+//
+// Ada RM 4.5(13) permite qualquer associação de uma sequência de operadores
+// predefinidos de mesmo nível sem parênteses, desde que o resultado seja um
+// dos permitidos pela associação da esquerda para a direita, ignorando as
+// verificações que poderiam falhar numa ou noutra ordem. Assim os + e -
+// verificados só são reassociados dentro de uma sequência sem parênteses (um
+// BinaryOp parenthesized é um termo da sequência de fora), e o overflow pode
+// acontecer em outro ponto ou não acontecer. * dá a volta, então qualquer
+// ordem dá o mesmo resultado e os parênteses não importam. Termos
+// descartados (x * 0, x - x) não podem conter divisão que levante exceção;
+// + e - unchecked, criados pelo otimizador, não entram nas sequências.
+
+// Sequências com pelo menos este número de termos são reequilibradas
+#define REASSOC_MIN_TERMS 4
+
+typedef struct {
+    ASTNode **slot;     // Posição do termo no AST original
+    int negative;       // Subtraído na sequência (só em + e -)
+} Term;
+
+typedef struct {
+    Term *items;
+    int count;
+    int capacity;
+} TermList;
+
+static void simplify(OptContext *ctx, ASTNode **slot);
+
+static void term_list_push(TermList *list, ASTNode **slot, int negative) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = (Term*)realloc(list->items, list->capacity * sizeof(Term));
+    }
+    list->items[list->count].slot = slot;
+    list->items[list->count].negative = negative;
+    list->count++;
+}
+
+static int is_literal(ASTNode *node, long long value) {
+    return node->type == AST_INTEGER && node->data.integer.value == value;
+}
+
+static int is_sum_op(ASTNode *node) {
+    return node->type == AST_BINARY_OP && !node->data.binary_op.unchecked &&
+           (strcmp(node->data.binary_op.operator, "+") == 0 ||
+            strcmp(node->data.binary_op.operator, "-") == 0);
+}
+
+static int is_product_op(ASTNode *node) {
+    return node->type == AST_BINARY_OP && strcmp(node->data.binary_op.operator, "*") == 0;
+}
+
+// Termos de uma sequência de + e -; parênteses encerram a sequência
+static void collect_sum(TermList *list, ASTNode **slot, int negative, int root) {
+    ASTNode *node = *slot;
+    if (!is_sum_op(node) || (!root && node->data.binary_op.parenthesized)) {
+        term_list_push(list, slot, negative);
+        return;
+    }
+    int minus = strcmp(node->data.binary_op.operator, "-") == 0;
+    collect_sum(list, &node->data.binary_op.left, negative, 0);
+    collect_sum(list, &node->data.binary_op.right, negative ^ minus, 0);
+}
+
+static void collect_product(TermList *list, ASTNode **slot) {
+    ASTNode *node = *slot;
+    if (!is_product_op(node)) {
+        term_list_push(list, slot, 0);
+        return;
+    }
+    collect_product(list, &node->data.binary_op.left);
+    collect_product(list, &node->data.binary_op.right);
+}
+
+// Junta dois termos com sinal: o resultado vale (*negative ? -e : e)
+static ASTNode* combine_signed(ASTNode *left, int left_neg, ASTNode *right, int right_neg, int *negative) {
+    *negative = 0;
+    if (!left_neg && !right_neg) return ast_create_binary_op("+", left, right);
+    if (!left_neg) return ast_create_binary_op("-", left, right);
+    if (!right_neg) return ast_create_binary_op("-", right, left);
+    *negative = 1;
+    return ast_create_binary_op("+", left, right);
+}
+
+// Soma dos termos [lo, hi): inclinada à esquerda ou equilibrada
+static ASTNode* build_sum(Term *terms, int lo, int hi, int balanced, int *negative) {
+    if (hi - lo == 1) {
+        *negative = terms[lo].negative;
+        return ast_clone(*terms[lo].slot);
+    }
+
+    int mid = balanced ? lo + (hi - lo + 1) / 2 : hi - 1;
+    int left_neg, right_neg;
+    ASTNode *left = build_sum(terms, lo, mid, balanced, &left_neg);
+    ASTNode *right = build_sum(terms, mid, hi, balanced, &right_neg);
+    return combine_signed(left, left_neg, right, right_neg, negative);
+}
+
+static ASTNode* build_product(Term *terms, int lo, int hi, int balanced) {
+    if (hi - lo == 1) return ast_clone(*terms[lo].slot);
+
+    int mid = balanced ? lo + (hi - lo + 1) / 2 : hi - 1;
+    return ast_create_binary_op("*", build_product(terms, lo, mid, balanced),
+                                build_product(terms, mid, hi, balanced));
+}
+
+// Troca *slot por 'replacement' se a forma mudou
+static void replace_if_changed(OptContext *ctx, ASTNode **slot, ASTNode *replacement) {
+    if (ast_equal(*slot, replacement)) {
+        ast_free(replacement);
+        return;
+    }
+    if (replacement->type == AST_BINARY_OP && (*slot)->type == AST_BINARY_OP) {
+        replacement->data.binary_op.parenthesized = (*slot)->data.binary_op.parenthesized;
+    }
+    ast_free(*slot);
+    *slot = replacement;
+    ctx->changes++;
+}
+
+static void simplify_sum(OptContext *ctx, ASTNode **slot) {
+    TermList list = { NULL, 0, 0 };
+    collect_sum(&list, slot, 0, 1);
+
+    long long constant = 0;
+    int constants = 0;
+    for (int i = 0; i < list.count; i++) {
+        simplify(ctx, list.items[i].slot);
+        ASTNode *term = *list.items[i].slot;
+        if (term->type == AST_INTEGER) {
+            long long value = term->data.integer.value;
+            constant += list.items[i].negative ? -value : value;
+            constants++;
+        }
+    }
+
+    // Soma das constantes fora de 32 bits: ficam como termos comuns
+    int fold = constants > 0 && constant >= INT32_MIN && constant <= INT32_MAX;
+
+    Term *terms = (Term*)malloc(list.count * sizeof(Term));
+    int count = 0;
+    for (int i = 0; i < list.count; i++) {
+        if (fold && (*list.items[i].slot)->type == AST_INTEGER) continue;
+        terms[count++] = list.items[i];
+    }
+
+    // x - x: termos iguais com sinais opostos se cancelam
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            if (terms[i].negative == terms[j].negative) continue;
+            if (!ast_equal(*terms[i].slot, *terms[j].slot) || opt_expr_may_trap(*terms[i].slot)) continue;
+            memmove(&terms[j], &terms[j + 1], (count - j - 1) * sizeof(Term));
+            memmove(&terms[i], &terms[i + 1], (count - i - 1) * sizeof(Term));
+            count -= 2;
+            i--;
+            break;
+        }
+    }
+
+    ASTNode *result;
+    if (count == 0) {
+        result = ast_create_integer(fold ? (int)constant : 0);
+    } else {
+        int negative;
+        result = build_sum(terms, 0, count, count >= REASSOC_MIN_TERMS, &negative);
+        if (negative) {
+            result = ast_create_binary_op("-", ast_create_integer(fold ? (int)constant : 0), result);
+        } else if (fold && constant > 0) {
+            result = ast_create_binary_op("+", result, ast_create_integer((int)constant));
+        } else if (fold && constant < 0 && constant > INT32_MIN) {
+            result = ast_create_binary_op("-", result, ast_create_integer((int)-constant));
+        } else if (fold && constant < 0) {
+            result = ast_create_binary_op("+", result, ast_create_integer((int)constant));
+        }
+    }
+
+    free(terms);
+    free(list.items);
+    replace_if_changed(ctx, slot, result);
+}
+
+static void simplify_product(OptContext *ctx, ASTNode **slot) {
+    TermList list = { NULL, 0, 0 };
+    collect_product(&list, slot);
+
+    // O produto das constantes dá a volta como o mul
+    uint32_t constant = 1;
+    int constants = 0;
+    int may_trap = 0;
+    for (int i = 0; i < list.count; i++) {
+        simplify(ctx, list.items[i].slot);
+        ASTNode *term = *list.items[i].slot;
+        if (term->type == AST_INTEGER) {
+            constant *= (uint32_t)term->data.integer.value;
+            constants++;
+        } else if (opt_expr_may_trap(term)) {
+            may_trap = 1;
+        }
+    }
+
+    Term *terms = (Term*)malloc(list.count * sizeof(Term));
+    int count = 0;
+    for (int i = 0; i < list.count; i++) {
+        if ((*list.items[i].slot)->type != AST_INTEGER) {
+            terms[count++] = list.items[i];
+        }
+    }
+
+    ASTNode *result;
+    if (count == 0 || (constant == 0 && !may_trap)) {
+        result = ast_create_integer((int32_t)constant);
+    } else {
+        result = build_product(terms, 0, count, count >= REASSOC_MIN_TERMS);
+        if (constants > 0 && constant != 1) {
+            result = ast_create_binary_op("*", result, ast_create_integer((int32_t)constant));
+        }
+    }
+
+    free(terms);
+    free(list.items);
+    replace_if_changed(ctx, slot, result);
+}
+
+// Divisor constante que não levanta exceção (0) nem transborda (-1)
+static int is_safe_divisor(ASTNode *node) {
+    return node->type == AST_INTEGER && node->data.integer.value != 0 &&
+           node->data.integer.value != -1;
+}
+
+static void simplify_quotient(OptContext *ctx, ASTNode **slot) {
+    ASTNode *node = *slot;
+    ASTNode *left = node->data.binary_op.left;
+    ASTNode *right = node->data.binary_op.right;
+
+    if (is_literal(right, 1)) {
+        node->data.binary_op.left = NULL;
+        ast_free(node);
+        *slot = left;
+        ctx->changes++;
+        return;
+    }
+
+    // (x / a) / b = x / (a * b) com truncamento em direção a zero
+    if (is_safe_divisor(right) && left->type == AST_BINARY_OP &&
+        strcmp(left->data.binary_op.operator, "/") == 0 &&
+        is_safe_divisor(left->data.binary_op.right)) {
+        long long divisor = (long long)left->data.binary_op.right->data.integer.value *
+                            right->data.integer.value;
+        if (divisor < INT32_MIN || divisor > INT32_MAX) return;
+
+        ASTNode *dividend = left->data.binary_op.left;
+        left->data.binary_op.left = NULL;
+        ast_free(left);
+        right->data.integer.value = (int)divisor;
+        node->data.binary_op.left = dividend;
+        node->data.binary_op.range.known = 0;
+        ctx->changes++;
+    }
+}
+
+static void simplify(OptContext *ctx, ASTNode **slot) {
+    ASTNode *node = *slot;
+
+    switch (node->type) {
+        case AST_UNARY_OP: {
+            simplify(ctx, &node->data.unary_op.operand);
+            ASTNode *operand = node->data.unary_op.operand;
+            if (opt_op_is(node->data.unary_op.operator, "not") &&
+                operand->type == AST_UNARY_OP && opt_op_is(operand->data.unary_op.operator, "not")) {
+                ASTNode *inner = operand->data.unary_op.operand;
+                operand->data.unary_op.operand = NULL;
+                ast_free(node);
+                *slot = inner;
+                ctx->changes++;
+            }
+            break;
+        }
+
+        case AST_BINARY_OP:
+            if (is_sum_op(node)) {
+                simplify_sum(ctx, slot);
+            } else if (is_product_op(node)) {
+                simplify_product(ctx, slot);
+            } else {
+                simplify(ctx, &node->data.binary_op.left);
+                simplify(ctx, &node->data.binary_op.right);
+                if (strcmp(node->data.binary_op.operator, "/") == 0) {
+                    simplify_quotient(ctx, slot);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void process_statement(OptContext *ctx, ASTNode *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                process_statement(ctx, stmt->data.block.statements[i]);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            simplify(ctx, &stmt->data.assignment.expression);
+            break;
+        case AST_PUT_LINE:
+            simplify(ctx, &stmt->data.put_line.expression);
+            break;
+        case AST_IF_STATEMENT:
+            simplify(ctx, &stmt->data.if_stmt.condition);
+            process_statement(ctx, stmt->data.if_stmt.then_block);
+            process_statement(ctx, stmt->data.if_stmt.else_block);
+            break;
+        case AST_WHILE_STATEMENT:
+            simplify(ctx, &stmt->data.while_stmt.condition);
+            process_statement(ctx, stmt->data.while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+void opt_algebra(ASTNode *program, OptContext *ctx) {
+    process_statement(ctx, opt_procedure_block(program));
+}
@@ -0,0 +1,412 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <ctype.h>
+
+// Numeração global de valores (GVN) sobre o AST estruturado.
+//
+// Em código estruturado a árvore de dominadores é a própria aninhação:
+// um statement domina os que vêm depois dele no mesmo bloco e tudo o que
+// está aninhado nesses. Percorremos os blocos em ordem mantendo uma pilha
+// de expressões disponíveis; ao sair de um braço de if ou de um corpo de
+// while, as entradas criadas lá dentro são descartadas.
+//
+// Uma expressão redundante é substituída por uma variável que já contém o
+// seu valor ou, se não houver, por um temporário atribuído logo antes do
+// statement da primeira ocorrência.
+
+typedef enum {
+    VN_CONST,
+    VN_UNARY,
+    VN_BINARY
+} ValueKind;
+
+// Entrada da tabela de valores: (operador, vn_esquerda, vn_direita) -> vn
+typedef struct {
+    ValueKind kind;
+    char op[8];
+    int a;
+    int b;
+    int vn;
+} ValueEntry;
+
+// Número de valor atual de cada variável
+typedef struct {
+    char *name;
+    int vn;
+} VarValue;
+
+// Ocorrência disponível de uma expressão
+typedef struct {
+    int vn;
+    ASTNode *node;   // Nó da primeira ocorrência
+    ASTNode *stmt;   // Statement que a contém
+    ASTNode *block;  // Bloco onde o statement está
+    const char *temp; // Temporário que já guarda o valor (ou NULL)
+} Available;
+
+typedef struct {
+    OptContext *ctx;
+    ValueEntry *values;
+    int value_count;
+    int value_capacity;
+    VarValue *vars;
+    int var_count;
+    int var_capacity;
+    Available *avail;
+    int avail_count;
+    int avail_capacity;
+    int next_vn;
+} GVNState;
+
+static int fresh_vn(GVNState *st) {
+    return st->next_vn++;
+}
+
+static void set_var_vn(GVNState *st, const char *name, int vn) {
+    for (int i = 0; i < st->var_count; i++) {
+        if (strcmp(st->vars[i].name, name) == 0) {
+            st->vars[i].vn = vn;
+            return;
+        }
+    }
+
+    if (st->var_count >= st->var_capacity) {
+        st->var_capacity = st->var_capacity ? st->var_capacity * 2 : 16;
+        st->vars = (VarValue*)realloc(st->vars, st->var_capacity * sizeof(VarValue));
+    }
+    st->vars[st->var_count].name = strdup(name);
+    st->vars[st->var_count].vn = vn;
+    st->var_count++;
+}
+
+static int var_vn(GVNState *st, const char *name) {
+    for (int i = 0; i < st->var_count; i++) {
+        if (strcmp(st->vars[i].name, name) == 0) {
+            return st->vars[i].vn;
+        }
+    }
+
+    // Primeiro uso: o valor de entrada é desconhecido, mas estável
+    int vn = fresh_vn(st);
+    set_var_vn(st, name, vn);
+    return vn;
+}
+
+static int lookup_value(GVNState *st, ValueKind kind, const char *op, int a, int b) {
+    for (int i = 0; i < st->value_count; i++) {
+        ValueEntry *e = &st->values[i];
+        if (e->kind == kind && e->a == a && e->b == b && strcmp(e->op, op) == 0) {
+            return e->vn;
+        }
+    }
+
+    if (st->value_count >= st->value_capacity) {
+        st->value_capacity = st->value_capacity ? st->value_capacity * 2 : 32;
+        st->values = (ValueEntry*)realloc(st->values, st->value_capacity * sizeof(ValueEntry));
+    }
+    ValueEntry *e = &st->values[st->value_count++];
+    e->kind = kind;
+    snprintf(e->op, sizeof(e->op), "%s", op);
+    e->a = a;
+    e->b = b;
+    e->vn = fresh_vn(st);
+    return e->vn;
+}
+
+static int value_number(GVNState *st, ASTNode *expr) {
+    switch (expr->type) {
+        case AST_INTEGER:
+            return lookup_value(st, VN_CONST, "", expr->data.integer.value, 0);
+
+        case AST_IDENTIFIER:
+            return var_vn(st, expr->data.identifier.name);
+
+        case AST_UNARY_OP: {
+            char op[8];
+            int i = 0;
+            for (const char *p = expr->data.unary_op.operator; *p && i < 7; p++) {
+                op[i++] = tolower((unsigned char)*p);
+            }
+            op[i] = '\0';
+            return lookup_value(st, VN_UNARY, op, value_number(st, expr->data.unary_op.operand), 0);
+        }
+
+        case AST_BINARY_OP: {
+            char op[8];
+            int i = 0;
+            for (const char *p = expr->data.binary_op.operator; *p && i < 7; p++) {
+                op[i++] = tolower((unsigned char)*p);
+            }
+            op[i] = '\0';
+
+            // Operações sem verificação de overflow não substituem as verificadas
+            if (expr->data.binary_op.unchecked && i < 7) {
+                op[i++] = 'u';
+                op[i] = '\0';
+            }
+
+            int a = value_number(st, expr->data.binary_op.left);
+            int b = value_number(st, expr->data.binary_op.right);
+
+            // Forma canônica: a > b vira b < a, operandos comutativos ordenados
+            if (strcmp(op, ">") == 0 || strcmp(op, ">=") == 0) {
+                op[0] = '<';
+                int tmp = a; a = b; b = tmp;
+            } else if (opt_is_commutative(op) && a > b) {
+                int tmp = a; a = b; b = tmp;
+            }
+            return lookup_value(st, VN_BINARY, op, a, b);
+        }
+
+        default:
+            // Strings não participam: cada literal recebe um valor único
+            return fresh_vn(st);
+    }
+}
+
+// Variável que contém o valor neste ponto, se houver
+static const char* holder_of(GVNState *st, int vn) {
+    for (int i = 0; i < st->var_count; i++) {
+        if (st->vars[i].vn == vn) {
+            return st->vars[i].name;
+        }
+    }
+    return NULL;
+}
+
+static Available* find_available(GVNState *st, int vn) {
+    for (int i = st->avail_count - 1; i >= 0; i--) {
+        if (st->avail[i].vn == vn) {
+            return &st->avail[i];
+        }
+    }
+    return NULL;
+}
+
+static void push_available(GVNState *st, int vn, ASTNode *node, ASTNode *stmt, ASTNode *block) {
+    if (st->avail_count >= st->avail_capacity) {
+        st->avail_capacity = st->avail_capacity ? st->avail_capacity * 2 : 32;
+        st->avail = (Available*)realloc(st->avail, st->avail_capacity * sizeof(Available));
+    }
+    Available *a = &st->avail[st->avail_count++];
+    a->vn = vn;
+    a->node = node;
+    a->stmt = stmt;
+    a->block = block;
+    a->temp = NULL;
+}
+
+static int node_within(ASTNode *root, ASTNode *node) {
+    if (!root) return 0;
+    if (root == node) return 1;
+
+    switch (root->type) {
+        case AST_BINARY_OP:
+            return node_within(root->data.binary_op.left, node) ||
+                   node_within(root->data.binary_op.right, node);
+        case AST_UNARY_OP:
+            return node_within(root->data.unary_op.operand, node);
+        default:
+            return 0;
+    }
+}
+
+// Materializa a primeira ocorrência em um temporário: "t := e" é inserido
+// antes do statement que a contém e a ocorrência passa a ler t.
+static const char* materialize(GVNState *st, Available *av) {
+    if (av->temp) return av->temp;
+
+    const char *temp = opt_new_temp(st->ctx, "gvn", SYMBOL_INTEGER);
+
+    ASTNode *moved = (ASTNode*)malloc(sizeof(ASTNode));
+    *moved = *av->node;
+    av->node->type = AST_IDENTIFIER;
+    av->node->data.identifier.name = strdup(temp);
+    av->node->data.identifier.range.known = 0;
+
+    ASTNode *def = ast_create_assignment(temp, moved);
+    ast_block_insert(av->block, ast_block_index_of(av->block, av->stmt), def);
+
+    // Subexpressões da ocorrência agora vivem na definição do temporário
+    for (int i = 0; i < st->avail_count; i++) {
+        if (node_within(moved, st->avail[i].node)) {
+            st->avail[i].stmt = def;
+        }
+    }
+    av->node = moved;
+    av->stmt = def;
+    av->temp = temp;
+
+    set_var_vn(st, temp, av->vn);
+    return temp;
+}
+
+// define: a expressão é sempre avaliada no statement e pode servir de
+// primeira ocorrência (condições de while não podem: o cabeçalho do laço
+// não tem onde receber a definição do temporário)
+static void process_expr(GVNState *st, ASTNode *expr, ASTNode *stmt, ASTNode *block, int define) {
+    if (!expr) return;
+    if (expr->type != AST_BINARY_OP && expr->type != AST_UNARY_OP) return;
+
+    int vn = value_number(st, expr);
+
+    const char *holder = holder_of(st, vn);
+    if (holder) {
+        opt_make_identifier(expr, holder);
+        st->ctx->changes++;
+        return;
+    }
+
+    Available *av = find_available(st, vn);
+    if (av) {
+        const char *temp = materialize(st, av);
+        opt_make_identifier(expr, temp);
+        st->ctx->changes++;
+        return;
+    }
+
+    if (expr->type == AST_BINARY_OP) {
+        // O operando direito de and/or pode não ser avaliado (curto-circuito),
+        // então não define valores disponíveis para o resto do programa
+        const char *op = expr->data.binary_op.operator;
+        int conditional = opt_op_is(op, "and") || opt_op_is(op, "or");
+        process_expr(st, expr->data.binary_op.left, stmt, block, define);
+        process_expr(st, expr->data.binary_op.right, stmt, block, define && !conditional);
+    } else {
+        process_expr(st, expr->data.unary_op.operand, stmt, block, define);
+    }
+
+    if (define) {
+        push_available(st, vn, expr, stmt, block);
+    }
+}
+
+// Cópia dos números de valor das variáveis (para os braços de um if)
+typedef struct {
+    int *vns;
+    int count;
+} VarSnapshot;
+
+static VarSnapshot take_snapshot(GVNState *st) {
+    VarSnapshot snap;
+    snap.count = st->var_count;
+    snap.vns = (int*)malloc((snap.count > 0 ? snap.count : 1) * sizeof(int));
+    for (int i = 0; i < snap.count; i++) {
+        snap.vns[i] = st->vars[i].vn;
+    }
+    return snap;
+}
+
+static void restore_snapshot(GVNState *st, VarSnapshot *snap) {
+    for (int i = snap->count; i < st->var_count; i++) {
+        free(st->vars[i].name);
+    }
+    st->var_count = snap->count;
+    for (int i = 0; i < snap->count; i++) {
+        st->vars[i].vn = snap->vns[i];
+    }
+}
+
+static void kill_assigned(GVNState *st, ASTNode *stmt) {
+    NameSet assigned;
+    name_set_init(&assigned);
+    opt_collect_assigned(stmt, &assigned);
+    for (int i = 0; i < assigned.count; i++) {
+        set_var_vn(st, assigned.names[i], fresh_vn(st));
+    }
+    name_set_free(&assigned);
+}
+
+static void process_block(GVNState *st, ASTNode *block);
+
+static void process_statement(GVNState *st, ASTNode *stmt, ASTNode *block) {
+    switch (stmt->type) {
+        case AST_ASSIGNMENT: {
+            process_expr(st, stmt->data.assignment.expression, stmt, block, 1);
+            int vn = value_number(st, stmt->data.assignment.expression);
+            set_var_vn(st, stmt->data.assignment.identifier, vn);
+            break;
+        }
+
+        case AST_GET_LINE:
+            set_var_vn(st, stmt->data.get_line.identifier, fresh_vn(st));
+            break;
+
+        case AST_PUT_LINE:
+            process_expr(st, stmt->data.put_line.expression, stmt, block, 1);
+            break;
+
+        case AST_IF_STATEMENT: {
+            process_expr(st, stmt->data.if_stmt.condition, stmt, block, 1);
+
+            int mark = st->avail_count;
+            VarSnapshot snap = take_snapshot(st);
+
+            process_block(st, stmt->data.if_stmt.then_block);
+            st->avail_count = mark;
+            restore_snapshot(st, &snap);
+
+            if (stmt->data.if_stmt.else_block) {
+                process_block(st, stmt->data.if_stmt.else_block);
+                st->avail_count = mark;
+                restore_snapshot(st, &snap);
+            }
+            free(snap.vns);
+
+            // Depois da junção, o que foi escrito em qualquer braço é desconhecido
+            kill_assigned(st, stmt);
+            break;
+        }
+
+        case AST_WHILE_STATEMENT: {
+            // O cabeçalho é alcançado pela aresta de retorno: tudo o que o
+            // corpo escreve tem valor desconhecido já na condição
+            kill_assigned(st, stmt);
+
+            int mark = st->avail_count;
+            VarSnapshot snap = take_snapshot(st);
+
+            process_expr(st, stmt->data.while_stmt.condition, stmt, block, 0);
+            process_block(st, stmt->data.while_stmt.body);
+
+            st->avail_count = mark;
+            restore_snapshot(st, &snap);
+            free(snap.vns);
+            break;
+        }
+
+        case AST_BLOCK:
+            process_block(st, stmt);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void process_block(GVNState *st, ASTNode *block) {
+    if (!block) return;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+        process_statement(st, stmt, block);
+        // Definições de temporários podem ter sido inseridas antes de stmt
+        i = ast_block_index_of(block, stmt);
+    }
+}
+
+void opt_gvn(ASTNode *program, OptContext *ctx) {
+    GVNState st;
+    memset(&st, 0, sizeof(st));
+    st.ctx = ctx;
+
+    process_block(&st, opt_procedure_block(program));
+
+    for (int i = 0; i < st.var_count; i++) {
+        free(st.vars[i].name);
+    }
+    free(st.vars);
+    free(st.values);
+    free(st.avail);
+}
@@ -0,0 +1,448 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Variáveis de indução e redução de força em laços.
+//
+// Uma variável básica de indução i é escrita uma única vez no laço, por um
+// statement do nível do corpo da forma "i := i + c" (ou "i := i - c") com c
+// literal. Cada produto i * k, com k literal ou invariante, vira uma variável
+// derivada j mantida por soma:
+//
+//     j := i * k;                -- pré-cabeçalho
+//     while ... loop
+//        ... j ...               -- no lugar de i * k
+//        i := i + c;
+//        j := j + c * k;         -- soma sem verificação de overflow
+//     end loop;
+//
+// A soma usa aritmética módulo 2^32, igual à multiplicação que substitui,
+// então o valor de j é sempre exatamente o de i * k.
+//
+// Se depois disso i só é lido pelo próprio incremento e por um teste de saída
+// "i REL N", não é lido depois do laço e o intervalo de valores que i percorre
+// é conhecido, o teste é reescrito como "j REL' N * k" e i é eliminada.
+
+typedef struct {
+    ASTNode *factor;    // k (literal ou identificador invariante)
+    const char *temp;   // Variável derivada j = i * k
+} Derived;
+
+typedef struct {
+    OptContext *ctx;
+    ASTNode *root;          // Bloco do procedimento (para liveness)
+    ASTNode *parent;        // Bloco que contém o while
+    ASTNode *loop;
+    NameSet assigned;       // Variáveis escritas no laço
+    const char *iv;         // Variável básica de indução
+    ASTNode *increment;     // "i := i + c"
+    long long step;         // c (negativo para "i := i - c")
+    Derived *derived;
+    int count;
+    int capacity;
+} IVState;
+
+static int is_identifier(ASTNode *expr, const char *name) {
+    return expr->type == AST_IDENTIFIER && strcmp(expr->data.identifier.name, name) == 0;
+}
+
+// Fator k de um produto i * k (ou k * i) utilizável como derivada
+static ASTNode* product_factor(IVState *st, ASTNode *expr) {
+    if (expr->type != AST_BINARY_OP || !opt_op_is(expr->data.binary_op.operator, "*")) {
+        return NULL;
+    }
+
+    ASTNode *left = expr->data.binary_op.left;
+    ASTNode *right = expr->data.binary_op.right;
+    ASTNode *factor;
+
+    if (is_identifier(left, st->iv)) {
+        factor = right;
+    } else if (is_identifier(right, st->iv)) {
+        factor = left;
+    } else {
+        return NULL;
+    }
+
+    if (factor->type == AST_INTEGER) {
+        return factor->data.integer.value != 0 ? factor : NULL;
+    }
+    if (factor->type == AST_IDENTIFIER &&
+        !name_set_contains(&st->assigned, factor->data.identifier.name)) {
+        return factor;
+    }
+    return NULL;
+}
+
+static Derived* find_derived(IVState *st, ASTNode *factor) {
+    for (int i = 0; i < st->count; i++) {
+        if (ast_equal(st->derived[i].factor, factor)) {
+            return &st->derived[i];
+        }
+    }
+    return NULL;
+}
+
+static void collect_products_expr(IVState *st, ASTNode *expr) {
+    if (!expr) return;
+
+    ASTNode *factor = product_factor(st, expr);
+    if (factor) {
+        if (!find_derived(st, factor)) {
+            if (st->count >= st->capacity) {
+                st->capacity = st->capacity ? st->capacity * 2 : 4;
+                st->derived = (Derived*)realloc(st->derived, st->capacity * sizeof(Derived));
+            }
+            // Cópia: o produto original é substituído depois
+            st->derived[st->count].factor = ast_clone(factor);
+            st->derived[st->count].temp = NULL;
+            st->count++;
+        }
+        return;
+    }
+
+    if (expr->type == AST_BINARY_OP) {
+        collect_products_expr(st, expr->data.binary_op.left);
+        collect_products_expr(st, expr->data.binary_op.right);
+    } else if (expr->type == AST_UNARY_OP) {
+        collect_products_expr(st, expr->data.unary_op.operand);
+    }
+}
+
+static void collect_products(IVState *st, ASTNode *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                collect_products(st, stmt->data.block.statements[i]);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            collect_products_expr(st, stmt->data.assignment.expression);
+            break;
+        case AST_PUT_LINE:
+            collect_products_expr(st, stmt->data.put_line.expression);
+            break;
+        case AST_IF_STATEMENT:
+            collect_products_expr(st, stmt->data.if_stmt.condition);
+            collect_products(st, stmt->data.if_stmt.then_block);
+            collect_products(st, stmt->data.if_stmt.else_block);
+            break;
+        case AST_WHILE_STATEMENT:
+            collect_products_expr(st, stmt->data.while_stmt.condition);
+            collect_products(st, stmt->data.while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+// Verdadeiro se i aparece na expressão fora de um produto reconhecido
+static int loose_use_expr(IVState *st, ASTNode *expr) {
+    if (!expr) return 0;
+    if (product_factor(st, expr)) return 0;
+
+    switch (expr->type) {
+        case AST_IDENTIFIER:
+            return strcmp(expr->data.identifier.name, st->iv) == 0;
+        case AST_BINARY_OP:
+            return loose_use_expr(st, expr->data.binary_op.left) ||
+                   loose_use_expr(st, expr->data.binary_op.right);
+        case AST_UNARY_OP:
+            return loose_use_expr(st, expr->data.unary_op.operand);
+        default:
+            return 0;
+    }
+}
+
+static int loose_use(IVState *st, ASTNode *stmt) {
+    if (!stmt || stmt == st->increment) return 0;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                if (loose_use(st, stmt->data.block.statements[i])) return 1;
+            }
+            return 0;
+        case AST_ASSIGNMENT:
+            return loose_use_expr(st, stmt->data.assignment.expression);
+        case AST_PUT_LINE:
+            return loose_use_expr(st, stmt->data.put_line.expression);
+        case AST_IF_STATEMENT:
+            return loose_use_expr(st, stmt->data.if_stmt.condition) ||
+                   loose_use(st, stmt->data.if_stmt.then_block) ||
+                   loose_use(st, stmt->data.if_stmt.else_block);
+        case AST_WHILE_STATEMENT:
+            return loose_use_expr(st, stmt->data.while_stmt.condition) ||
+                   loose_use(st, stmt->data.while_stmt.body);
+        default:
+            return 0;
+    }
+}
+
+// Decide se i pode ser eliminada em favor da derivada de fator literal.
+// Calcula o intervalo [lo, hi] dos valores de i e confere que nenhum
+// produto sai de 32 bits, assim "i REL N" equivale a "i*k REL' N*k".
+static Derived* elimination_target(IVState *st, ASTNode **init_def, const char **rel,
+                                   long long *bound) {
+    if (loose_use(st, st->loop->data.while_stmt.body)) return NULL;
+    if (!opt_match_bound_test(st->loop->data.while_stmt.condition, st->iv, rel, bound)) return NULL;
+    if (opt_var_live_after(st->root, st->loop, st->iv)) return NULL;
+
+    *init_def = opt_reaching_constant(st->parent, st->loop, st->iv);
+    if (!*init_def) return NULL;
+    long long init = (*init_def)->data.assignment.expression->data.integer.value;
+
+    // O passo precisa aproximar i do limite
+    long long c = st->step;
+    int upward = strcmp(*rel, "<") == 0 || strcmp(*rel, "<=") == 0;
+    if ((c > 0) != upward) return NULL;
+
+    long long last = strcmp(*rel, "<") == 0 ? *bound - 1 :
+                     strcmp(*rel, ">") == 0 ? *bound + 1 : *bound;
+    long long lo, hi;
+    if (c > 0) {
+        lo = init;
+        hi = init > last + c ? init : last + c;
+    } else {
+        hi = init;
+        lo = init < last + c ? init : last + c;
+    }
+    if (!opt_fits_int32(lo) || !opt_fits_int32(hi)) return NULL;
+
+    for (int i = 0; i < st->count; i++) {
+        ASTNode *factor = st->derived[i].factor;
+        if (factor->type != AST_INTEGER) continue;
+
+        long long k = factor->data.integer.value;
+        if (opt_fits_int32(lo * k) && opt_fits_int32(hi * k) && opt_fits_int32(*bound * k)) {
+            return &st->derived[i];
+        }
+    }
+    return NULL;
+}
+
+// Multiplicação por constante já vira poucos shifts/somas no gerador de
+// código, o que custa tanto quanto manter a derivada atualizada na memória
+static int cheap_factor(ASTNode *factor) {
+    return factor->type == AST_INTEGER;
+}
+
+static void replace_products_expr(IVState *st, ASTNode *expr) {
+    if (!expr) return;
+
+    ASTNode *factor = product_factor(st, expr);
+    if (factor) {
+        Derived *d = find_derived(st, factor);
+        if (d && d->temp) {
+            opt_make_identifier(expr, d->temp);
+            st->ctx->changes++;
+        }
+        return;
+    }
+
+    if (expr->type == AST_BINARY_OP) {
+        replace_products_expr(st, expr->data.binary_op.left);
+        replace_products_expr(st, expr->data.binary_op.right);
+    } else if (expr->type == AST_UNARY_OP) {
+        replace_products_expr(st, expr->data.unary_op.operand);
+    }
+}
+
+static void replace_products(IVState *st, ASTNode *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                replace_products(st, stmt->data.block.statements[i]);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            replace_products_expr(st, stmt->data.assignment.expression);
+            break;
+        case AST_PUT_LINE:
+            replace_products_expr(st, stmt->data.put_line.expression);
+            break;
+        case AST_IF_STATEMENT:
+            replace_products_expr(st, stmt->data.if_stmt.condition);
+            replace_products(st, stmt->data.if_stmt.then_block);
+            replace_products(st, stmt->data.if_stmt.else_block);
+            break;
+        case AST_WHILE_STATEMENT:
+            replace_products_expr(st, stmt->data.while_stmt.condition);
+            replace_products(st, stmt->data.while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+static ASTNode* unchecked_op(const char *op, ASTNode *left, ASTNode *right) {
+    ASTNode *node = ast_create_binary_op(op, left, right);
+    node->data.binary_op.unchecked = 1;
+    return node;
+}
+
+// Cria a derivada: inicialização no pré-cabeçalho e atualização logo
+// depois do incremento de i
+static void create_derived(IVState *st, Derived *d, ASTNode *init_def) {
+    d->temp = opt_new_temp(st->ctx, "iv", SYMBOL_INTEGER);
+
+    ASTNode *init;
+    if (init_def && d->factor->type == AST_INTEGER) {
+        // i*k cabe em 32 bits (verificado na eliminação)
+        init = ast_create_integer((int)(init_def->data.assignment.expression->data.integer.value *
+                                        (long long)d->factor->data.integer.value));
+    } else {
+        init = ast_create_binary_op("*", ast_create_identifier(st->iv), ast_clone(d->factor));
+    }
+    ast_block_insert(st->parent, ast_block_index_of(st->parent, st->loop),
+                     ast_create_assignment(d->temp, init));
+
+    long long c = st->step;
+    long long magnitude = c < 0 ? -c : c;
+    const char *op = c < 0 ? "-" : "+";
+    ASTNode *delta;
+
+    if (d->factor->type == AST_INTEGER) {
+        // Passo c*k reduzido módulo 2^32, como a soma que o usa
+        uint32_t wrapped = (uint32_t)magnitude * (uint32_t)d->factor->data.integer.value;
+        delta = ast_create_integer((int)wrapped);
+    } else if (magnitude == 1) {
+        delta = ast_clone(d->factor);
+    } else {
+        const char *scaled = opt_new_temp(st->ctx, "iv", SYMBOL_INTEGER);
+        ASTNode *product = ast_create_binary_op("*", ast_clone(d->factor),
+                                                ast_create_integer((int)magnitude));
+        ast_block_insert(st->parent, ast_block_index_of(st->parent, st->loop),
+                         ast_create_assignment(scaled, product));
+        delta = ast_create_identifier(scaled);
+    }
+
+    ASTNode *body = st->loop->data.while_stmt.body;
+    ASTNode *update = ast_create_assignment(d->temp,
+                                            unchecked_op(op, ast_create_identifier(d->temp), delta));
+    ast_block_insert(body, ast_block_index_of(body, st->increment) + 1, update);
+    st->ctx->changes++;
+}
+
+// Reescreve o teste de saída sobre j e remove i do laço
+static void eliminate(IVState *st, Derived *d, ASTNode *init_def, const char *rel, long long bound) {
+    long long k = d->factor->data.integer.value;
+    ASTNode *loop = st->loop;
+
+    // rel aponta para o operador da condição antiga
+    ASTNode *cond = ast_create_binary_op(k < 0 ? opt_flip_relation(rel) : rel,
+                                         ast_create_identifier(d->temp),
+                                         ast_create_integer((int)(bound * k)));
+    ast_free(loop->data.while_stmt.condition);
+    loop->data.while_stmt.condition = cond;
+
+    ASTNode *body = loop->data.while_stmt.body;
+    ast_free(ast_block_remove(body, ast_block_index_of(body, st->increment)));
+    st->increment = NULL;
+
+    // A inicialização de i ficou sem leitores
+    if (!opt_var_live_after(st->root, init_def, st->iv)) {
+        ast_free(ast_block_remove(st->parent, ast_block_index_of(st->parent, init_def)));
+    }
+    st->ctx->changes++;
+}
+
+static void reduce_induction(IVState *st) {
+    collect_products_expr(st, st->loop->data.while_stmt.condition);
+    collect_products(st, st->loop->data.while_stmt.body);
+    if (st->count == 0) return;
+
+    ASTNode *init_def = NULL;
+    const char *rel = NULL;
+    long long bound = 0;
+    Derived *target = elimination_target(st, &init_def, &rel, &bound);
+
+    // Sem eliminação, só compensa trocar multiplicações caras
+    for (int i = 0; i < st->count; i++) {
+        Derived *d = &st->derived[i];
+        if (target || !cheap_factor(d->factor)) {
+            create_derived(st, d, d == target ? init_def : NULL);
+        }
+    }
+
+    replace_products_expr(st, st->loop->data.while_stmt.condition);
+    replace_products(st, st->loop->data.while_stmt.body);
+
+    if (target) {
+        eliminate(st, target, init_def, rel, bound);
+    }
+}
+
+static void process_block(OptContext *ctx, ASTNode *root, ASTNode *block);
+
+static void process_loop(OptContext *ctx, ASTNode *root, ASTNode *parent, ASTNode *loop) {
+    ASTNode *body = loop->data.while_stmt.body;
+
+    // Candidatos: incrementos do nível do corpo (a lista é copiada porque
+    // o corpo recebe as atualizações das derivadas)
+    int count = body->data.block.count;
+    ASTNode **candidates = (ASTNode**)malloc((count ? count : 1) * sizeof(ASTNode*));
+    memcpy(candidates, body->data.block.statements, count * sizeof(ASTNode*));
+
+    for (int i = 0; i < count; i++) {
+        ASTNode *stmt = candidates[i];
+        long long step;
+
+        if (ast_block_index_of(body, stmt) < 0) continue;
+        if (!opt_match_increment(stmt, &step)) continue;
+        if (stmt->data.assignment.expression->data.binary_op.unchecked) continue;
+        if (opt_count_writes(loop, stmt->data.assignment.identifier) != 1) continue;
+
+        IVState st;
+        st.ctx = ctx;
+        st.root = root;
+        st.parent = parent;
+        st.loop = loop;
+        st.iv = strdup(stmt->data.assignment.identifier);
+        st.increment = stmt;
+        st.step = step;
+        st.derived = NULL;
+        st.count = 0;
+        st.capacity = 0;
+        name_set_init(&st.assigned);
+        opt_collect_assigned(loop, &st.assigned);
+
+        reduce_induction(&st);
+
+        for (int j = 0; j < st.count; j++) {
+            ast_free(st.derived[j].factor);
+        }
+        free(st.derived);
+        free((char*)st.iv);
+        name_set_free(&st.assigned);
+    }
+    free(candidates);
+
+    process_block(ctx, root, body);
+}
+
+static void process_block(OptContext *ctx, ASTNode *root, ASTNode *block) {
+    if (!block) return;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+
+        if (stmt->type == AST_WHILE_STATEMENT) {
+            process_loop(ctx, root, block, stmt);
+            i = ast_block_index_of(block, stmt);
+        } else if (stmt->type == AST_IF_STATEMENT) {
+            process_block(ctx, root, stmt->data.if_stmt.then_block);
+            process_block(ctx, root, stmt->data.if_stmt.else_block);
+        }
+    }
+}
+
+void opt_iv(ASTNode *program, OptContext *ctx) {
+    ASTNode *root = opt_procedure_block(program);
+    process_block(ctx, root, root);
+}
@@ -0,0 +1,162 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+
+// Movimentação de código invariante em laços (LICM).
+//
+// Uma subexpressão de um while cujos operandos não são escritos em lugar
+// nenhum do laço tem o mesmo valor em todas as iterações. Ela é calculada
+// uma única vez em um pré-cabeçalho ("t := e" logo antes do while) e as
+// ocorrências passam a ler t. Laços externos são tratados primeiro, assim
+// uma expressão invariante em vários níveis sobe até o laço mais externo.
+
+typedef struct {
+    ASTNode *expr;      // Cópia da expressão içada
+    const char *temp;   // Temporário do pré-cabeçalho
+} Hoisted;
+
+typedef struct {
+    OptContext *ctx;
+    ASTNode *parent;    // Bloco que contém o while
+    ASTNode *loop;
+    NameSet assigned;   // Variáveis escritas no laço
+    Hoisted *hoisted;
+    int count;
+    int capacity;
+} LoopState;
+
+static int is_invariant(ASTNode *expr, const NameSet *assigned) {
+    switch (expr->type) {
+        case AST_INTEGER:
+            return 1;
+        case AST_IDENTIFIER:
+            return !name_set_contains(assigned, expr->data.identifier.name);
+        case AST_BINARY_OP:
+            return is_invariant(expr->data.binary_op.left, assigned) &&
+                   is_invariant(expr->data.binary_op.right, assigned);
+        case AST_UNARY_OP:
+            return is_invariant(expr->data.unary_op.operand, assigned);
+        default:
+            return 0;
+    }
+}
+
+static void hoist(LoopState *ls, ASTNode *expr) {
+    // Expressões iguais compartilham o mesmo temporário
+    for (int i = 0; i < ls->count; i++) {
+        if (ast_equal(ls->hoisted[i].expr, expr)) {
+            opt_make_identifier(expr, ls->hoisted[i].temp);
+            ls->ctx->changes++;
+            return;
+        }
+    }
+
+    const char *temp = opt_new_temp(ls->ctx, "licm", SYMBOL_INTEGER);
+    ASTNode *def = ast_create_assignment(temp, ast_clone(expr));
+    ast_block_insert(ls->parent, ast_block_index_of(ls->parent, ls->loop), def);
+
+    if (ls->count >= ls->capacity) {
+        ls->capacity = ls->capacity ? ls->capacity * 2 : 8;
+        ls->hoisted = (Hoisted*)realloc(ls->hoisted, ls->capacity * sizeof(Hoisted));
+    }
+    ls->hoisted[ls->count].expr = def->data.assignment.expression;
+    ls->hoisted[ls->count].temp = temp;
+    ls->count++;
+
+    opt_make_identifier(expr, temp);
+    ls->ctx->changes++;
+}
+
+// always: a expressão é avaliada sempre que o cabeçalho executa, então
+// içá-la não pode introduzir uma exceção que o programa não levantaria
+static void hoist_expr(LoopState *ls, ASTNode *expr, int always) {
+    if (!expr) return;
+    if (expr->type != AST_BINARY_OP && expr->type != AST_UNARY_OP) return;
+
+    if (is_invariant(expr, &ls->assigned) && (always || !opt_expr_may_trap(expr))) {
+        hoist(ls, expr);
+        return;
+    }
+
+    if (expr->type == AST_BINARY_OP) {
+        // O operando direito de and/or só roda se o esquerdo não decidir
+        const char *op = expr->data.binary_op.operator;
+        int conditional = opt_op_is(op, "and") || opt_op_is(op, "or");
+        hoist_expr(ls, expr->data.binary_op.left, always);
+        hoist_expr(ls, expr->data.binary_op.right, always && !conditional);
+    } else {
+        hoist_expr(ls, expr->data.unary_op.operand, always);
+    }
+}
+
+static void hoist_statement(LoopState *ls, ASTNode *stmt) {
+    if (!stmt) return;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                hoist_statement(ls, stmt->data.block.statements[i]);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            hoist_expr(ls, stmt->data.assignment.expression, 0);
+            break;
+        case AST_PUT_LINE:
+            hoist_expr(ls, stmt->data.put_line.expression, 0);
+            break;
+        case AST_IF_STATEMENT:
+            hoist_expr(ls, stmt->data.if_stmt.condition, 0);
+            hoist_statement(ls, stmt->data.if_stmt.then_block);
+            hoist_statement(ls, stmt->data.if_stmt.else_block);
+            break;
+        case AST_WHILE_STATEMENT:
+            hoist_expr(ls, stmt->data.while_stmt.condition, 0);
+            hoist_statement(ls, stmt->data.while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+static void process_block(OptContext *ctx, ASTNode *block);
+
+static void process_loop(OptContext *ctx, ASTNode *parent, ASTNode *loop) {
+    LoopState ls;
+    ls.ctx = ctx;
+    ls.parent = parent;
+    ls.loop = loop;
+    ls.hoisted = NULL;
+    ls.count = 0;
+    ls.capacity = 0;
+    name_set_init(&ls.assigned);
+    opt_collect_assigned(loop, &ls.assigned);
+
+    hoist_expr(&ls, loop->data.while_stmt.condition, 1);
+    hoist_statement(&ls, loop->data.while_stmt.body);
+
+    free(ls.hoisted);
+    name_set_free(&ls.assigned);
+
+    // Laços internos recebem seus próprios pré-cabeçalhos
+    process_block(ctx, loop->data.while_stmt.body);
+}
+
+static void process_block(OptContext *ctx, ASTNode *block) {
+    if (!block) return;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+
+        if (stmt->type == AST_WHILE_STATEMENT) {
+            process_loop(ctx, block, stmt);
+            i = ast_block_index_of(block, stmt);
+        } else if (stmt->type == AST_IF_STATEMENT) {
+            process_block(ctx, stmt->data.if_stmt.then_block);
+            process_block(ctx, stmt->data.if_stmt.else_block);
+        }
+    }
+}
+
+void opt_licm(ASTNode *program, OptContext *ctx) {
+    process_block(ctx, opt_procedure_block(program));
+}
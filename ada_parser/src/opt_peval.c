@@ -0,0 +1,323 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Avaliação parcial do programa (opcional, -fpartial-eval).
+//
+// Executa os statements do procedimento em tempo de compilação, um a um,
+// enquanto nada depender de entrada. O prefixo executado é trocado pela saída
+// que ele produziu (Put_Line de literais) e pelo estado final das variáveis
+// que o restante do programa ainda lê; o resto é compilado normalmente.
+//
+// A avaliação para antes do primeiro statement do nível do procedimento que:
+// lê uma entrada (Get_Line), lê uma variável de valor desconhecido, levantaria
+// uma exceção em tempo de execução ou estoura o orçamento de passos. Os efeitos
+// parciais desse statement são descartados, então um laço longo é executado
+// inteiro ou não é executado.
+//
+// A semântica segue a do gerador de código: + e - verificam overflow, * dá a
+// volta módulo 2^32, / por zero levanta exceção e and/or não avaliam o operando
+// direito quando o esquerdo decide.
+
+// Limite de valores impressos trocados por literais
+#define PEVAL_MAX_OUTPUTS 1024
+
+typedef struct {
+    char *name;
+    int value;
+} PEVar;
+
+typedef struct {
+    PEVar *vars;
+    int count;
+    int capacity;
+} PEEnv;
+
+typedef struct {
+    OptContext *ctx;
+    PEEnv env;
+    ASTNode **outputs;      // Literais impressos (inteiro ou string)
+    int output_count;
+    int output_capacity;
+    long long steps;        // Passos restantes
+} PEState;
+
+typedef enum {
+    PE_OK,
+    PE_STOP     // Não dá para avaliar em tempo de compilação
+} PEResult;
+
+static PEVar* env_find(PEEnv *env, const char *name) {
+    for (int i = 0; i < env->count; i++) {
+        if (strcmp(env->vars[i].name, name) == 0) {
+            return &env->vars[i];
+        }
+    }
+    return NULL;
+}
+
+static void env_set(PEEnv *env, const char *name, int value) {
+    PEVar *var = env_find(env, name);
+    if (var) {
+        var->value = value;
+        return;
+    }
+
+    if (env->count >= env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 16;
+        env->vars = (PEVar*)realloc(env->vars, env->capacity * sizeof(PEVar));
+    }
+    env->vars[env->count].name = strdup(name);
+    env->vars[env->count].value = value;
+    env->count++;
+}
+
+static void env_copy(PEEnv *dst, const PEEnv *src) {
+    for (int i = 0; i < dst->count; i++) {
+        free(dst->vars[i].name);
+    }
+    dst->count = 0;
+    for (int i = 0; i < src->count; i++) {
+        env_set(dst, src->vars[i].name, src->vars[i].value);
+    }
+}
+
+static void env_free(PEEnv *env) {
+    for (int i = 0; i < env->count; i++) {
+        free(env->vars[i].name);
+    }
+    free(env->vars);
+    env->vars = NULL;
+    env->count = 0;
+    env->capacity = 0;
+}
+
+static void push_output(PEState *st, ASTNode *literal) {
+    if (st->output_count >= st->output_capacity) {
+        st->output_capacity = st->output_capacity ? st->output_capacity * 2 : 16;
+        st->outputs = (ASTNode**)realloc(st->outputs, st->output_capacity * sizeof(ASTNode*));
+    }
+    st->outputs[st->output_count++] = literal;
+}
+
+static void truncate_outputs(PEState *st, int count) {
+    while (st->output_count > count) {
+        ast_free(st->outputs[--st->output_count]);
+    }
+}
+
+static PEResult eval_expr(PEState *st, ASTNode *expr, int *value) {
+    if (--st->steps < 0) return PE_STOP;
+
+    switch (expr->type) {
+        case AST_INTEGER:
+            *value = expr->data.integer.value;
+            return PE_OK;
+
+        case AST_IDENTIFIER: {
+            PEVar *var = env_find(&st->env, expr->data.identifier.name);
+            if (!var) return PE_STOP;
+            *value = var->value;
+            return PE_OK;
+        }
+
+        case AST_UNARY_OP: {
+            int operand;
+            if (eval_expr(st, expr->data.unary_op.operand, &operand) != PE_OK) return PE_STOP;
+
+            if (opt_op_is(expr->data.unary_op.operator, "not")) {
+                *value = operand ^ 1;
+            } else if (strcmp(expr->data.unary_op.operator, "-") == 0) {
+                if (operand == INT32_MIN) return PE_STOP;
+                *value = -operand;
+            } else {
+                return PE_STOP;
+            }
+            return PE_OK;
+        }
+
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            int left, right;
+
+            if (eval_expr(st, expr->data.binary_op.left, &left) != PE_OK) return PE_STOP;
+
+            // Curto-circuito, como no código gerado
+            if (opt_op_is(op, "and") || opt_op_is(op, "or")) {
+                int is_and = opt_op_is(op, "and");
+                if ((left != 0) != is_and) {
+                    *value = left != 0;
+                    return PE_OK;
+                }
+                if (eval_expr(st, expr->data.binary_op.right, &right) != PE_OK) return PE_STOP;
+                *value = right != 0;
+                return PE_OK;
+            }
+
+            if (eval_expr(st, expr->data.binary_op.right, &right) != PE_OK) return PE_STOP;
+
+            long long wide;
+            if (strcmp(op, "+") == 0 || strcmp(op, "-") == 0) {
+                wide = strcmp(op, "+") == 0 ? (long long)left + right : (long long)left - right;
+                if (expr->data.binary_op.unchecked) {
+                    *value = (int)(uint32_t)wide;
+                } else if (wide < INT32_MIN || wide > INT32_MAX) {
+                    return PE_STOP;
+                } else {
+                    *value = (int)wide;
+                }
+            } else if (strcmp(op, "*") == 0) {
+                *value = (int)((uint32_t)left * (uint32_t)right);
+            } else if (strcmp(op, "/") == 0) {
+                if (right == 0 || (left == INT32_MIN && right == -1)) return PE_STOP;
+                *value = left / right;
+            } else if (strcmp(op, "<") == 0) {
+                *value = left < right;
+            } else if (strcmp(op, "<=") == 0) {
+                *value = left <= right;
+            } else if (strcmp(op, ">") == 0) {
+                *value = left > right;
+            } else if (strcmp(op, ">=") == 0) {
+                *value = left >= right;
+            } else if (strcmp(op, "=") == 0) {
+                *value = left == right;
+            } else if (strcmp(op, "/=") == 0) {
+                *value = left != right;
+            } else {
+                return PE_STOP;
+            }
+            return PE_OK;
+        }
+
+        default:
+            // Strings só são avaliadas diretamente em Put_Line
+            return PE_STOP;
+    }
+}
+
+static PEResult exec_statement(PEState *st, ASTNode *stmt);
+
+static PEResult exec_block(PEState *st, ASTNode *block) {
+    if (!block) return PE_OK;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        if (exec_statement(st, block->data.block.statements[i]) != PE_OK) return PE_STOP;
+    }
+    return PE_OK;
+}
+
+static PEResult exec_statement(PEState *st, ASTNode *stmt) {
+    if (--st->steps < 0) return PE_STOP;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            return exec_block(st, stmt);
+
+        case AST_ASSIGNMENT: {
+            int value;
+            if (eval_expr(st, stmt->data.assignment.expression, &value) != PE_OK) return PE_STOP;
+            env_set(&st->env, stmt->data.assignment.identifier, value);
+            return PE_OK;
+        }
+
+        case AST_PUT_LINE: {
+            ASTNode *expr = stmt->data.put_line.expression;
+            if (st->output_count >= PEVAL_MAX_OUTPUTS) return PE_STOP;
+
+            if (expr->type == AST_STRING) {
+                push_output(st, ast_clone(expr));
+            } else if (expr->type == AST_INTEGER || expr->type == AST_IDENTIFIER ||
+                       expr->type == AST_BINARY_OP) {
+                int value;
+                if (eval_expr(st, expr, &value) != PE_OK) return PE_STOP;
+                push_output(st, ast_create_integer(value));
+            }
+            // Outras expressões não geram saída (mips_gen_put_line as ignora)
+            return PE_OK;
+        }
+
+        case AST_IF_STATEMENT: {
+            int cond;
+            if (eval_expr(st, stmt->data.if_stmt.condition, &cond) != PE_OK) return PE_STOP;
+            return exec_block(st, cond ? stmt->data.if_stmt.then_block : stmt->data.if_stmt.else_block);
+        }
+
+        case AST_WHILE_STATEMENT:
+            for (;;) {
+                int cond;
+                if (eval_expr(st, stmt->data.while_stmt.condition, &cond) != PE_OK) return PE_STOP;
+                if (!cond) return PE_OK;
+                if (exec_block(st, stmt->data.while_stmt.body) != PE_OK) return PE_STOP;
+            }
+
+        default:
+            // Get_Line depende da entrada
+            return PE_STOP;
+    }
+}
+
+// Troca os statements [0, prefix) pela saída produzida e pelas atribuições
+// finais das variáveis que o restante ainda lê
+static void replace_prefix(PEState *st, ASTNode *root, int prefix) {
+    ASTNode *last = root->data.block.statements[prefix - 1];
+    int index = 0;
+
+    for (int i = 0; i < st->output_count; i++) {
+        ast_block_insert(root, index++, ast_create_put_line(st->outputs[i]));
+    }
+    st->output_count = 0;
+
+    for (int i = 0; i < st->env.count; i++) {
+        PEVar *var = &st->env.vars[i];
+        if (opt_var_live_after(root, last, var->name)) {
+            ast_block_insert(root, index++,
+                             ast_create_assignment(var->name, ast_create_integer(var->value)));
+        }
+    }
+
+    for (int i = 0; i < prefix; i++) {
+        ast_free(ast_block_remove(root, index));
+    }
+}
+
+void opt_peval(ASTNode *program, OptContext *ctx) {
+    ASTNode *root = opt_procedure_block(program);
+    if (!root || ctx->options->peval_budget <= 0) return;
+
+    PEState st;
+    st.ctx = ctx;
+    st.env.vars = NULL;
+    st.env.count = 0;
+    st.env.capacity = 0;
+    st.outputs = NULL;
+    st.output_count = 0;
+    st.output_capacity = 0;
+    st.steps = ctx->options->peval_budget;
+
+    PEEnv saved = { NULL, 0, 0 };
+    int prefix = 0;
+
+    while (prefix < root->data.block.count) {
+        env_copy(&saved, &st.env);
+        int outputs_before = st.output_count;
+
+        if (exec_statement(&st, root->data.block.statements[prefix]) != PE_OK) {
+            // Descarta os efeitos parciais do statement
+            env_copy(&st.env, &saved);
+            truncate_outputs(&st, outputs_before);
+            break;
+        }
+        prefix++;
+    }
+
+    if (prefix > 0) {
+        replace_prefix(&st, root, prefix);
+        ctx->changes += prefix;
+    }
+
+    truncate_outputs(&st, 0);
+    free(st.outputs);
+    env_free(&saved);
+    env_free(&st.env);
+}
@@ -0,0 +1,126 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+
+// Otimização guiada por perfil.
+//
+// Os blocos do programa (corpo do procedimento, braços de if e corpos de
+// while) são numerados em pré-ordem logo depois da análise semântica, antes de
+// qualquer passe, então a numeração depende só do código fonte e é a mesma nas
+// compilações com -fprofile-generate e -fprofile-use.
+//
+// -fprofile-generate insere no início de cada bloco um AST_PROFILE_COUNTER,
+// que o gerador de código traduz no incremento de um contador em .data. Os
+// passes copiam o contador junto com o bloco (desenrolamento, por exemplo),
+// então as contagens continuam sendo as do programa fonte. Ao terminar, o
+// programa imprime o perfil:
+//
+//     @prof-blocks <n>
+//     @prof <id> <contagem>
+//
+// -fprofile-use=<arquivo> lê essas linhas (as demais são ignoradas, então a
+// saída inteira do programa pode ser usada) e anota profile_count em cada bloco.
+
+static void number_blocks(ASTNode *node, int *next, int instrument) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_BLOCK: {
+            node->data.block.profile_id = (*next)++;
+            for (int i = 0; i < node->data.block.count; i++) {
+                number_blocks(node->data.block.statements[i], next, instrument);
+            }
+            if (instrument) {
+                ast_block_insert(node, 0, ast_create_profile_counter(node->data.block.profile_id));
+            }
+            break;
+        }
+        case AST_IF_STATEMENT:
+            number_blocks(node->data.if_stmt.then_block, next, instrument);
+            number_blocks(node->data.if_stmt.else_block, next, instrument);
+            break;
+        case AST_WHILE_STATEMENT:
+            number_blocks(node->data.while_stmt.body, next, instrument);
+            break;
+        default:
+            break;
+    }
+}
+
+static void annotate_blocks(ASTNode *node, const long long *counts) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_BLOCK:
+            node->data.block.profile_count = counts[node->data.block.profile_id];
+            for (int i = 0; i < node->data.block.count; i++) {
+                annotate_blocks(node->data.block.statements[i], counts);
+            }
+            break;
+        case AST_IF_STATEMENT:
+            annotate_blocks(node->data.if_stmt.then_block, counts);
+            annotate_blocks(node->data.if_stmt.else_block, counts);
+            break;
+        case AST_WHILE_STATEMENT:
+            annotate_blocks(node->data.while_stmt.body, counts);
+            break;
+        default:
+            break;
+    }
+}
+
+int optimizer_load_profile(OptimizerOptions *options, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open profile file '%s'\n", path);
+        return 0;
+    }
+
+    char line[256];
+    int size = -1;
+    long long *counts = NULL;
+
+    while (fgets(line, sizeof(line), file)) {
+        int id;
+        long long count;
+
+        if (sscanf(line, "@prof-blocks %d", &size) == 1 && size >= 0) {
+            free(counts);
+            counts = (long long*)calloc(size > 0 ? size : 1, sizeof(long long));
+        } else if (counts && sscanf(line, "@prof %d %lld", &id, &count) == 2 &&
+                   id >= 0 && id < size) {
+            counts[id] = count;
+        }
+    }
+    fclose(file);
+
+    if (!counts) {
+        fprintf(stderr, "Error: No profile data in '%s'\n", path);
+        return 0;
+    }
+
+    free(options->profile_counts);
+    options->profile_counts = counts;
+    options->profile_size = size;
+    return 1;
+}
+
+void optimizer_prepare_profile(ASTNode *program, OptimizerOptions *options) {
+    ASTNode *root = opt_procedure_block(program);
+    int next = 0;
+
+    number_blocks(root, &next, options->profile_generate);
+    options->profile_blocks = next;
+
+    if (!options->profile_counts) return;
+
+    if (options->profile_size != next) {
+        fprintf(stderr, "Warning: Profile has %d blocks but the program has %d; ignoring it\n",
+                options->profile_size, next);
+        free(options->profile_counts);
+        options->profile_counts = NULL;
+        options->profile_size = 0;
+        return;
+    }
+    annotate_blocks(root, options->profile_counts);
+}
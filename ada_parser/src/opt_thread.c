@@ -0,0 +1,411 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Threading de condições conhecidas (jump threading no AST).
+//
+// No código estruturado, a aresta que leva ao braço then de "if c" só é
+// percorrida com c verdadeira, a que leva ao else com c falsa, e a saída de
+// "while c" com c falsa (não há saídas no meio do laço). Esses fatos valem até
+// que alguma variável de c seja escrita. Um if cuja condição já é conhecida
+// nesse caminho é trocado pelo braço que executaria, e um while que não
+// entraria é removido; o desvio redundante some do código gerado.
+//
+// Além da condição idêntica, o passe deduz:
+//   - relações entre os mesmos operandos (a < b verdadeira => a >= b falsa,
+//     b > a verdadeira);
+//   - intervalos de uma variável comparada com literais (x > 5 => x > 3);
+//   - operandos de and verdadeiro, or falso e not.
+// Subcondições de and/or conhecidas são simplificadas no lugar.
+
+// Relações como conjuntos de resultados possíveis de comparar l e r
+#define REL_LT 1
+#define REL_EQ 2
+#define REL_GT 4
+
+typedef struct {
+    ASTNode *cond;  // Emprestada do AST (a condição de um if/while ativo)
+    int value;
+} Fact;
+
+typedef struct {
+    Fact *items;
+    int count;
+    int capacity;
+} FactSet;
+
+static void fact_set_init(FactSet *set) {
+    set->items = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+static void fact_set_free(FactSet *set) {
+    free(set->items);
+    fact_set_init(set);
+}
+
+static void fact_set_copy(FactSet *dst, const FactSet *src) {
+    dst->count = 0;
+    for (int i = 0; i < src->count; i++) {
+        if (dst->count >= dst->capacity) {
+            dst->capacity = dst->capacity ? dst->capacity * 2 : 16;
+            dst->items = (Fact*)realloc(dst->items, dst->capacity * sizeof(Fact));
+        }
+        dst->items[dst->count++] = src->items[i];
+    }
+}
+
+static void push_fact(FactSet *set, ASTNode *cond, int value) {
+    // Decompõe o que a condição garante sobre seus operandos
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        push_fact(set, cond->data.unary_op.operand, !value);
+        return;
+    }
+    if (cond->type == AST_BINARY_OP) {
+        const char *op = cond->data.binary_op.operator;
+        if ((opt_op_is(op, "and") && value) || (opt_op_is(op, "or") && !value)) {
+            push_fact(set, cond->data.binary_op.left, value);
+            push_fact(set, cond->data.binary_op.right, value);
+            return;
+        }
+    }
+
+    if (set->count >= set->capacity) {
+        set->capacity = set->capacity ? set->capacity * 2 : 16;
+        set->items = (Fact*)realloc(set->items, set->capacity * sizeof(Fact));
+    }
+    set->items[set->count].cond = cond;
+    set->items[set->count].value = value;
+    set->count++;
+}
+
+// Remove os fatos que dependem de variáveis escritas
+static void kill_facts(FactSet *set, const NameSet *written) {
+    int kept = 0;
+    for (int i = 0; i < set->count; i++) {
+        int killed = 0;
+        for (int n = 0; n < written->count && !killed; n++) {
+            killed = opt_expr_uses(set->items[i].cond, written->names[n]);
+        }
+        if (!killed) {
+            set->items[kept++] = set->items[i];
+        }
+    }
+    set->count = kept;
+}
+
+static void kill_facts_of(FactSet *set, ASTNode *stmt) {
+    NameSet written;
+    name_set_init(&written);
+    opt_collect_assigned(stmt, &written);
+    kill_facts(set, &written);
+    name_set_free(&written);
+}
+
+static int relation_mask(const char *op) {
+    if (strcmp(op, "<") == 0) return REL_LT;
+    if (strcmp(op, "<=") == 0) return REL_LT | REL_EQ;
+    if (strcmp(op, ">") == 0) return REL_GT;
+    if (strcmp(op, ">=") == 0) return REL_GT | REL_EQ;
+    if (strcmp(op, "=") == 0) return REL_EQ;
+    if (strcmp(op, "/=") == 0) return REL_LT | REL_GT;
+    return 0;
+}
+
+// Troca < por > e vice-versa (l REL r == r REL' l)
+static int swap_mask(int mask) {
+    return (mask & REL_EQ) | ((mask & REL_LT) ? REL_GT : 0) | ((mask & REL_GT) ? REL_LT : 0);
+}
+
+// Conhecimento sobre o par (l, r) a partir de fatos com os mesmos operandos
+static int decide_by_operands(const FactSet *facts, ASTNode *cond, int mask) {
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+    int possible = REL_LT | REL_EQ | REL_GT;
+
+    for (int i = 0; i < facts->count; i++) {
+        ASTNode *fact = facts->items[i].cond;
+        if (fact->type != AST_BINARY_OP) continue;
+
+        int fact_mask = relation_mask(fact->data.binary_op.operator);
+        if (!fact_mask) continue;
+        if (!facts->items[i].value) fact_mask ^= REL_LT | REL_EQ | REL_GT;
+
+        if (ast_equal(fact->data.binary_op.left, left) &&
+            ast_equal(fact->data.binary_op.right, right)) {
+            possible &= fact_mask;
+        } else if (ast_equal(fact->data.binary_op.left, right) &&
+                   ast_equal(fact->data.binary_op.right, left)) {
+            possible &= swap_mask(fact_mask);
+        }
+    }
+
+    if ((possible & ~mask) == 0) return 1;
+    if ((possible & mask) == 0) return 0;
+    return -1;
+}
+
+// Forma "x REL c" (com o literal de qualquer lado); devolve a máscara normalizada
+static int match_var_literal(ASTNode *cond, const char **name, long long *value) {
+    int mask = relation_mask(cond->data.binary_op.operator);
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+    if (!mask) return 0;
+
+    if (left->type == AST_IDENTIFIER && right->type == AST_INTEGER) {
+        *name = left->data.identifier.name;
+        *value = right->data.integer.value;
+        return mask;
+    }
+    if (left->type == AST_INTEGER && right->type == AST_IDENTIFIER) {
+        *name = right->data.identifier.name;
+        *value = left->data.integer.value;
+        return swap_mask(mask);
+    }
+    return 0;
+}
+
+// Intervalo [lo, hi] de x deduzido dos fatos "x REL c"
+static int decide_by_interval(const FactSet *facts, ASTNode *cond) {
+    const char *name;
+    long long bound;
+    int mask = match_var_literal(cond, &name, &bound);
+    if (!mask) return -1;
+
+    long long lo = INT32_MIN;
+    long long hi = INT32_MAX;
+
+    for (int i = 0; i < facts->count; i++) {
+        ASTNode *fact = facts->items[i].cond;
+        const char *fact_name;
+        long long c;
+        if (fact->type != AST_BINARY_OP) continue;
+
+        int fact_mask = match_var_literal(fact, &fact_name, &c);
+        if (!fact_mask || strcmp(fact_name, name) != 0) continue;
+        if (!facts->items[i].value) fact_mask ^= REL_LT | REL_EQ | REL_GT;
+
+        switch (fact_mask) {
+            case REL_LT:            if (c - 1 < hi) hi = c - 1; break;
+            case REL_LT | REL_EQ:   if (c < hi) hi = c; break;
+            case REL_GT:            if (c + 1 > lo) lo = c + 1; break;
+            case REL_GT | REL_EQ:   if (c > lo) lo = c; break;
+            case REL_EQ:            if (c > lo) lo = c; if (c < hi) hi = c; break;
+            default: break;         // /= não restringe o intervalo
+        }
+    }
+    if (lo > hi) return -1;     // Caminho impossível: não decide nada
+
+    // Resultados possíveis de comparar x (em [lo, hi]) com o limite
+    int possible = 0;
+    if (lo < bound) possible |= REL_LT;
+    if (lo <= bound && bound <= hi) possible |= REL_EQ;
+    if (hi > bound) possible |= REL_GT;
+
+    if ((possible & ~mask) == 0) return 1;
+    if ((possible & mask) == 0) return 0;
+    return -1;
+}
+
+static int decide_leaf(const FactSet *facts, ASTNode *cond) {
+    if (cond->type == AST_INTEGER) return cond->data.integer.value != 0;
+
+    for (int i = 0; i < facts->count; i++) {
+        if (ast_equal(facts->items[i].cond, cond)) return facts->items[i].value;
+    }
+
+    if (cond->type == AST_BINARY_OP) {
+        int mask = relation_mask(cond->data.binary_op.operator);
+        if (mask) {
+            int known = decide_by_operands(facts, cond, mask);
+            if (known < 0) known = decide_by_interval(facts, cond);
+            return known;
+        }
+    }
+    return -1;
+}
+
+// Valor da condição segundo os fatos (-1 se desconhecido), sem alterá-la
+static int decide(const FactSet *facts, ASTNode *cond) {
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        int inner = decide(facts, cond->data.unary_op.operand);
+        return inner < 0 ? -1 : !inner;
+    }
+
+    if (cond->type == AST_BINARY_OP) {
+        const char *op = cond->data.binary_op.operator;
+        int is_and = opt_op_is(op, "and");
+
+        if (is_and || opt_op_is(op, "or")) {
+            int left = decide(facts, cond->data.binary_op.left);
+            if (left >= 0 && left != is_and) return left;
+
+            int right = decide(facts, cond->data.binary_op.right);
+            if (left >= 0) return right;
+            if (right >= 0 && right != is_and && !opt_expr_may_trap(cond->data.binary_op.left)) {
+                return right;
+            }
+            return -1;
+        }
+    }
+
+    return decide_leaf(facts, cond);
+}
+
+// Simplifica a condição com os fatos; devolve o nó resultante e, em *value,
+// o valor (-1 se desconhecido). Partes descartadas são liberadas.
+static ASTNode* simplify(OptContext *ctx, const FactSet *facts, ASTNode *cond, int *value) {
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        int inner;
+        cond->data.unary_op.operand = simplify(ctx, facts, cond->data.unary_op.operand, &inner);
+        *value = inner < 0 ? -1 : !inner;
+        return cond;
+    }
+
+    if (cond->type == AST_BINARY_OP) {
+        const char *op = cond->data.binary_op.operator;
+        int is_and = opt_op_is(op, "and");
+
+        if (is_and || opt_op_is(op, "or")) {
+            int left, right;
+            cond->data.binary_op.left = simplify(ctx, facts, cond->data.binary_op.left, &left);
+
+            // O operando esquerdo decide sozinho: o direito nem seria avaliado
+            if (left >= 0 && left != is_and) {
+                *value = left;
+                return cond;
+            }
+
+            cond->data.binary_op.right = simplify(ctx, facts, cond->data.binary_op.right, &right);
+
+            // Esquerdo neutro: a condição é o operando direito
+            if (left >= 0) {
+                ASTNode *rest = cond->data.binary_op.right;
+                cond->data.binary_op.right = NULL;
+                ast_free(cond);
+                ctx->changes++;
+                *value = right;
+                return rest;
+            }
+
+            // Direito neutro: a condição é o esquerdo
+            if (right == is_and) {
+                ASTNode *rest = cond->data.binary_op.left;
+                cond->data.binary_op.left = NULL;
+                ast_free(cond);
+                ctx->changes++;
+                *value = -1;
+                return rest;
+            }
+
+            // Direito decide: o esquerdo só importa se puder levantar exceção
+            if (right >= 0 && !opt_expr_may_trap(cond->data.binary_op.left)) {
+                *value = right;
+                return cond;
+            }
+
+            *value = -1;
+            return cond;
+        }
+    }
+
+    *value = decide_leaf(facts, cond);
+    return cond;
+}
+
+static void process_block(OptContext *ctx, ASTNode *block, FactSet *facts);
+
+static void process_if(OptContext *ctx, ASTNode *parent, int index, FactSet *facts, int *advance) {
+    ASTNode *stmt = parent->data.block.statements[index];
+    int value;
+
+    stmt->data.if_stmt.condition = simplify(ctx, facts, stmt->data.if_stmt.condition, &value);
+
+    if (value >= 0) {
+        // O braço escolhido entra no lugar do if e é processado em seguida
+        opt_splice_arm(parent, index, value ? stmt->data.if_stmt.then_block : stmt->data.if_stmt.else_block);
+        ctx->changes++;
+        *advance = 0;
+        return;
+    }
+
+    FactSet arm;
+    fact_set_init(&arm);
+
+    fact_set_copy(&arm, facts);
+    push_fact(&arm, stmt->data.if_stmt.condition, 1);
+    process_block(ctx, stmt->data.if_stmt.then_block, &arm);
+
+    fact_set_copy(&arm, facts);
+    push_fact(&arm, stmt->data.if_stmt.condition, 0);
+    process_block(ctx, stmt->data.if_stmt.else_block, &arm);
+
+    fact_set_free(&arm);
+    kill_facts_of(facts, stmt);
+    *advance = 1;
+}
+
+static void process_while(OptContext *ctx, ASTNode *parent, int index, FactSet *facts, int *advance) {
+    ASTNode *stmt = parent->data.block.statements[index];
+
+    // Na entrada valem os fatos atuais
+    int entry = decide(facts, stmt->data.while_stmt.condition);
+    if (entry == 0) {
+        opt_splice_arm(parent, index, NULL);
+        ctx->changes++;
+        *advance = 0;
+        return;
+    }
+
+    // Nas iterações seguintes, só o que o laço não escreve
+    FactSet body;
+    fact_set_init(&body);
+    fact_set_copy(&body, facts);
+    kill_facts_of(&body, stmt);
+
+    int value;
+    stmt->data.while_stmt.condition = simplify(ctx, &body, stmt->data.while_stmt.condition, &value);
+    push_fact(&body, stmt->data.while_stmt.condition, 1);
+    process_block(ctx, stmt->data.while_stmt.body, &body);
+    fact_set_free(&body);
+
+    // Sem saídas no meio do laço: depois dele a condição é falsa
+    kill_facts_of(facts, stmt);
+    push_fact(facts, stmt->data.while_stmt.condition, 0);
+    *advance = 1;
+}
+
+static void process_block(OptContext *ctx, ASTNode *block, FactSet *facts) {
+    if (!block) return;
+
+    int i = 0;
+    while (i < block->data.block.count) {
+        ASTNode *stmt = block->data.block.statements[i];
+        int advance = 1;
+
+        switch (stmt->type) {
+            case AST_IF_STATEMENT:
+                process_if(ctx, block, i, facts, &advance);
+                break;
+            case AST_WHILE_STATEMENT:
+                process_while(ctx, block, i, facts, &advance);
+                break;
+            case AST_BLOCK:
+                process_block(ctx, stmt, facts);
+                break;
+            default:
+                kill_facts_of(facts, stmt);
+                break;
+        }
+        if (advance) i++;
+    }
+}
+
+void opt_thread(ASTNode *program, OptContext *ctx) {
+    FactSet facts;
+    fact_set_init(&facts);
+    process_block(ctx, opt_procedure_block(program), &facts);
+    fact_set_free(&facts);
+}
@@ -0,0 +1,208 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+
+// Desenrolamento de laços.
+//
+// Um while cuja condição é "i REL N" (N literal), em que i só é escrita por
+// um incremento "i := i + c" do nível do corpo, avança de forma previsível.
+// Se o valor inicial de i também é constante, o número de iterações é
+// conhecido e laços pequenos são substituídos por cópias do corpo.
+//
+// Os demais são desenrolados parcialmente por options->unroll_factor (F):
+//
+//     while i REL N - (F-1)*c loop    -- só entra se restam F iterações
+//        corpo; corpo; ... corpo;     -- F cópias
+//     end loop;
+//     while i REL N loop              -- resto (0 a F-1 iterações)
+//        corpo;
+//     end loop;
+//
+// Cada cópia executa exatamente os statements de uma iteração original, então
+// o programa roda a mesma sequência de atribuições; só os testes e os saltos
+// de volta que separavam as iterações somem.
+//
+// Com um perfil (-fprofile-use), laços que nunca executaram não são
+// desenrolados parcialmente, laços que rodam menos de 2F iterações por entrada não ganham
+// laço principal e laços quentes usam os limites de -O2.
+
+// Limites de tamanho (em nós do AST) por nível de otimização
+#define FULL_MAX_TRIPS_O1    8
+#define FULL_MAX_NODES_O1    64
+#define FULL_MAX_TRIPS_O2    32
+#define FULL_MAX_NODES_O2    256
+#define PARTIAL_MAX_NODES_O1 128
+#define PARTIAL_MAX_NODES_O2 256
+
+// Execuções do corpo a partir das quais o laço é considerado quente
+#define PROFILE_HOT_COUNT    1000
+
+typedef struct {
+    const char *iv;         // Variável de controle
+    ASTNode *increment;
+    long long step;         // c
+    const char *rel;        // Relação normalizada "i REL N"
+    long long bound;        // N
+    long long trips;        // Número de iterações (-1 se desconhecido)
+} LoopShape;
+
+// Iterações de "i := init; while i REL N loop ... i := i + c" (-1 se o
+// incremento estouraria, caso em que o programa original levanta exceção)
+static long long trip_count(long long init, long long step, const char *rel, long long bound) {
+    long long distance;
+    long long magnitude = step < 0 ? -step : step;
+
+    if (strcmp(rel, "<") == 0) distance = bound - init;
+    else if (strcmp(rel, "<=") == 0) distance = bound - init + 1;
+    else if (strcmp(rel, ">") == 0) distance = init - bound;
+    else distance = init - bound + 1;
+
+    long long trips = distance > 0 ? (distance + magnitude - 1) / magnitude : 0;
+    if (!opt_fits_int32(init + trips * step)) return -1;
+    return trips;
+}
+
+// Reconhece a forma do laço; trips fica -1 se o valor inicial é desconhecido
+static int analyze_loop(ASTNode *parent, ASTNode *loop, LoopShape *shape) {
+    ASTNode *cond = loop->data.while_stmt.condition;
+    if (cond->type != AST_BINARY_OP) return 0;
+
+    ASTNode *side = cond->data.binary_op.left;
+    if (side->type != AST_IDENTIFIER) side = cond->data.binary_op.right;
+    if (side->type != AST_IDENTIFIER) return 0;
+
+    shape->iv = side->data.identifier.name;
+    if (!opt_match_bound_test(cond, shape->iv, &shape->rel, &shape->bound)) return 0;
+    if (opt_count_writes(loop, shape->iv) != 1) return 0;
+
+    ASTNode *body = loop->data.while_stmt.body;
+    shape->increment = NULL;
+    for (int i = 0; i < body->data.block.count; i++) {
+        ASTNode *stmt = body->data.block.statements[i];
+        if (stmt->type == AST_ASSIGNMENT &&
+            strcmp(stmt->data.assignment.identifier, shape->iv) == 0) {
+            shape->increment = stmt;
+        }
+    }
+    if (!shape->increment || !opt_match_increment(shape->increment, &shape->step)) return 0;
+
+    // O incremento precisa aproximar i do limite
+    int upward = strcmp(shape->rel, "<") == 0 || strcmp(shape->rel, "<=") == 0;
+    if ((shape->step > 0) != upward) return 0;
+
+    shape->trips = -1;
+    ASTNode *init = opt_reaching_constant(parent, loop, shape->iv);
+    if (init) {
+        shape->trips = trip_count(init->data.assignment.expression->data.integer.value,
+                                  shape->step, shape->rel, shape->bound);
+        if (shape->trips < 0) return 0;
+    }
+    return 1;
+}
+
+// Bloco com 'copies' cópias dos statements do corpo
+static ASTNode* replicate_body(ASTNode *body, int copies) {
+    int count = body->data.block.count;
+    ASTNode **statements = (ASTNode**)malloc((count * copies > 0 ? count * copies : 1) * sizeof(ASTNode*));
+
+    for (int c = 0; c < copies; c++) {
+        for (int i = 0; i < count; i++) {
+            statements[c * count + i] = ast_clone(body->data.block.statements[i]);
+        }
+    }
+    return ast_create_block(statements, count * copies);
+}
+
+static void unroll_fully(ASTNode *parent, ASTNode *loop, int trips) {
+    int index = ast_block_index_of(parent, loop);
+    ASTNode *copies = replicate_body(loop->data.while_stmt.body, trips);
+
+    ast_block_remove(parent, index);
+    for (int i = 0; i < copies->data.block.count; i++) {
+        ast_block_insert(parent, index + i, copies->data.block.statements[i]);
+    }
+
+    copies->data.block.count = 0;
+    ast_free(copies);
+    ast_free(loop);
+}
+
+// Cria o laço principal com F cópias; o original vira o laço de resto
+static int unroll_partially(ASTNode *parent, ASTNode *loop, const LoopShape *shape, int factor) {
+    long long guard = shape->bound - (long long)(factor - 1) * shape->step;
+    if (!opt_fits_int32(guard)) return 0;
+
+    ASTNode *cond = ast_create_binary_op(shape->rel, ast_create_identifier(shape->iv),
+                                         ast_create_integer((int)guard));
+    ASTNode *body = replicate_body(loop->data.while_stmt.body, factor);
+    long long count = loop->data.while_stmt.body->data.block.profile_count;
+    if (count >= 0) {
+        body->data.block.profile_count = count / factor;
+    }
+    ASTNode *main_loop = ast_create_while(cond, body);
+    ast_block_insert(parent, ast_block_index_of(parent, loop), main_loop);
+
+    // Número de iterações múltiplo de F: o resto nunca executa
+    if (shape->trips >= 0 && shape->trips % factor == 0) {
+        ast_free(ast_block_remove(parent, ast_block_index_of(parent, loop)));
+    }
+    return 1;
+}
+
+static void process_block(OptContext *ctx, ASTNode *block);
+
+static void process_loop(OptContext *ctx, ASTNode *parent, ASTNode *loop) {
+    // Laços internos primeiro: o tamanho do corpo já reflete o desenrolamento deles
+    process_block(ctx, loop->data.while_stmt.body);
+
+    LoopShape shape;
+    if (!analyze_loop(parent, loop, &shape)) return;
+
+    // Perfil: contagens do corpo e do bloco que contém o laço (-1 sem perfil)
+    long long body_count = loop->data.while_stmt.body->data.block.profile_count;
+    long long entry_count = parent->data.block.profile_count;
+
+    int aggressive = ctx->options->level >= 2 || body_count >= PROFILE_HOT_COUNT;
+    long long max_trips = aggressive ? FULL_MAX_TRIPS_O2 : FULL_MAX_TRIPS_O1;
+    long long max_full = aggressive ? FULL_MAX_NODES_O2 : FULL_MAX_NODES_O1;
+    long long max_partial = aggressive ? PARTIAL_MAX_NODES_O2 : PARTIAL_MAX_NODES_O1;
+    long long size = opt_node_count(loop->data.while_stmt.body);
+    int factor = ctx->options->unroll_factor;
+
+    if (shape.trips >= 0 && shape.trips <= max_trips && shape.trips * size <= max_full) {
+        unroll_fully(parent, loop, (int)shape.trips);
+        ctx->changes++;
+        return;
+    }
+
+    // Só compensa se o laço principal roda ao menos duas vezes
+    if (factor < 2 || size * factor > max_partial || body_count == 0) return;
+    if (shape.trips >= 0 && shape.trips < 2LL * factor) return;
+    if (body_count >= 0 && entry_count > 0 && body_count < 2LL * factor * entry_count) return;
+
+    if (unroll_partially(parent, loop, &shape, factor)) {
+        ctx->changes++;
+    }
+}
+
+static void process_block(OptContext *ctx, ASTNode *block) {
+    if (!block) return;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+
+        if (stmt->type == AST_WHILE_STATEMENT) {
+            // O laço pode ser substituído ou ganhar um laço principal antes dele
+            int before = block->data.block.count;
+            process_loop(ctx, block, stmt);
+            i += block->data.block.count - before;
+        } else if (stmt->type == AST_IF_STATEMENT) {
+            process_block(ctx, stmt->data.if_stmt.then_block);
+            process_block(ctx, stmt->data.if_stmt.else_block);
+        }
+    }
+}
+
+void opt_unroll(ASTNode *program, OptContext *ctx) {
+    process_block(ctx, opt_procedure_block(program));
+}
@@ -0,0 +1,594 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Propagação de intervalos (value range propagation).
+//
+// Cada variável Integer tem um intervalo [lo, hi] em cada ponto do programa,
+// semeado por constantes, pelas condições de if/while (o braço then de
+// "x < 10" vê x <= 9, a saída de "while i < n" vê i >= n) e pelo ponto fixo
+// dos laços, com widening para garantir término e um passo de narrowing para
+// recuperar o limite dado pela condição.
+//
+// Depois do ponto fixo o passe reescreve o AST:
+//   - comparações de resultado conhecido viram literais, e if/while de
+//     condição conhecida são trocados pelo braço que executaria;
+//   - expressões de valor único (sem risco de exceção) viram literais, o que
+//     dá ao gerador operandos imediatos;
+//   - identificadores e operações binárias recebem o intervalo (ValueRange),
+//     visível no dump do AST; o gerador usa o de dividendos não negativos
+//     para dividir por constante sem a correção de sinal.
+//
+// + e - verificados levantam exceção em overflow, então depois deles o valor
+// está no intervalo de 32 bits; + e - unchecked e * dão a volta. Os + e -
+// que comprovadamente não transbordam são marcados unchecked: o gerador usa
+// addu/subu e pode calculá-los especulativamente (conversão de if).
+
+// Iterações do ponto fixo antes do widening e limite de segurança
+#define VRP_WIDEN_AFTER   2
+#define VRP_MAX_ITERATIONS 32
+#define VRP_NARROWING     2
+
+typedef struct {
+    long long lo;
+    long long hi;
+} Interval;
+
+typedef struct {
+    char *name;
+    Interval range;
+} RangeVar;
+
+// Intervalos das variáveis; ausentes valem o intervalo inteiro
+typedef struct {
+    RangeVar *vars;
+    int count;
+    int capacity;
+    int reachable;  // 0 em caminhos impossíveis (condição contraditória)
+} RangeEnv;
+
+static const Interval full_range = { INT32_MIN, INT32_MAX };
+
+static int is_full(Interval r) {
+    return r.lo <= INT32_MIN && r.hi >= INT32_MAX;
+}
+
+static Interval make_interval(long long lo, long long hi) {
+    Interval r = { lo, hi };
+    return r;
+}
+
+static void env_init(RangeEnv *env) {
+    env->vars = NULL;
+    env->count = 0;
+    env->capacity = 0;
+    env->reachable = 1;
+}
+
+static void env_clear(RangeEnv *env) {
+    for (int i = 0; i < env->count; i++) {
+        free(env->vars[i].name);
+    }
+    env->count = 0;
+}
+
+static void env_free(RangeEnv *env) {
+    env_clear(env);
+    free(env->vars);
+    env_init(env);
+}
+
+static RangeVar* env_find(const RangeEnv *env, const char *name) {
+    for (int i = 0; i < env->count; i++) {
+        if (strcmp(env->vars[i].name, name) == 0) return &env->vars[i];
+    }
+    return NULL;
+}
+
+static Interval env_get(const RangeEnv *env, const char *name) {
+    RangeVar *var = env_find(env, name);
+    return var ? var->range : full_range;
+}
+
+static void env_set(RangeEnv *env, const char *name, Interval range) {
+    RangeVar *var = env_find(env, name);
+
+    if (is_full(range)) {
+        // Intervalo inteiro: a variável sai do ambiente
+        if (var) {
+            free(var->name);
+            *var = env->vars[--env->count];
+        }
+        return;
+    }
+    if (var) {
+        var->range = range;
+        return;
+    }
+
+    if (env->count >= env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 16;
+        env->vars = (RangeVar*)realloc(env->vars, env->capacity * sizeof(RangeVar));
+    }
+    env->vars[env->count].name = strdup(name);
+    env->vars[env->count].range = range;
+    env->count++;
+}
+
+static void env_copy(RangeEnv *dst, const RangeEnv *src) {
+    env_clear(dst);
+    dst->reachable = src->reachable;
+    for (int i = 0; i < src->count; i++) {
+        env_set(dst, src->vars[i].name, src->vars[i].range);
+    }
+}
+
+// dst := dst ∪ src (envoltória dos intervalos)
+static void env_join(RangeEnv *dst, const RangeEnv *src) {
+    if (!src->reachable) return;
+    if (!dst->reachable) {
+        env_copy(dst, src);
+        return;
+    }
+
+    int i = 0;
+    while (i < dst->count) {
+        RangeVar *var = &dst->vars[i];
+        Interval other = env_get(src, var->name);
+        Interval joined = make_interval(var->range.lo < other.lo ? var->range.lo : other.lo,
+                                        var->range.hi > other.hi ? var->range.hi : other.hi);
+        int before = dst->count;
+        env_set(dst, var->name, joined);
+        if (dst->count == before) i++;  // Removida: a posição recebeu outra variável
+    }
+}
+
+// Todo estado descrito por 'inner' também é descrito por 'outer'?
+static int env_includes(const RangeEnv *outer, const RangeEnv *inner) {
+    if (!inner->reachable) return 1;
+    if (!outer->reachable) return 0;
+    for (int i = 0; i < outer->count; i++) {
+        Interval limit = outer->vars[i].range;
+        Interval value = env_get(inner, outer->vars[i].name);
+        if (value.lo < limit.lo || value.hi > limit.hi) return 0;
+    }
+    return 1;
+}
+
+// Widening: limites que ainda crescem vão direto ao extremo de 32 bits
+static void env_widen(RangeEnv *old, const RangeEnv *next) {
+    if (!old->reachable) {
+        env_copy(old, next);
+        return;
+    }
+
+    int i = 0;
+    while (i < old->count) {
+        RangeVar *var = &old->vars[i];
+        Interval grown = env_get(next, var->name);
+        Interval widened = var->range;
+        if (grown.lo < widened.lo) widened.lo = INT32_MIN;
+        if (grown.hi > widened.hi) widened.hi = INT32_MAX;
+        int before = old->count;
+        env_set(old, var->name, widened);
+        if (old->count == before) i++;
+    }
+}
+
+typedef struct {
+    OptContext *ctx;
+} VRPState;
+
+static Interval clamp32(Interval r) {
+    if (r.lo < INT32_MIN) r.lo = INT32_MIN;
+    if (r.hi > INT32_MAX) r.hi = INT32_MAX;
+    if (r.lo > r.hi) return full_range;     // Sempre levanta exceção
+    return r;
+}
+
+static Interval hull4(long long a, long long b, long long c, long long d) {
+    Interval r = { a, a };
+    long long v[3] = { b, c, d };
+    for (int i = 0; i < 3; i++) {
+        if (v[i] < r.lo) r.lo = v[i];
+        if (v[i] > r.hi) r.hi = v[i];
+    }
+    return r;
+}
+
+// Quociente de l por divisores em [dlo, dhi], todos de mesmo sinal e não nulos
+static Interval divide_same_sign(Interval l, long long dlo, long long dhi) {
+    return hull4(l.lo / dlo, l.lo / dhi, l.hi / dlo, l.hi / dhi);
+}
+
+static Interval eval_binary(const char *op, int unchecked, Interval l, Interval r, int *may_trap) {
+    if (strcmp(op, "+") == 0 || strcmp(op, "-") == 0) {
+        int add = strcmp(op, "+") == 0;
+        Interval sum = add ? make_interval(l.lo + r.lo, l.hi + r.hi)
+                           : make_interval(l.lo - r.hi, l.hi - r.lo);
+        if (sum.lo >= INT32_MIN && sum.hi <= INT32_MAX) return sum;
+        if (unchecked) return full_range;
+        *may_trap = 1;
+        return clamp32(sum);
+    }
+
+    if (strcmp(op, "*") == 0) {
+        Interval product = hull4(l.lo * r.lo, l.lo * r.hi, l.hi * r.lo, l.hi * r.hi);
+        if (product.lo >= INT32_MIN && product.hi <= INT32_MAX) return product;
+        return full_range;
+    }
+
+    if (strcmp(op, "/") == 0) {
+        Interval result = { 0, 0 };
+        int any = 0;
+
+        if (r.lo <= 0 && r.hi >= 0) *may_trap = 1;
+        if (l.lo <= INT32_MIN && r.lo <= -1 && r.hi >= -1) *may_trap = 1;
+
+        if (r.lo <= -1) {
+            result = divide_same_sign(l, r.lo, r.hi < -1 ? r.hi : -1);
+            any = 1;
+        }
+        if (r.hi >= 1) {
+            Interval pos = divide_same_sign(l, r.lo > 1 ? r.lo : 1, r.hi);
+            if (any) {
+                if (pos.lo < result.lo) result.lo = pos.lo;
+                if (pos.hi > result.hi) result.hi = pos.hi;
+            } else {
+                result = pos;
+            }
+            any = 1;
+        }
+        if (!any) return full_range;
+        return clamp32(result);
+    }
+
+    // Relações: 1 se sempre verdadeira, 0 se sempre falsa
+    int always = -1;
+    if (strcmp(op, "<") == 0) {
+        if (l.hi < r.lo) always = 1; else if (l.lo >= r.hi) always = 0;
+    } else if (strcmp(op, "<=") == 0) {
+        if (l.hi <= r.lo) always = 1; else if (l.lo > r.hi) always = 0;
+    } else if (strcmp(op, ">") == 0) {
+        if (l.lo > r.hi) always = 1; else if (l.hi <= r.lo) always = 0;
+    } else if (strcmp(op, ">=") == 0) {
+        if (l.lo >= r.hi) always = 1; else if (l.hi < r.lo) always = 0;
+    } else if (strcmp(op, "=") == 0) {
+        if (l.lo == l.hi && r.lo == r.hi && l.lo == r.lo) always = 1;
+        else if (l.hi < r.lo || l.lo > r.hi) always = 0;
+    } else if (strcmp(op, "/=") == 0) {
+        if (l.hi < r.lo || l.lo > r.hi) always = 1;
+        else if (l.lo == l.hi && r.lo == r.hi && l.lo == r.lo) always = 0;
+    } else {
+        return full_range;
+    }
+    return always < 0 ? make_interval(0, 1) : make_interval(always, always);
+}
+
+static void annotate(ASTNode *node, Interval r) {
+    ValueRange *range = ast_range(node);
+    if (!range) return;
+    range->known = !is_full(r);
+    range->lo = (int)r.lo;
+    range->hi = (int)r.hi;
+}
+
+// Intervalo da expressão em *slot. Com rewrite, anota os nós e troca por
+// literais as expressões de valor único que não podem levantar exceção.
+static Interval eval_expr(VRPState *st, ASTNode **slot, const RangeEnv *env, int rewrite, int *may_trap) {
+    ASTNode *expr = *slot;
+    Interval result = full_range;
+    int trap = 0;
+
+    switch (expr->type) {
+        case AST_INTEGER:
+            return make_interval(expr->data.integer.value, expr->data.integer.value);
+
+        case AST_IDENTIFIER:
+            result = env_get(env, expr->data.identifier.name);
+            break;
+
+        case AST_UNARY_OP: {
+            Interval operand = eval_expr(st, &expr->data.unary_op.operand, env, rewrite, &trap);
+            if (opt_op_is(expr->data.unary_op.operator, "not")) {
+                result = operand.lo == operand.hi && (operand.lo == 0 || operand.lo == 1)
+                         ? make_interval(!operand.lo, !operand.lo) : make_interval(0, 1);
+            } else if (strcmp(expr->data.unary_op.operator, "-") == 0) {
+                if (operand.lo <= INT32_MIN) trap = 1;
+                result = clamp32(make_interval(-operand.hi, -operand.lo));
+            }
+            break;
+        }
+
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            Interval left = eval_expr(st, &expr->data.binary_op.left, env, rewrite, &trap);
+            Interval right = eval_expr(st, &expr->data.binary_op.right, env, rewrite, &trap);
+
+            if (opt_op_is(op, "and") || opt_op_is(op, "or")) {
+                int is_and = opt_op_is(op, "and");
+                if (left.lo == left.hi && (left.lo != 0) != is_and) {
+                    result = make_interval(left.lo != 0, left.lo != 0);
+                } else if (left.lo == left.hi && right.lo == right.hi) {
+                    int value = is_and ? (left.lo && right.lo) : (left.lo || right.lo);
+                    result = make_interval(value, value);
+                } else {
+                    result = make_interval(0, 1);
+                }
+            } else {
+                int op_trap = 0;
+                result = eval_binary(op, expr->data.binary_op.unchecked, left, right, &op_trap);
+                if (op_trap) {
+                    trap = 1;
+                } else if (rewrite && !expr->data.binary_op.unchecked &&
+                           (strcmp(op, "+") == 0 || strcmp(op, "-") == 0)) {
+                    // A verificação de overflow nunca dispara
+                    expr->data.binary_op.unchecked = 1;
+                    st->ctx->changes++;
+                }
+            }
+            break;
+        }
+
+        default:
+            // Strings não têm intervalo
+            return full_range;
+    }
+
+    if (trap) *may_trap = 1;
+    if (!rewrite) return result;
+
+    if (result.lo == result.hi && !trap) {
+        ast_free(expr);
+        *slot = ast_create_integer((int)result.lo);
+        st->ctx->changes++;
+    } else {
+        annotate(expr, result);
+    }
+    return result;
+}
+
+// Restringe o intervalo de x sabendo que "x REL r"
+static Interval restrict_by(Interval x, const char *rel, Interval r) {
+    if (strcmp(rel, "<") == 0) {
+        if (r.hi - 1 < x.hi) x.hi = r.hi - 1;
+    } else if (strcmp(rel, "<=") == 0) {
+        if (r.hi < x.hi) x.hi = r.hi;
+    } else if (strcmp(rel, ">") == 0) {
+        if (r.lo + 1 > x.lo) x.lo = r.lo + 1;
+    } else if (strcmp(rel, ">=") == 0) {
+        if (r.lo > x.lo) x.lo = r.lo;
+    } else if (strcmp(rel, "=") == 0) {
+        if (r.lo > x.lo) x.lo = r.lo;
+        if (r.hi < x.hi) x.hi = r.hi;
+    } else if (strcmp(rel, "/=") == 0 && r.lo == r.hi) {
+        if (x.lo == r.lo) x.lo++;
+        else if (x.hi == r.lo) x.hi--;
+    }
+    return x;
+}
+
+static void restrict_var(VRPState *st, RangeEnv *env, ASTNode *side, const char *rel, ASTNode *other) {
+    if (side->type != AST_IDENTIFIER) return;
+
+    int trap = 0;
+    Interval r = eval_expr(st, &other, env, 0, &trap);
+    Interval x = restrict_by(env_get(env, side->data.identifier.name), rel, r);
+
+    if (x.lo > x.hi) {
+        env->reachable = 0;
+    } else {
+        env_set(env, side->data.identifier.name, x);
+    }
+}
+
+// Refina o ambiente com "cond == truth"
+static void refine(VRPState *st, RangeEnv *env, ASTNode *cond, int truth) {
+    if (!env->reachable) return;
+
+    if (cond->type == AST_INTEGER) {
+        if ((cond->data.integer.value != 0) != truth) env->reachable = 0;
+        return;
+    }
+
+    if (cond->type == AST_UNARY_OP && opt_op_is(cond->data.unary_op.operator, "not")) {
+        refine(st, env, cond->data.unary_op.operand, !truth);
+        return;
+    }
+
+    if (cond->type != AST_BINARY_OP) return;
+
+    const char *op = cond->data.binary_op.operator;
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+    int is_and = opt_op_is(op, "and");
+
+    if (is_and || opt_op_is(op, "or")) {
+        if (truth == is_and) {
+            // Os dois operandos valem 'truth'
+            refine(st, env, left, truth);
+            refine(st, env, right, truth);
+        } else {
+            // O esquerdo decide, ou o esquerdo não decide e o direito decide
+            RangeEnv other;
+            env_init(&other);
+            env_copy(&other, env);
+            refine(st, env, left, truth);
+            refine(st, &other, left, !truth);
+            refine(st, &other, right, truth);
+            env_join(env, &other);
+            env_free(&other);
+        }
+        return;
+    }
+
+    const char *rel = NULL;
+    if (strcmp(op, "<") == 0) rel = truth ? "<" : ">=";
+    else if (strcmp(op, "<=") == 0) rel = truth ? "<=" : ">";
+    else if (strcmp(op, ">") == 0) rel = truth ? ">" : "<=";
+    else if (strcmp(op, ">=") == 0) rel = truth ? ">=" : "<";
+    else if (strcmp(op, "=") == 0) rel = truth ? "=" : "/=";
+    else if (strcmp(op, "/=") == 0) rel = truth ? "/=" : "=";
+    if (!rel) return;
+
+    // = e /= são simétricas; as demais trocam de sentido com os operandos
+    const char *flipped = opt_flip_relation(rel);
+    restrict_var(st, env, left, rel, right);
+    if (env->reachable) {
+        restrict_var(st, env, right, flipped ? flipped : rel, left);
+    }
+}
+
+static void analyze_block(VRPState *st, ASTNode *block, RangeEnv *env, int rewrite);
+
+static void analyze_if(VRPState *st, ASTNode *parent, int index, RangeEnv *env, int rewrite, int *advance) {
+    ASTNode *stmt = parent->data.block.statements[index];
+    int trap = 0;
+    Interval cond = eval_expr(st, &stmt->data.if_stmt.condition, env, rewrite, &trap);
+
+    if (cond.lo == cond.hi) {
+        ASTNode *arm = cond.lo ? stmt->data.if_stmt.then_block : stmt->data.if_stmt.else_block;
+        if (rewrite && stmt->data.if_stmt.condition->type == AST_INTEGER) {
+            // O braço escolhido entra no lugar do if e é analisado em seguida
+            opt_splice_arm(parent, index, arm);
+            st->ctx->changes++;
+            *advance = 0;
+            return;
+        }
+        analyze_block(st, arm, env, rewrite);
+        return;
+    }
+
+    RangeEnv other;
+    env_init(&other);
+    env_copy(&other, env);
+
+    refine(st, env, stmt->data.if_stmt.condition, 1);
+    if (env->reachable) analyze_block(st, stmt->data.if_stmt.then_block, env, rewrite);
+
+    refine(st, &other, stmt->data.if_stmt.condition, 0);
+    if (other.reachable) analyze_block(st, stmt->data.if_stmt.else_block, &other, rewrite);
+
+    env_join(env, &other);
+    env_free(&other);
+}
+
+// Estado no fim de uma iteração partindo de 'head'
+static void iterate(VRPState *st, ASTNode *loop, const RangeEnv *head, RangeEnv *out, int rewrite) {
+    env_copy(out, head);
+    refine(st, out, loop->data.while_stmt.condition, 1);
+    if (out->reachable) analyze_block(st, loop->data.while_stmt.body, out, rewrite);
+}
+
+static void analyze_while(VRPState *st, ASTNode *parent, int index, RangeEnv *env, int rewrite, int *advance) {
+    ASTNode *loop = parent->data.block.statements[index];
+    RangeEnv head, next;
+    env_init(&head);
+    env_init(&next);
+
+    // Ponto fixo do cabeçalho: entrada ∪ fim do corpo
+    env_copy(&head, env);
+    int converged = 0;
+    for (int k = 0; k < VRP_MAX_ITERATIONS && !converged; k++) {
+        iterate(st, loop, &head, &next, 0);
+        env_join(&next, env);
+        if (env_includes(&head, &next)) {
+            converged = 1;
+        } else if (k >= VRP_WIDEN_AFTER) {
+            env_widen(&head, &next);
+        } else {
+            env_copy(&head, &next);
+        }
+    }
+
+    if (!converged) {
+        // Sem convergência: o que o laço escreve fica desconhecido
+        NameSet written;
+        name_set_init(&written);
+        opt_collect_assigned(loop, &written);
+        env_copy(&head, env);
+        for (int i = 0; i < written.count; i++) {
+            env_set(&head, written.names[i], full_range);
+        }
+        name_set_free(&written);
+    } else {
+        // Narrowing: recupera os limites impostos pela condição
+        for (int k = 0; k < VRP_NARROWING; k++) {
+            iterate(st, loop, &head, &next, 0);
+            env_join(&next, env);
+            env_copy(&head, &next);
+        }
+    }
+
+    int trap = 0;
+    Interval cond = eval_expr(st, &loop->data.while_stmt.condition, &head, rewrite, &trap);
+
+    if (rewrite && cond.lo == 0 && cond.hi == 0 &&
+        loop->data.while_stmt.condition->type == AST_INTEGER) {
+        // Nunca entra
+        opt_splice_arm(parent, index, NULL);
+        st->ctx->changes++;
+        *advance = 0;
+    } else {
+        if (rewrite) {
+            iterate(st, loop, &head, &next, 1);
+        }
+        env_copy(env, &head);
+        refine(st, env, loop->data.while_stmt.condition, 0);
+    }
+
+    env_free(&head);
+    env_free(&next);
+}
+
+static void analyze_block(VRPState *st, ASTNode *block, RangeEnv *env, int rewrite) {
+    if (!block) return;
+
+    int i = 0;
+    while (i < block->data.block.count && env->reachable) {
+        ASTNode *stmt = block->data.block.statements[i];
+        int advance = 1;
+        int trap = 0;
+
+        switch (stmt->type) {
+            case AST_ASSIGNMENT: {
+                Interval value = eval_expr(st, &stmt->data.assignment.expression, env, rewrite, &trap);
+                env_set(env, stmt->data.assignment.identifier, value);
+                break;
+            }
+            case AST_GET_LINE:
+                env_set(env, stmt->data.get_line.identifier, full_range);
+                break;
+            case AST_PUT_LINE: {
+                // Put_Line de unário não imprime nada: ele não pode virar literal
+                ASTNode **slot = &stmt->data.put_line.expression;
+                if ((*slot)->type == AST_UNARY_OP) slot = &(*slot)->data.unary_op.operand;
+                eval_expr(st, slot, env, rewrite, &trap);
+                break;
+            }
+            case AST_IF_STATEMENT:
+                analyze_if(st, block, i, env, rewrite, &advance);
+                break;
+            case AST_WHILE_STATEMENT:
+                analyze_while(st, block, i, env, rewrite, &advance);
+                break;
+            case AST_BLOCK:
+                analyze_block(st, stmt, env, rewrite);
+                break;
+            default:
+                break;
+        }
+        if (advance) i++;
+    }
+}
+
+void opt_vrp(ASTNode *program, OptContext *ctx) {
+    VRPState st;
+    st.ctx = ctx;
+
+    RangeEnv env;
+    env_init(&env);
+    analyze_block(&st, opt_procedure_block(program), &env, 1);
+    env_free(&env);
+}
@@ -0,0 +1,482 @@
+#define _GNU_SOURCE
+#include "optimizer.h"
+#include <stdio.h>
+#include <strings.h>
+#include <stdint.h>
+
+// Pipeline padrão, na ordem de execução
+static const OptPass passes[] = {
+    { "peval", opt_peval, 1 },
+    { "thread", opt_thread, 1 },
+    { "algebra", opt_algebra, 1 },
+    { "gvn", opt_gvn, 1 },
+    { "licm", opt_licm, 1 },
+    { "iv", opt_iv, 1 },
+    { "unroll", opt_unroll, 1 },
+    { "vrp", opt_vrp, 1 },
+};
+
+void optimizer_options_init(OptimizerOptions *options) {
+    options->level = 1;
+    options->unroll_factor = 4;
+    options->peval_budget = 0;
+    options->profile_generate = 0;
+    options->profile_counts = NULL;
+    options->profile_size = 0;
+    options->profile_blocks = 0;
+    options->superopt_cache = NULL;
+    options->delayed_branch = 0;
+}
+
+void optimizer_options_free(OptimizerOptions *options) {
+    free(options->profile_counts);
+    options->profile_counts = NULL;
+}
+
+void optimizer_run(ASTNode *program, SymbolTable *table, const OptimizerOptions *options) {
+    OptContext ctx;
+    ctx.symbol_table = table;
+    ctx.options = options;
+    ctx.temp_counter = 0;
+
+    for (size_t i = 0; i < sizeof(passes) / sizeof(passes[0]); i++) {
+        if (options->level < passes[i].min_level) continue;
+
+        ctx.changes = 0;
+        passes[i].run(program, &ctx);
+        printf("  %-10s %d change(s)\n", passes[i].name, ctx.changes);
+    }
+}
+
+// Pipeline padrão (usado pelo ada_opt para listar e escolher passes)
+const OptPass* optimizer_passes(int *count) {
+    *count = (int)(sizeof(passes) / sizeof(passes[0]));
+    return passes;
+}
+
+const OptPass* optimizer_find_pass(const char *name) {
+    for (size_t i = 0; i < sizeof(passes) / sizeof(passes[0]); i++) {
+        if (strcmp(passes[i].name, name) == 0) return &passes[i];
+    }
+    return NULL;
+}
+
+ASTNode* opt_procedure_block(ASTNode *program) {
+    if (program && program->type == AST_PROGRAM) {
+        program = program->data.program.procedure;
+    }
+    if (program && program->type == AST_PROCEDURE) {
+        return program->data.procedure.block;
+    }
+    return NULL;
+}
+
+// Cria uma variável temporária no escopo do procedimento.
+// O '.' no nome garante que não colide com identificadores Ada.
+const char* opt_new_temp(OptContext *ctx, const char *prefix, SymbolType type) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s.%d", prefix, ctx->temp_counter++);
+    symbol_table_insert(ctx->symbol_table, name, type);
+    return symbol_table_lookup_local(ctx->symbol_table, name)->name;
+}
+
+// Transforma o nó (no lugar) em uma referência à variável
+void opt_make_identifier(ASTNode *node, const char *name) {
+    switch (node->type) {
+        case AST_BINARY_OP:
+            free(node->data.binary_op.operator);
+            ast_free(node->data.binary_op.left);
+            ast_free(node->data.binary_op.right);
+            break;
+        case AST_UNARY_OP:
+            free(node->data.unary_op.operator);
+            ast_free(node->data.unary_op.operand);
+            break;
+        case AST_STRING:
+            free(node->data.string.value);
+            break;
+        case AST_IDENTIFIER:
+            free(node->data.identifier.name);
+            break;
+        default:
+            break;
+    }
+    node->type = AST_IDENTIFIER;
+    node->data.identifier.name = strdup(name);
+    node->data.identifier.range.known = 0;
+}
+
+// O parser gera "AND"/"OR"/"NOT" em maiúsculas; a comparação ignora a caixa
+int opt_op_is(const char *op, const char *name) {
+    return strcasecmp(op, name) == 0;
+}
+
+int opt_is_commutative(const char *op) {
+    return opt_op_is(op, "+") || opt_op_is(op, "*") ||
+           opt_op_is(op, "=") || opt_op_is(op, "/=") ||
+           opt_op_is(op, "and") || opt_op_is(op, "or");
+}
+
+int opt_expr_uses(ASTNode *expr, const char *name) {
+    if (!expr) return 0;
+
+    switch (expr->type) {
+        case AST_IDENTIFIER:
+            return strcmp(expr->data.identifier.name, name) == 0;
+        case AST_BINARY_OP:
+            return opt_expr_uses(expr->data.binary_op.left, name) ||
+                   opt_expr_uses(expr->data.binary_op.right, name);
+        case AST_UNARY_OP:
+            return opt_expr_uses(expr->data.unary_op.operand, name);
+        default:
+            return 0;
+    }
+}
+
+// Verdadeiro se avaliar a expressão pode abortar o programa: + e - checados
+// (add/sub levantam exceção no overflow, a menos que o vrp tenha marcado a
+// operação unchecked), o - unário de algo que não é literal (neg com o menor
+// inteiro) e a divisão por um divisor que não é uma constante diferente de zero
+int opt_expr_may_trap(ASTNode *expr) {
+    if (!expr) return 0;
+
+    switch (expr->type) {
+        case AST_BINARY_OP: {
+            const char *op = expr->data.binary_op.operator;
+            ASTNode *right = expr->data.binary_op.right;
+            if ((opt_op_is(op, "+") || opt_op_is(op, "-")) && !expr->data.binary_op.unchecked) {
+                return 1;
+            }
+            if (opt_op_is(op, "/") &&
+                !(right->type == AST_INTEGER && right->data.integer.value != 0)) {
+                return 1;
+            }
+            return opt_expr_may_trap(expr->data.binary_op.left) ||
+                   opt_expr_may_trap(right);
+        }
+        case AST_UNARY_OP:
+            if (opt_op_is(expr->data.unary_op.operator, "-") &&
+                expr->data.unary_op.operand->type != AST_INTEGER) {
+                return 1;
+            }
+            return opt_expr_may_trap(expr->data.unary_op.operand);
+        default:
+            return 0;
+    }
+}
+
+// Verdadeiro se o statement (ou algo aninhado nele) lê a variável
+int opt_stmt_reads(ASTNode *stmt, const char *name) {
+    if (!stmt) return 0;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                if (opt_stmt_reads(stmt->data.block.statements[i], name)) return 1;
+            }
+            return 0;
+        case AST_ASSIGNMENT:
+            return opt_expr_uses(stmt->data.assignment.expression, name);
+        case AST_PUT_LINE:
+            return opt_expr_uses(stmt->data.put_line.expression, name);
+        case AST_IF_STATEMENT:
+            return opt_expr_uses(stmt->data.if_stmt.condition, name) ||
+                   opt_stmt_reads(stmt->data.if_stmt.then_block, name) ||
+                   opt_stmt_reads(stmt->data.if_stmt.else_block, name);
+        case AST_WHILE_STATEMENT:
+            return opt_expr_uses(stmt->data.while_stmt.condition, name) ||
+                   opt_stmt_reads(stmt->data.while_stmt.body, name);
+        default:
+            return opt_expr_uses(stmt, name);
+    }
+}
+
+typedef enum {
+    LIVE_NOT_FOUND,
+    LIVE_YES,
+    LIVE_NO,
+    LIVE_UNDECIDED   // Chegou ao fim do bloco sem decidir
+} Liveness;
+
+// Examina os statements a partir de 'from' até decidir se o valor atual
+// da variável ainda pode ser lido
+static Liveness scan_liveness(ASTNode *block, int from, const char *name) {
+    for (int i = from; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+
+        if (stmt->type == AST_ASSIGNMENT &&
+            strcmp(stmt->data.assignment.identifier, name) == 0) {
+            return opt_expr_uses(stmt->data.assignment.expression, name) ? LIVE_YES : LIVE_NO;
+        }
+        if (stmt->type == AST_GET_LINE &&
+            strcmp(stmt->data.get_line.identifier, name) == 0) {
+            return LIVE_NO;
+        }
+        if (opt_stmt_reads(stmt, name)) {
+            return LIVE_YES;
+        }
+    }
+    return LIVE_UNDECIDED;
+}
+
+static Liveness liveness_in_block(ASTNode *block, ASTNode *target, const char *name) {
+    if (!block) return LIVE_NOT_FOUND;
+
+    for (int i = 0; i < block->data.block.count; i++) {
+        ASTNode *stmt = block->data.block.statements[i];
+        Liveness inner = LIVE_NOT_FOUND;
+
+        if (stmt == target) {
+            inner = LIVE_UNDECIDED;
+        } else if (stmt->type == AST_IF_STATEMENT) {
+            inner = liveness_in_block(stmt->data.if_stmt.then_block, target, name);
+            if (inner == LIVE_NOT_FOUND) {
+                inner = liveness_in_block(stmt->data.if_stmt.else_block, target, name);
+            }
+        } else if (stmt->type == AST_WHILE_STATEMENT) {
+            inner = liveness_in_block(stmt->data.while_stmt.body, target, name);
+            // A próxima iteração pode ler a variável antes de escrevê-la
+            if (inner == LIVE_UNDECIDED && opt_stmt_reads(stmt, name)) {
+                inner = LIVE_YES;
+            }
+        }
+
+        if (inner == LIVE_NOT_FOUND) continue;
+        if (inner != LIVE_UNDECIDED) return inner;
+        return scan_liveness(block, i + 1, name);
+    }
+    return LIVE_NOT_FOUND;
+}
+
+// Verdadeiro se o valor da variável depois de stmt ainda pode ser lido.
+// Conservador: na dúvida, considera a variável viva.
+int opt_var_live_after(ASTNode *root_block, ASTNode *stmt, const char *name) {
+    Liveness result = liveness_in_block(root_block, stmt, name);
+    // Fim do procedimento: nada mais lê a variável
+    return result == LIVE_YES || result == LIVE_NOT_FOUND;
+}
+
+// Atribuição "name := <inteiro>" que define o valor da variável
+// imediatamente antes de stmt, procurando para trás no mesmo bloco
+ASTNode* opt_reaching_constant(ASTNode *block, ASTNode *stmt, const char *name) {
+    int index = ast_block_index_of(block, stmt);
+
+    for (int i = index - 1; i >= 0; i--) {
+        ASTNode *prev = block->data.block.statements[i];
+
+        if (prev->type == AST_ASSIGNMENT &&
+            strcmp(prev->data.assignment.identifier, name) == 0) {
+            return prev->data.assignment.expression->type == AST_INTEGER ? prev : NULL;
+        }
+
+        NameSet written;
+        name_set_init(&written);
+        opt_collect_assigned(prev, &written);
+        int touched = name_set_contains(&written, name);
+        name_set_free(&written);
+        if (touched) return NULL;
+    }
+    return NULL;
+}
+
+// Tamanho de um trecho do AST em nós (estimativa do código gerado)
+int opt_node_count(ASTNode *node) {
+    if (!node) return 0;
+
+    switch (node->type) {
+        case AST_BLOCK: {
+            int total = 1;
+            for (int i = 0; i < node->data.block.count; i++) {
+                total += opt_node_count(node->data.block.statements[i]);
+            }
+            return total;
+        }
+        case AST_ASSIGNMENT:
+            return 1 + opt_node_count(node->data.assignment.expression);
+        case AST_PUT_LINE:
+            return 1 + opt_node_count(node->data.put_line.expression);
+        case AST_IF_STATEMENT:
+            return 1 + opt_node_count(node->data.if_stmt.condition) +
+                   opt_node_count(node->data.if_stmt.then_block) +
+                   opt_node_count(node->data.if_stmt.else_block);
+        case AST_WHILE_STATEMENT:
+            return 1 + opt_node_count(node->data.while_stmt.condition) +
+                   opt_node_count(node->data.while_stmt.body);
+        case AST_BINARY_OP:
+            return 1 + opt_node_count(node->data.binary_op.left) +
+                   opt_node_count(node->data.binary_op.right);
+        case AST_UNARY_OP:
+            return 1 + opt_node_count(node->data.unary_op.operand);
+        default:
+            return 1;
+    }
+}
+
+static int is_identifier(ASTNode *expr, const char *name) {
+    return expr->type == AST_IDENTIFIER && strcmp(expr->data.identifier.name, name) == 0;
+}
+
+// Reconhece "i := i + c", "i := c + i" e "i := i - c" com c literal não nulo;
+// step recebe c (negativo na subtração)
+int opt_match_increment(ASTNode *stmt, long long *step) {
+    if (stmt->type != AST_ASSIGNMENT) return 0;
+
+    const char *name = stmt->data.assignment.identifier;
+    ASTNode *expr = stmt->data.assignment.expression;
+    if (expr->type != AST_BINARY_OP) return 0;
+
+    ASTNode *left = expr->data.binary_op.left;
+    ASTNode *right = expr->data.binary_op.right;
+
+    if (opt_op_is(expr->data.binary_op.operator, "+")) {
+        if (is_identifier(left, name) && right->type == AST_INTEGER) {
+            *step = right->data.integer.value;
+        } else if (is_identifier(right, name) && left->type == AST_INTEGER) {
+            *step = left->data.integer.value;
+        } else {
+            return 0;
+        }
+    } else if (opt_op_is(expr->data.binary_op.operator, "-")) {
+        if (!is_identifier(left, name) || right->type != AST_INTEGER) return 0;
+        *step = -(long long)right->data.integer.value;
+    } else {
+        return 0;
+    }
+    return *step != 0;
+}
+
+// Relação equivalente com os operandos trocados (NULL se não for < <= > >=)
+const char* opt_flip_relation(const char *op) {
+    if (strcmp(op, "<") == 0) return ">";
+    if (strcmp(op, "<=") == 0) return ">=";
+    if (strcmp(op, ">") == 0) return "<";
+    if (strcmp(op, ">=") == 0) return "<=";
+    return NULL;
+}
+
+// Reconhece a condição "name REL N" (ou "N REL name") com N literal,
+// normalizada com a variável à esquerda
+int opt_match_bound_test(ASTNode *cond, const char *name, const char **rel, long long *bound) {
+    if (cond->type != AST_BINARY_OP) return 0;
+
+    const char *op = cond->data.binary_op.operator;
+    ASTNode *left = cond->data.binary_op.left;
+    ASTNode *right = cond->data.binary_op.right;
+    if (!opt_flip_relation(op)) return 0;
+
+    if (is_identifier(left, name) && right->type == AST_INTEGER) {
+        *rel = op;
+        *bound = right->data.integer.value;
+    } else if (is_identifier(right, name) && left->type == AST_INTEGER) {
+        *rel = opt_flip_relation(op);
+        *bound = left->data.integer.value;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// Coleta as variáveis escritas (atribuição ou Get_Line) em um statement
+void opt_collect_assigned(ASTNode *stmt, NameSet *set) {
+    if (!stmt) return;
+
+    switch (stmt->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                opt_collect_assigned(stmt->data.block.statements[i], set);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            name_set_add(set, stmt->data.assignment.identifier);
+            break;
+        case AST_GET_LINE:
+            name_set_add(set, stmt->data.get_line.identifier);
+            break;
+        case AST_IF_STATEMENT:
+            opt_collect_assigned(stmt->data.if_stmt.then_block, set);
+            opt_collect_assigned(stmt->data.if_stmt.else_block, set);
+            break;
+        case AST_WHILE_STATEMENT:
+            opt_collect_assigned(stmt->data.while_stmt.body, set);
+            break;
+        default:
+            break;
+    }
+}
+
+// Quantos statements escrevem a variável (atribuição ou Get_Line)
+int opt_count_writes(ASTNode *stmt, const char *name) {
+    if (!stmt) return 0;
+
+    switch (stmt->type) {
+        case AST_BLOCK: {
+            int total = 0;
+            for (int i = 0; i < stmt->data.block.count; i++) {
+                total += opt_count_writes(stmt->data.block.statements[i], name);
+            }
+            return total;
+        }
+        case AST_ASSIGNMENT:
+            return strcmp(stmt->data.assignment.identifier, name) == 0;
+        case AST_GET_LINE:
+            return strcmp(stmt->data.get_line.identifier, name) == 0;
+        case AST_IF_STATEMENT:
+            return opt_count_writes(stmt->data.if_stmt.then_block, name) +
+                   opt_count_writes(stmt->data.if_stmt.else_block, name);
+        case AST_WHILE_STATEMENT:
+            return opt_count_writes(stmt->data.while_stmt.body, name);
+        default:
+            return 0;
+    }
+}
+
+int opt_fits_int32(long long value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+void name_set_init(NameSet *set) {
+    set->names = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+void name_set_free(NameSet *set) {
+    for (int i = 0; i < set->count; i++) {
+        free(set->names[i]);
+    }
+    free(set->names);
+    name_set_init(set);
+}
+
+void name_set_add(NameSet *set, const char *name) {
+    if (name_set_contains(set, name)) return;
+
+    if (set->count >= set->capacity) {
+        set->capacity = set->capacity ? set->capacity * 2 : 8;
+        set->names = (char**)realloc(set->names, set->capacity * sizeof(char*));
+    }
+    set->names[set->count++] = strdup(name);
+}
+
+int name_set_contains(const NameSet *set, const char *name) {
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->names[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Troca o statement da posição index pelos statements do braço (que pode ser
+// nulo, caso em que o statement só é removido)
+void opt_splice_arm(ASTNode *parent, int index, ASTNode *arm) {
+    ASTNode *stmt = ast_block_remove(parent, index);
+
+    if (arm) {
+        for (int i = 0; i < arm->data.block.count; i++) {
+            ast_block_insert(parent, index + i, arm->data.block.statements[i]);
+        }
+        arm->data.block.count = 0;
+    }
+    ast_free(stmt);
+}
@@ -0,0 +1,94 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Orçamento padrão de -fpartial-eval (passos do avaliador)
+#define PEVAL_DEFAULT_BUDGET 1000000
+
+// Cache de -fsuperopt sem nome de arquivo
+#define SUPEROPT_DEFAULT_CACHE "superopt.cache"
+
+// Opções de otimização (definidas pela linha de comando)
+typedef struct {
+    int level;          // 0 = sem otimização, 1 = padrão, 2 = agressivo
+    int unroll_factor;  // Cópias do corpo no desenrolamento parcial (< 2 desliga)
+    long long peval_budget; // Passos da avaliação parcial (0 desliga)
+    int profile_generate;           // -fprofile-generate: instrumenta os blocos
+    long long *profile_counts;      // -fprofile-use: contagens por bloco (NULL sem perfil)
+    int profile_size;               // Entradas em profile_counts
+    int profile_blocks;             // Blocos numerados no programa
+    const char *superopt_cache;     // -fsuperopt: cache de reescritas (NULL desliga)
+    int delayed_branch;             // -fdelayed-branch: .set noreorder com delay slots preenchidos
+} OptimizerOptions;
+
+// Contexto compartilhado pelos passes
+typedef struct {
+    SymbolTable *symbol_table;      // Escopo do procedimento (recebe os temporários)
+    const OptimizerOptions *options;
+    int temp_counter;
+    int changes;                    // Transformações feitas pelo passe atual
+} OptContext;
+
+// Um passe transforma o AST do programa no lugar
+typedef void (*OptPassFn)(ASTNode *program, OptContext *ctx);
+
+typedef struct {
+    const char *name;
+    OptPassFn run;
+    int min_level;  // Nível mínimo em que o passe roda no pipeline padrão
+} OptPass;
+
+// Conjunto simples de nomes de variáveis
+typedef struct {
+    char **names;
+    int count;
+    int capacity;
+} NameSet;
+
+// Protótipos das funções
+void optimizer_options_init(OptimizerOptions *options);
+void optimizer_options_free(OptimizerOptions *options);
+int optimizer_load_profile(OptimizerOptions *options, const char *path);
+void optimizer_prepare_profile(ASTNode *program, OptimizerOptions *options);
+void optimizer_run(ASTNode *program, SymbolTable *table, const OptimizerOptions *options);
+const OptPass* optimizer_passes(int *count);
+const OptPass* optimizer_find_pass(const char *name);
+
+// Passes
+void opt_peval(ASTNode *program, OptContext *ctx);
+void opt_thread(ASTNode *program, OptContext *ctx);
+void opt_algebra(ASTNode *program, OptContext *ctx);
+void opt_gvn(ASTNode *program, OptContext *ctx);
+void opt_licm(ASTNode *program, OptContext *ctx);
+void opt_iv(ASTNode *program, OptContext *ctx);
+void opt_unroll(ASTNode *program, OptContext *ctx);
+void opt_vrp(ASTNode *program, OptContext *ctx);
+
+// Auxiliares compartilhados pelos passes
+ASTNode* opt_procedure_block(ASTNode *program);
+const char* opt_new_temp(OptContext *ctx, const char *prefix, SymbolType type);
+void opt_make_identifier(ASTNode *node, const char *name);
+int opt_op_is(const char *op, const char *name);
+int opt_is_commutative(const char *op);
+int opt_expr_uses(ASTNode *expr, const char *name);
+int opt_expr_may_trap(ASTNode *expr);
+int opt_stmt_reads(ASTNode *stmt, const char *name);
+int opt_var_live_after(ASTNode *root_block, ASTNode *stmt, const char *name);
+int opt_node_count(ASTNode *node);
+int opt_match_increment(ASTNode *stmt, long long *step);
+const char* opt_flip_relation(const char *op);
+int opt_match_bound_test(ASTNode *cond, const char *name, const char **rel, long long *bound);
+ASTNode* opt_reaching_constant(ASTNode *block, ASTNode *stmt, const char *name);
+void opt_collect_assigned(ASTNode *stmt, NameSet *set);
+int opt_count_writes(ASTNode *stmt, const char *name);
+int opt_fits_int32(long long value);
+void opt_splice_arm(ASTNode *parent, int index, ASTNode *arm);
+
+void name_set_init(NameSet *set);
+void name_set_free(NameSet *set);
+void name_set_add(NameSet *set, const char *name);
+int name_set_contains(const NameSet *set, const char *name);
+
+#endif
@@ -78,6 +78,10 @@ static ASTNode* parse_primary(Parser *parser) {
         advance(parser);
         ASTNode *expr = parse_expression(parser);
         expect(parser, TOKEN_RPAREN);
+        // A associação imposta pelos parênteses é preservada (Ada RM 4.5(13))
+        if (expr && expr->type == AST_BINARY_OP) {
+            expr->data.binary_op.parenthesized = 1;
+        }
         return expr;
     }
 
@@ -2,48 +2,86 @@
 #include "register_alloc.h"
 #include <stdio.h>
 
+#define PHYSICAL_COUNT 10
+
+// Profundidade máxima de laço considerada no custo de spill
+#define MAX_LOOP_DEPTH 6
+
+static const char *physical_names[PHYSICAL_COUNT] = {
+    "$t0", "$t1", "$t2", "$t3", "$t4",
+    "$t5", "$t6", "$t7", "$t8", "$t9"
+};
+
 RegisterAllocator* reg_alloc_create() {
     RegisterAllocator *alloc = (RegisterAllocator*)malloc(sizeof(RegisterAllocator));
-    
+
     // Inicializar todos os registradores como disponíveis
-    for (int i = 0; i < 10; i++) {
+    for (int i = 0; i < PHYSICAL_COUNT; i++) {
         alloc->available[i] = 1;
     }
-    
+
     alloc->stack_offset = 0;
+    alloc->virtual_mode = 0;
+    alloc->virtual_names = NULL;
+    alloc->spill_level = NULL;
+    alloc->virtual_count = 0;
+    alloc->virtual_capacity = 0;
     return alloc;
 }
 
 void reg_alloc_free(RegisterAllocator *alloc) {
     if (alloc) {
+        for (int i = 0; i < alloc->virtual_count; i++) {
+            free(alloc->virtual_names[i]);
+        }
+        free(alloc->virtual_names);
+        free(alloc->spill_level);
         free(alloc);
     }
 }
 
+void reg_alloc_set_virtual(RegisterAllocator *alloc) {
+    alloc->virtual_mode = 1;
+}
+
+static int new_virtual(RegisterAllocator *alloc, int spill_level) {
+    if (alloc->virtual_count == alloc->virtual_capacity) {
+        alloc->virtual_capacity = alloc->virtual_capacity ? alloc->virtual_capacity * 2 : 64;
+        alloc->virtual_names = (char**)realloc(alloc->virtual_names, alloc->virtual_capacity * sizeof(char*));
+        alloc->spill_level = (char*)realloc(alloc->spill_level, alloc->virtual_capacity);
+    }
+
+    int id = alloc->virtual_count++;
+    char name[16];
+    snprintf(name, sizeof(name), "%%%d", id);
+    alloc->virtual_names[id] = strdup(name);
+    alloc->spill_level[id] = (char)spill_level;
+    return id;
+}
+
 const char* reg_alloc_acquire(RegisterAllocator *alloc) {
+    // Virtuais não acabam: quem decide o registrador é reg_alloc_assign
+    if (alloc->virtual_mode) {
+        int id = new_virtual(alloc, 0);
+        return alloc->virtual_names[id];
+    }
+
     // Procurar primeiro registrador disponível
-    for (int i = 0; i < 10; i++) {
+    for (int i = 0; i < PHYSICAL_COUNT; i++) {
         if (alloc->available[i]) {
             alloc->available[i] = 0;
-            
-            // Retornar nome do registrador
-            static char reg_names[10][4] = {
-                "$t0", "$t1", "$t2", "$t3", "$t4",
-                "$t5", "$t6", "$t7", "$t8", "$t9"
-            };
-            return reg_names[i];
-        }
-    }
-    
-    // Se não houver registrador disponível, reportar erro
-    // Uma implementação completa implementaria register spilling
+            return physical_names[i];
+        }
+    }
+
+    // Em -O0 não há spill: a expressão precisa caber em $t0-$t9
     fprintf(stderr, "Error: No available registers - expression too complex\n");
-    fprintf(stderr, "       Simplify your expressions or implement register spilling\n");
+    fprintf(stderr, "       Simplify your expressions or compile with -O1 or above\n");
     return NULL;
 }
 
 void reg_alloc_release(RegisterAllocator *alloc, const char *reg) {
-    // Mapear nome do registrador para índice
+    // Mapear nome do registrador para índice (virtuais são ignorados)
     if (reg && reg[0] == '$' && reg[1] == 't') {
         int index = reg[2] - '0';
         if (index >= 0 && index <= 9) {
@@ -57,3 +95,481 @@ int reg_alloc_get_stack_offset(RegisterAllocator *alloc) {
     alloc->stack_offset += 4;
     return offset;
 }
+
+// Alocação por varredura linear (-O1 e acima).
+//
+// A vivacidade dos virtuais é calculada instrução a instrução sobre o grafo
+// de fluxo do texto (sucessores: a linha seguinte e o alvo do desvio). O
+// intervalo de um virtual vai da primeira à última linha em que ele está
+// vivo ou aparece; num laço isso cobre o laço inteiro. Os intervalos são
+// percorridos por início, com $t0-$t9 livres ou presos aos intervalos
+// ativos. Um intervalo que termina lendo o virtual na mesma linha em que
+// outro começa sendo escrito cede o registrador ("addu $t0, $t0, $t1").
+//
+// Sem registrador livre, sai o intervalo de menor custo entre os ativos e o
+// atual: usos ponderados por 8^profundidade de laço, divididos pelo
+// comprimento. Constantes (um único li/la) custam a metade e, em vez de ir
+// para a memória, são recalculadas antes de cada uso. Os demais ganham um
+// slot no frame, com lw antes de cada uso e sw depois de cada escrita em
+// virtuais novos e curtos, que não podem sair de novo; a varredura se repete
+// até não haver spill.
+
+typedef struct {
+    AsmBuffer *buf;
+    int count;              // Virtuais
+    int words;              // Palavras por conjunto
+    unsigned int *in;       // Vivos na entrada de cada linha
+    unsigned int *out;      // Vivos na saída de cada linha
+    int *target;            // Linha do alvo do desvio (-1 se não há)
+    int *start;             // Intervalo [start, end] (-1 se o virtual não aparece)
+    int *end;
+    double *cost;           // Custo de spill
+    int *def_count;
+    int *def_line;
+} Liveness;
+
+static int virtual_of(const char *arg) {
+    const char *p = strchr(arg, '(');
+    p = p ? p + 1 : arg;
+    return *p == '%' ? atoi(p + 1) : -1;
+}
+
+static int has_bit(const unsigned int *set, int v) {
+    return (set[v / 32] >> (v % 32)) & 1;
+}
+
+static void set_bit(unsigned int *set, int v) {
+    set[v / 32] |= 1u << (v % 32);
+}
+
+static void liveness_compute(Liveness *lv, AsmBuffer *buf, int count) {
+    int n = buf->count;
+    lv->buf = buf;
+    lv->count = count;
+    lv->words = (count + 31) / 32;
+    if (lv->words == 0) lv->words = 1;
+    lv->in = (unsigned int*)calloc((size_t)n * lv->words, sizeof(unsigned int));
+    lv->out = (unsigned int*)calloc((size_t)n * lv->words, sizeof(unsigned int));
+    lv->target = (int*)malloc(n * sizeof(int));
+    lv->start = (int*)malloc(count * sizeof(int));
+    lv->end = (int*)malloc(count * sizeof(int));
+    lv->cost = (double*)calloc(count, sizeof(double));
+    lv->def_count = (int*)calloc(count, sizeof(int));
+    lv->def_line = (int*)malloc(count * sizeof(int));
+
+    for (int i = 0; i < n; i++) {
+        AsmLine *line = &buf->lines[i];
+        lv->target[i] = asm_is_branch(line) ? asm_find_label(buf, asm_branch_target(line)) : -1;
+    }
+
+    // Ponto fixo, de trás para frente
+    int W = lv->words;
+    unsigned int *row = (unsigned int*)malloc(W * sizeof(unsigned int));
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = n - 1; i >= 0; i--) {
+            AsmLine *line = &buf->lines[i];
+            unsigned int *out = lv->out + (size_t)i * W;
+            int falls = !asm_is_jump(line) && i + 1 < n;
+            for (int w = 0; w < W; w++) {
+                unsigned int live = falls ? lv->in[(size_t)(i + 1) * W + w] : 0;
+                if (lv->target[i] >= 0) live |= lv->in[(size_t)lv->target[i] * W + w];
+                out[w] = live;
+                row[w] = live;
+            }
+
+            // in = usos + (out - escritas)
+            for (int k = 0; k < line->arg_count; k++) {
+                int v = virtual_of(line->args[k]);
+                if (v >= 0 && asm_operand_role(line, k) == ASM_DEF) row[v / 32] &= ~(1u << (v % 32));
+            }
+            for (int k = 0; k < line->arg_count; k++) {
+                int v = virtual_of(line->args[k]);
+                if (v >= 0 && (asm_operand_role(line, k) & ASM_USE)) set_bit(row, v);
+            }
+
+            unsigned int *in = lv->in + (size_t)i * W;
+            if (memcmp(in, row, W * sizeof(unsigned int)) != 0) {
+                memcpy(in, row, W * sizeof(unsigned int));
+                changed = 1;
+            }
+        }
+    }
+    free(row);
+
+    // Profundidade de laço: cada desvio para trás fecha um laço
+    int *depth = (int*)calloc(n, sizeof(int));
+    for (int j = 0; j < n; j++) {
+        int t = lv->target[j];
+        if (t >= 0 && t <= j) {
+            for (int i = t; i <= j; i++) depth[i]++;
+        }
+    }
+
+    // Intervalos e custos
+    for (int v = 0; v < count; v++) {
+        lv->start[v] = -1;
+        lv->end[v] = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        const unsigned int *in = lv->in + (size_t)i * W;
+        const unsigned int *out = lv->out + (size_t)i * W;
+        for (int w = 0; w < W; w++) {
+            unsigned int live = in[w] | out[w];
+            while (live) {
+                int b = __builtin_ctz(live);
+                int v = w * 32 + b;
+                if (lv->start[v] < 0) lv->start[v] = i;
+                lv->end[v] = i;
+                live &= live - 1;
+            }
+        }
+
+        AsmLine *line = &buf->lines[i];
+        double weight = 1;
+        for (int d = 0; d < depth[i] && d < MAX_LOOP_DEPTH; d++) weight *= 8;
+        for (int k = 0; k < line->arg_count; k++) {
+            int v = virtual_of(line->args[k]);
+            if (v < 0) continue;
+            if (lv->start[v] < 0) lv->start[v] = i;
+            if (lv->end[v] < i) lv->end[v] = i;
+            lv->cost[v] += weight;
+            if (asm_operand_role(line, k) & ASM_DEF) {
+                lv->def_count[v]++;
+                lv->def_line[v] = i;
+            }
+        }
+    }
+    free(depth);
+}
+
+static void liveness_free(Liveness *lv) {
+    free(lv->in);
+    free(lv->out);
+    free(lv->target);
+    free(lv->start);
+    free(lv->end);
+    free(lv->cost);
+    free(lv->def_count);
+    free(lv->def_line);
+}
+
+// Virtual escrito uma única vez, por li ou la: pode ser recalculado
+static int is_rematerializable(Liveness *lv, int v) {
+    if (lv->def_count[v] != 1) return 0;
+    AsmLine *def = &lv->buf->lines[lv->def_line[v]];
+    return (strcmp(def->op, "li") == 0 || strcmp(def->op, "la") == 0) && def->arg_count == 2;
+}
+
+static double spill_cost(Liveness *lv, int v) {
+    double cost = lv->cost[v] / (lv->end[v] - lv->start[v] + 1);
+    return is_rematerializable(lv, v) ? cost / 2 : cost;
+}
+
+// Virtual que começa na linha sendo escrito (não está vivo na entrada)
+static int defined_at_start(Liveness *lv, int v) {
+    return !has_bit(lv->in + (size_t)lv->start[v] * lv->words, v);
+}
+
+static Liveness *sort_liveness;
+
+// Por início; no mesmo início, os que já chegam vivos vêm antes do que é
+// escrito ali, para não receberem o registrador de um intervalo que termina
+static int compare_start(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    if (sort_liveness->start[x] != sort_liveness->start[y]) {
+        return sort_liveness->start[x] - sort_liveness->start[y];
+    }
+    return defined_at_start(sort_liveness, x) - defined_at_start(sort_liveness, y);
+}
+
+// Varredura linear; marca em spill os virtuais que ficam sem registrador.
+// Retorna o número de spills, ou -1 se nenhum intervalo pode sair
+static int linear_scan(RegisterAllocator *alloc, Liveness *lv, int *phys, char *spill) {
+    int *order = (int*)malloc(lv->count * sizeof(int));
+    int *active = (int*)malloc(PHYSICAL_COUNT * sizeof(int));
+    int order_count = 0, active_count = 0, spills = 0;
+    int free_regs[PHYSICAL_COUNT];
+
+    for (int v = 0; v < lv->count; v++) {
+        phys[v] = -1;
+        spill[v] = 0;
+        if (lv->start[v] >= 0) order[order_count++] = v;
+    }
+    for (int r = 0; r < PHYSICAL_COUNT; r++) free_regs[r] = 1;
+
+    sort_liveness = lv;
+    qsort(order, order_count, sizeof(int), compare_start);
+
+    for (int k = 0; k < order_count; k++) {
+        int cur = order[k];
+        int p = lv->start[cur];
+        int defined_here = defined_at_start(lv, cur);
+        const unsigned int *out = lv->out + (size_t)p * lv->words;
+
+        // Libera os intervalos encerrados
+        for (int a = 0; a < active_count; ) {
+            int v = active[a];
+            if (lv->end[v] < p || (lv->end[v] == p && defined_here && !has_bit(out, v))) {
+                free_regs[phys[v]] = 1;
+                active[a] = active[--active_count];
+            } else {
+                a++;
+            }
+        }
+
+        int reg = -1;
+        for (int r = 0; r < PHYSICAL_COUNT && reg < 0; r++) {
+            if (free_regs[r]) reg = r;
+        }
+        if (reg >= 0) {
+            free_regs[reg] = 0;
+            phys[cur] = reg;
+            active[active_count++] = cur;
+            continue;
+        }
+
+        // Sem registrador: sai o de menor custo (no empate, o que vive mais)
+        int victim = -1, slot = -1;
+        for (int a = -1; a < active_count; a++) {
+            int v = a < 0 ? cur : active[a];
+            if (alloc->spill_level[v] == 2) continue;
+            if (victim < 0 || spill_cost(lv, v) < spill_cost(lv, victim) ||
+                (spill_cost(lv, v) == spill_cost(lv, victim) && lv->end[v] > lv->end[victim])) {
+                victim = v;
+                slot = a;
+            }
+        }
+        if (victim < 0) {
+            free(order);
+            free(active);
+            return -1;
+        }
+
+        spill[victim] = 1;
+        spills++;
+        if (victim != cur) {
+            phys[cur] = phys[victim];
+            active[slot] = cur;
+        }
+    }
+
+    free(order);
+    free(active);
+    return spills;
+}
+
+// Troca o virtual 'v' de um operando pelo nome dado, inclusive em "off(%v)"
+static void replace_operand(char *arg, int v, const char *name) {
+    if (virtual_of(arg) != v) return;
+    char *open = strchr(arg, '(');
+    if (open) {
+        snprintf(open + 1, ASM_ARG_SIZE - (open + 1 - arg), "%s)", name);
+    } else {
+        snprintf(arg, ASM_ARG_SIZE, "%s", name);
+    }
+}
+
+static void rewrite_line(AsmLine *line, char args[ASM_MAX_ARGS][ASM_ARG_SIZE]) {
+    const char *list[ASM_MAX_ARGS];
+    char op[sizeof(line->op)];
+    strcpy(op, line->op);
+    for (int k = 0; k < line->arg_count; k++) list[k] = args[k];
+    asm_set_instruction(line, op, line->arg_count, list);
+}
+
+// Cópia de um virtual em spill: o valor fica num virtual novo enquanto os
+// usos estão próximos (até SPILL_CHAIN_GAP linhas, no mesmo bloco básico)
+typedef struct {
+    int fresh;          // Virtual com o valor atual (-1 se não há)
+    int last;           // Última linha que o mencionou
+    int store;          // Posição do sw pendente na saída (-1 se não há)
+} SpillChain;
+
+#define SPILL_CHAIN_GAP 4
+
+static void push_text(char ***out, int *count, int *capacity, char *text) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+        *out = (char**)realloc(*out, *capacity * sizeof(char*));
+    }
+    (*out)[(*count)++] = text;
+}
+
+// Reescreve o texto com recargas, gravações e recálculos para os virtuais em
+// spill. Usos seguidos do mesmo virtual compartilham uma cópia: só o
+// primeiro recarrega, e só a última escrita da sequência é gravada (e nem
+// ela, se o valor morre ali)
+static void insert_spill_code(RegisterAllocator *alloc, Liveness *lv, const char *spill,
+                              int spill_base, RegAllocStats *stats) {
+    AsmBuffer *buf = lv->buf;
+    int count = lv->count;
+    int *slot = (int*)malloc(count * sizeof(int));
+    char (*remat)[2 * ASM_ARG_SIZE] = malloc(count * sizeof(*remat));
+    SpillChain *chain = (SpillChain*)malloc(count * sizeof(SpillChain));
+
+    for (int v = 0; v < count; v++) {
+        slot[v] = -1;
+        chain[v].fresh = -1;
+        chain[v].store = -1;
+        if (!spill[v]) continue;
+        if (is_rematerializable(lv, v)) {
+            AsmLine *def = &buf->lines[lv->def_line[v]];
+            snprintf(remat[v], sizeof(remat[v]), "    %s %%s, %s", def->op, def->args[1]);
+            stats->rematerialized++;
+        } else {
+            slot[v] = spill_base + reg_alloc_get_stack_offset(alloc);
+            stats->spilled++;
+        }
+    }
+
+    char **out = NULL;
+    int out_count = 0, out_capacity = 0;
+    int block_start = 0;
+
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+
+        // Rótulos e desvios encerram o bloco básico e as cópias
+        if (line->label[0] != '\0' || (i > 0 && asm_is_branch(&buf->lines[i - 1]))) {
+            block_start = i;
+        }
+        if (!asm_is_instruction(line)) {
+            push_text(&out, &out_count, &out_capacity, strdup(line->text));
+            continue;
+        }
+
+        char args[ASM_MAX_ARGS][ASM_ARG_SIZE];
+        char *after[ASM_MAX_ARGS];
+        int after_var[ASM_MAX_ARGS];
+        int after_count = 0, touched = 0, removed = 0;
+        for (int k = 0; k < line->arg_count; k++) strcpy(args[k], line->args[k]);
+
+        for (int k = 0; k < line->arg_count && !removed; k++) {
+            int v = virtual_of(line->args[k]);
+            if (v < 0 || !spill[v]) continue;
+
+            // O li/la de uma constante recalculada some
+            if (slot[v] < 0 && lv->def_line[v] == i) {
+                removed = 1;
+                break;
+            }
+
+            SpillChain *c = &chain[v];
+            int role = 0;
+            for (int j = 0; j < line->arg_count; j++) {
+                if (virtual_of(line->args[j]) == v) role |= asm_operand_role(line, j);
+            }
+
+            // Um virtual repetido na linha já foi tratado no primeiro operando
+            if (c->fresh < 0 || c->last != i) {
+                int reuse = c->fresh >= 0 && alloc->spill_level[v] == 0 &&
+                            c->last >= block_start && i - c->last <= SPILL_CHAIN_GAP;
+                if (!reuse) {
+                    c->fresh = new_virtual(alloc, alloc->spill_level[v] == 0 ? 1 : 2);
+                    c->store = -1;
+                    const char *name = alloc->virtual_names[c->fresh];
+                    char text[3 * ASM_ARG_SIZE];
+                    if (slot[v] < 0) {
+                        snprintf(text, sizeof(text), remat[v], name);
+                        push_text(&out, &out_count, &out_capacity, strdup(text));
+                    } else if (role & ASM_USE) {
+                        snprintf(text, sizeof(text), "    lw %s, %d($fp)", name, slot[v]);
+                        push_text(&out, &out_count, &out_capacity, strdup(text));
+                    }
+                }
+                c->last = i;
+
+                if ((role & ASM_DEF) && slot[v] >= 0) {
+                    // A gravação anterior da sequência fica inútil
+                    if (c->store >= 0) {
+                        free(out[c->store]);
+                        out[c->store] = NULL;
+                        c->store = -1;
+                    }
+                    if (has_bit(lv->out + (size_t)i * lv->words, v)) {
+                        char text[3 * ASM_ARG_SIZE];
+                        snprintf(text, sizeof(text), "    sw %s, %d($fp)", alloc->virtual_names[c->fresh], slot[v]);
+                        after_var[after_count] = v;
+                        after[after_count++] = strdup(text);
+                    }
+                }
+            }
+
+            replace_operand(args[k], v, alloc->virtual_names[c->fresh]);
+            touched = 1;
+        }
+
+        if (removed) continue;
+        if (touched) rewrite_line(line, args);
+        push_text(&out, &out_count, &out_capacity, strdup(line->text));
+        for (int a = 0; a < after_count; a++) {
+            chain[after_var[a]].store = out_count;
+            push_text(&out, &out_count, &out_capacity, after[a]);
+        }
+    }
+
+    // Troca o conteúdo do buffer pelo texto reescrito
+    for (int i = 0; i < buf->count; i++) free(buf->lines[i].text);
+    buf->count = 0;
+    for (int i = 0; i < out_count; i++) {
+        if (out[i]) {
+            asm_buffer_insert(buf, buf->count, out[i]);
+            free(out[i]);
+        }
+    }
+
+    free(out);
+    free(chain);
+    free(remat);
+    free(slot);
+}
+
+// Troca cada virtual pelo registrador físico escolhido
+static void rename_virtuals(AsmBuffer *buf, const int *phys) {
+    for (int i = 0; i < buf->count; i++) {
+        AsmLine *line = &buf->lines[i];
+        char args[ASM_MAX_ARGS][ASM_ARG_SIZE];
+        int touched = 0;
+        for (int k = 0; k < line->arg_count; k++) {
+            strcpy(args[k], line->args[k]);
+            int v = virtual_of(args[k]);
+            if (v >= 0) {
+                replace_operand(args[k], v, physical_names[phys[v]]);
+                touched = 1;
+            }
+        }
+        if (touched) rewrite_line(line, args);
+    }
+}
+
+int reg_alloc_assign(RegisterAllocator *alloc, AsmBuffer *buf, int spill_base, RegAllocStats *stats) {
+    stats->spilled = 0;
+    stats->rematerialized = 0;
+    stats->rounds = 0;
+
+    for (;;) {
+        stats->rounds++;
+
+        Liveness lv;
+        int count = alloc->virtual_count;
+        liveness_compute(&lv, buf, count);
+        int *phys = (int*)malloc((count ? count : 1) * sizeof(int));
+        char *spill = (char*)malloc(count ? count : 1);
+
+        int spills = linear_scan(alloc, &lv, phys, spill);
+        if (spills < 0) {
+            fprintf(stderr, "Error: No available registers\n");
+        } else if (spills == 0) {
+            rename_virtuals(buf, phys);
+        } else {
+            insert_spill_code(alloc, &lv, spill, spill_base, stats);
+        }
+
+        free(spill);
+        free(phys);
+        liveness_free(&lv);
+        if (spills <= 0) return spills;
+    }
+}
@@ -3,13 +3,31 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "mips_asm.h"
 
-// Alocador simples de registradores MIPS
+// Alocador de registradores MIPS.
+//
+// Em -O0, reg_alloc_acquire entrega $t0-$t9 diretamente (primeiro livre).
+// Com otimização o gerador pede registradores virtuais (%0, %1, ...), sem
+// limite, e reg_alloc_assign os mapeia para $t0-$t9 depois, por varredura
+// linear sobre o texto já gerado, com spill em slots do frame
 typedef struct {
     int available[10];  // $t0-$t9 disponibilidade
     int stack_offset;   // Offset atual na pilha para spill
+    int virtual_mode;   // acquire entrega registradores virtuais
+    char **virtual_names;
+    char *spill_level;  // 0: do gerador; 1: cópia de um spill (sai uma vez); 2: não sai
+    int virtual_count;
+    int virtual_capacity;
 } RegisterAllocator;
 
+// Resultado de reg_alloc_assign
+typedef struct {
+    int spilled;        // Virtuais mantidos na memória
+    int rematerialized; // Constantes recalculadas em vez de guardadas
+    int rounds;         // Rodadas de varredura até não haver spill
+} RegAllocStats;
+
 // Protótipos das funções
 RegisterAllocator* reg_alloc_create();
 void reg_alloc_free(RegisterAllocator *alloc);
@@ -17,4 +35,12 @@ const char* reg_alloc_acquire(RegisterAllocator *alloc);
 void reg_alloc_release(RegisterAllocator *alloc, const char *reg);
 int reg_alloc_get_stack_offset(RegisterAllocator *alloc);
 
+// Passa a entregar registradores virtuais
+void reg_alloc_set_virtual(RegisterAllocator *alloc);
+
+// Troca os registradores virtuais do texto por $t0-$t9. Os spills usam slots
+// a partir de spill_base($fp); o número de bytes usados fica em stack_offset.
+// Retorna 0, ou -1 se não foi possível alocar
+int reg_alloc_assign(RegisterAllocator *alloc, AsmBuffer *buf, int spill_base, RegAllocStats *stats);
+
 #endif
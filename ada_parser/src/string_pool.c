@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+#include "string_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Pool de strings literais.
+//
+// Textos iguais são a mesma entrada (busca por hash), então cada literal
+// repetido do programa custa uma só .asciiz. Na emissão, um texto que é
+// sufixo de outro não ganha cópia: seu rótulo é posto no meio do maior, que
+// é quebrado em pedaços .ascii e um .asciiz final:
+//
+//     str0: .ascii "Total:"
+//     newline: .asciiz "\n"
+//
+// Os sufixos são achados ordenando os textos lidos de trás para frente: um
+// texto é sufixo de outro se e só se, nessa ordem, é prefixo do seguinte.
+
+#define STRING_POOL_BUCKETS 64
+
+static unsigned int hash_text(const char *text) {
+    unsigned int hash = 2166136261u;     // FNV-1a
+    for (const unsigned char *p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+StringPool* string_pool_create(void) {
+    StringPool *pool = (StringPool*)malloc(sizeof(StringPool));
+    pool->entries = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->bucket_count = STRING_POOL_BUCKETS;
+    pool->buckets = (int*)malloc(pool->bucket_count * sizeof(int));
+    for (int i = 0; i < pool->bucket_count; i++) pool->buckets[i] = -1;
+    return pool;
+}
+
+void string_pool_free(StringPool *pool) {
+    if (!pool) return;
+    for (int i = 0; i < pool->count; i++) {
+        free(pool->entries[i].text);
+        free(pool->entries[i].name);
+    }
+    free(pool->entries);
+    free(pool->buckets);
+    free(pool);
+}
+
+// Dobra a tabela quando as cadeias ficam longas
+static void rehash(StringPool *pool) {
+    pool->bucket_count *= 2;
+    pool->buckets = (int*)realloc(pool->buckets, pool->bucket_count * sizeof(int));
+    for (int i = 0; i < pool->bucket_count; i++) pool->buckets[i] = -1;
+    for (int i = 0; i < pool->count; i++) {
+        unsigned int b = hash_text(pool->entries[i].text) % pool->bucket_count;
+        pool->entries[i].next = pool->buckets[b];
+        pool->buckets[b] = i;
+    }
+}
+
+int string_pool_add(StringPool *pool, const char *text) {
+    unsigned int b = hash_text(text) % pool->bucket_count;
+    for (int i = pool->buckets[b]; i >= 0; i = pool->entries[i].next) {
+        if (strcmp(pool->entries[i].text, text) == 0) return i;
+    }
+
+    if (pool->count == pool->capacity) {
+        pool->capacity = pool->capacity ? pool->capacity * 2 : 16;
+        pool->entries = (PooledString*)realloc(pool->entries, pool->capacity * sizeof(PooledString));
+    }
+
+    int id = pool->count++;
+    PooledString *entry = &pool->entries[id];
+    char label[32];
+    snprintf(label, sizeof(label), "str%d", id);
+    entry->text = strdup(text);
+    entry->length = (int)strlen(text);
+    entry->name = strdup(label);
+    entry->next = pool->buckets[b];
+    pool->buckets[b] = id;
+
+    if (pool->count > 2 * pool->bucket_count) rehash(pool);
+    return id;
+}
+
+void string_pool_set_name(StringPool *pool, int id, const char *name) {
+    free(pool->entries[id].name);
+    pool->entries[id].name = strdup(name);
+}
+
+const char* string_pool_label(StringPool *pool, int id) {
+    return pool->entries[id].name;
+}
+
+// Escreve bytes [from, to) do texto com os escapes do montador
+static void emit_escaped(FILE *output, const char *text, int from, int to) {
+    fputc('"', output);
+    for (int i = from; i < to; i++) {
+        switch (text[i]) {
+            case '\n': fputs("\\n", output); break;
+            case '\t': fputs("\\t", output); break;
+            case '"':  fputs("\\\"", output); break;
+            case '\\': fputs("\\\\", output); break;
+            default:   fputc(text[i], output); break;
+        }
+    }
+    fputc('"', output);
+}
+
+static StringPool *sort_pool;
+
+// Compara os textos lidos do fim para o começo
+static int compare_reversed(const void *a, const void *b) {
+    const PooledString *x = &sort_pool->entries[*(const int*)a];
+    const PooledString *y = &sort_pool->entries[*(const int*)b];
+    int i = x->length - 1, j = y->length - 1;
+    while (i >= 0 && j >= 0) {
+        unsigned char cx = (unsigned char)x->text[i--];
+        unsigned char cy = (unsigned char)y->text[j--];
+        if (cx != cy) return cx < cy ? -1 : 1;
+    }
+    return (i >= 0) - (j >= 0);
+}
+
+static int is_suffix(const PooledString *part, const PooledString *whole) {
+    return part->length <= whole->length &&
+           memcmp(whole->text + whole->length - part->length, part->text, part->length) == 0;
+}
+
+void string_pool_emit(StringPool *pool, FILE *output) {
+    int n = pool->count;
+    if (n == 0) return;
+
+    int *order = (int*)malloc(n * sizeof(int));
+    int *owner = (int*)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) order[i] = i;
+    sort_pool = pool;
+    qsort(order, n, sizeof(int), compare_reversed);
+
+    // O dono de um texto é o maior texto que o tem como sufixo
+    for (int i = n - 1; i >= 0; i--) {
+        int id = order[i];
+        owner[id] = id;
+        if (i + 1 < n && is_suffix(&pool->entries[id], &pool->entries[order[i + 1]])) {
+            owner[id] = owner[order[i + 1]];
+        }
+    }
+
+    // Cada dono é emitido uma vez, com os rótulos dos sufixos em ordem de
+    // posição (do texto mais longo para o mais curto)
+    int *members = (int*)malloc(n * sizeof(int));
+    for (int id = 0; id < n; id++) {
+        if (owner[id] != id) continue;
+
+        int count = 0;
+        for (int m = 0; m < n; m++) {
+            if (owner[m] != id) continue;
+            int k = count++;
+            while (k > 0 && pool->entries[members[k - 1]].length < pool->entries[m].length) {
+                members[k] = members[k - 1];
+                k--;
+            }
+            members[k] = m;
+        }
+
+        PooledString *whole = &pool->entries[id];
+        for (int k = 0; k < count; k++) {
+            int from = whole->length - pool->entries[members[k]].length;
+            int last = k + 1 == count;
+            int to = last ? whole->length : whole->length - pool->entries[members[k + 1]].length;
+            fprintf(output, "%s: %s ", pool->entries[members[k]].name, last ? ".asciiz" : ".ascii");
+            emit_escaped(output, whole->text, from, to);
+            fputc('\n', output);
+        }
+    }
+
+    free(members);
+    free(owner);
+    free(order);
+}
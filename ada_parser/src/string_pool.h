@@ -0,0 +1,37 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stdio.h>
+
+// Pool das strings da seção .data: cada texto aparece uma vez e ganha um
+// rótulo estável (strN, ou o nome dado com string_pool_set_name), que não
+// depende da ordem em que o gerador percorre o AST
+typedef struct {
+    char *text;         // Bytes do texto, sem escapes
+    int length;
+    char *name;         // Rótulo (strN ou o nome dado)
+    int next;           // Próxima entrada no mesmo balde
+} PooledString;
+
+typedef struct {
+    PooledString *entries;
+    int count;
+    int capacity;
+    int *buckets;       // Primeira entrada de cada balde (-1 se vazio)
+    int bucket_count;
+} StringPool;
+
+// Protótipos das funções
+StringPool* string_pool_create(void);
+void string_pool_free(StringPool *pool);
+
+// Id do texto no pool, inserindo se ainda não existe
+int string_pool_add(StringPool *pool, const char *text);
+void string_pool_set_name(StringPool *pool, int id, const char *name);
+const char* string_pool_label(StringPool *pool, int id);
+
+// Emite as diretivas .ascii/.asciiz; um texto que é sufixo de outro vira um
+// rótulo no meio do maior em vez de uma cópia
+void string_pool_emit(StringPool *pool, FILE *output);
+
+#endif
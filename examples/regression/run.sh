@@ -0,0 +1,45 @@
+#!/bin/sh
+# Compiles every regression program at each optimization setting and, when
+# spim is installed, runs it and compares the output with <name>.expected
+# (stdin comes from <name>.input when it exists).
+#
+# Usage: examples/regression/run.sh [compiler]
+
+COMPILER=${1:-build/ada_compiler}
+DIR=$(dirname "$0")
+OUT=${TMPDIR:-/tmp}/ada_regression.asm
+SPIM=$(command -v spim)
+failed=0
+
+if [ -z "$SPIM" ]; then
+    echo "spim not found: programs are only compiled"
+fi
+
+for program in "$DIR"/*.ada; do
+    name=${program%.ada}
+    for flags in "-O0" "-O1" "-O2" "-O2 -fdelayed-branch"; do
+        if ! $COMPILER "$program" -o "$OUT" $flags > /dev/null; then
+            echo "FAIL $(basename "$program") $flags: compilation failed"
+            failed=1
+            continue
+        fi
+        [ -n "$SPIM" ] || continue
+
+        sim_flags=""
+        case "$flags" in
+            *-fdelayed-branch*) sim_flags="-delayed_branches -delayed_loads" ;;
+        esac
+        input=/dev/null
+        [ -f "$name.input" ] && input="$name.input"
+        if "$SPIM" -quiet $sim_flags -file "$OUT" < "$input" 2>&1 | grep -v '^Loaded:' |
+                diff -q - "$name.expected" > /dev/null; then
+            echo "ok   $(basename "$program") $flags"
+        else
+            echo "FAIL $(basename "$program") $flags: output differs from $(basename "$name").expected"
+            failed=1
+        fi
+    done
+done
+
+rm -f "$OUT"
+exit $failed